@@ -16,6 +16,7 @@
 #include "terminal.h"
 #include "window.h"
 #include "wrap.h"
+#include "view.h"
 #include <limits.h>
 
 int rejectIfReadOnly(struct buffer *buf) {
@@ -38,6 +39,7 @@ int rejectIfReadOnly(struct buffer *buf) {
  * leave whatever status message lockFile posted in place. */
 
 void markBufferDirty(struct buffer *buf) {
+	buf->changes++;
 	if (buf->dirty)
 		return;
 	buf->dirty = 1;
@@ -70,10 +72,15 @@ void markBufferClean(struct buffer *buf) {
 
 /* Grow row->chars so it can hold at least `needed` bytes.  Doubling
  * from a floor of 16, jumping straight to `needed` when that is larger.
+ * A row still in the buffer's arena (charcap 0) is copied out to a
+ * heap allocation of its own; its arena bytes stay dead until the
+ * next compaction.
  */
 void rowEnsureCap(erow *row, int needed) {
 	if (needed <= row->charcap)
 		return;
+	if (row->charcap == 0 && needed <= row->size + 1)
+		return;
 	/* A row is bounded by EMIL_MAX_FILE_SIZE (1 GiB) at load, but 
 	 * nothing re-imposes that during editing, so cap the doubling
 	 * instead of overflowing into a negative capacity, which would
@@ -84,81 +91,363 @@ void rowEnsureCap(erow *row, int needed) {
 						   row->charcap * 2;
 	if (new_cap < needed)
 		new_cap = needed;
-	row->chars = xrealloc(row->chars, new_cap);
+	if (row->charcap == 0) {
+		uint8_t *chars = xmalloc(new_cap);
+		memcpy(chars, row->chars, row->size + 1);
+		row->chars = chars;
+	} else {
+		row->chars = xrealloc(row->chars, new_cap);
+	}
 	row->charcap = new_cap;
 }
 
-/* Grow the buffer's row array by one, zeroing the new slots. */
-static void bufEnsureRowCap(struct buffer *bufr) {
-	if (bufr->numrows < bufr->rowcap)
+/* ---- Row arena ----
+ *
+ * Row bytes are carved from large blocks owned by the buffer rather
+ * than allocated one row at a time, so loading a 10M-line file is a
+ * few thousand allocations instead of 10M, without the allocator's
+ * per-chunk header and rounding on every line.  A row whose bytes live
+ * here has charcap 0: it owns no allocation, and it keeps its bytes
+ * only until it needs to grow, when rowEnsureCap() moves it to the
+ * heap.  Shrinking and in-place edits keep it in the arena.
+ *
+ * Nothing is freed piecemeal.  Bytes abandoned by rows that moved out
+ * or were deleted stay dead until bufCompactRows(), which save calls,
+ * or until the row array is discarded with the blocks. */
+
+#define ROWBLOCK_SIZE (256 * 1024)
+
+struct rowblock {
+	struct rowblock *next;
+	size_t used;
+	size_t cap;
+	uint8_t bytes[];
+};
+
+static struct rowblock *newRowBlock(size_t cap, struct rowblock *next) {
+	struct rowblock *blk = xmalloc(sizeof(struct rowblock) + cap);
+	blk->next = next;
+	blk->used = 0;
+	blk->cap = cap;
+	return blk;
+}
+
+static void freeRowBlocks(struct rowblock *blk) {
+	while (blk) {
+		struct rowblock *next = blk->next;
+		free(blk);
+		blk = next;
+	}
+}
+
+/* Give `row` n bytes.  Rows too long to pack well, more than a quarter
+ * of a block, get their own allocation; so does the remainder when the
+ * current block is full, since the tail left behind is then under a
+ * quarter block. */
+static void rowAlloc(struct buffer *bufr, erow *row, size_t n) {
+	if (n > ROWBLOCK_SIZE / 4) {
+		row->chars = xmalloc(n);
+		row->charcap = n;
+		return;
+	}
+	struct rowblock *blk = bufr->rowarena;
+	if (blk == NULL || blk->cap - blk->used < n)
+		blk = bufr->rowarena = newRowBlock(ROWBLOCK_SIZE, blk);
+	row->chars = blk->bytes + blk->used;
+	row->charcap = 0;
+	blk->used += n;
+}
+
+/* Pack every row back into the arena, releasing the bytes of deleted
+ * and moved-out rows.  Skipped when under an eighth of what the rows
+ * hold is wasted; the heap rows are then only trimmed to size, which
+ * is all save used to do.  Row pointers stay valid, their chars do
+ * not. */
+void bufCompactRows(struct buffer *bufr) {
+	size_t live = 0, held = 0;
+	for (struct rowblock *blk = bufr->rowarena; blk; blk = blk->next)
+		held += blk->used;
+	for (int i = 0; i < bufr->numrows; i++) {
+		erow *row = bufRow(bufr, i);
+		live += row->size + 1;
+		held += row->charcap;
+	}
+
+	if (held - live < live / 8) {
+		for (int i = 0; i < bufr->numrows; i++) {
+			erow *row = bufRow(bufr, i);
+			if (row->charcap > row->size + 1) {
+				row->chars = xrealloc(row->chars, row->size + 1);
+				row->charcap = row->size + 1;
+			}
+		}
+		return;
+	}
+
+	/* One block sized to the text, so the arena holds no slack at
+	 * all after a save; edits past it start a fresh block. */
+	struct rowblock *old = bufr->rowarena;
+	struct rowblock *blk = newRowBlock(live, NULL);
+	for (int i = 0; i < bufr->numrows; i++) {
+		erow *row = bufRow(bufr, i);
+		uint8_t *chars = blk->bytes + blk->used;
+		memcpy(chars, row->chars, row->size);
+		chars[row->size] = '\0';
+		blk->used += row->size + 1;
+		if (row->charcap > 0)
+			free(row->chars); /* the text, and so its caches, stay */
+		row->chars = chars;
+		row->charcap = 0;
+	}
+	freeRowBlocks(old);
+	bufr->rowarena = blk;
+}
+
+/* The row array is a gap buffer.  Rows [0, rowgap) sit at the front of
+ * the allocation and rows [rowgap, numrows) at the back, with the
+ * rowcap - numrows spare slots between them.  Inserting or deleting a
+ * row first moves the gap to the edit point, so the memmove costs the
+ * distance from the previous structural edit rather than every row
+ * after this one.  Editing is local: a run of newlines typed in the
+ * middle of a 5M-row log moves the tail once, not once per line, and
+ * appending rows at load keeps the gap at the end and moves nothing.
+ *
+ * Everything outside this file reaches rows through bufRow(), which
+ * hides the gap, so no caller needs to know where it is. */
+
+/* ---- Offset index ----
+ *
+ * rowsum is a Fenwick tree over the row array's physical slots, each
+ * weighing size + 1 -- the row and the newline after it -- and each
+ * gap slot weighing 0.  Indexing slots rather than logical rows is
+ * what lets it survive row insertion: filling or emptying a gap slot
+ * is a point update, where inserting into a tree keyed by row number
+ * would shift every entry after it.  So bufOffset(), bufPos() and
+ * bufTextLen() cost O(log rowcap) instead of a walk over the rows.
+ *
+ * Every change to a row's size must reach the tree.  Within this
+ * file that is the gap helpers below; elsewhere it is bufRowResized().
+ * EMIL_DEBUG_OFFSET_INDEX cross-checks every query against the linear
+ * walk and aborts on a mismatch. */
+
+static size_t slotWeight(struct buffer *bufr, int slot) {
+	int gapsize = bufr->rowcap - bufr->numrows;
+	if (slot >= bufr->rowgap && slot < bufr->rowgap + gapsize)
+		return 0;
+	return (size_t)bufr->row[slot].size + 1;
+}
+
+/* Add delta to one slot.  size_t arithmetic is modular, so a negative
+ * delta converted to size_t subtracts exactly. */
+static void indexAdd(struct buffer *bufr, int slot, int delta) {
+	for (int i = slot + 1; i <= bufr->rowcap; i += i & -i)
+		bufr->rowsum[i] += (size_t)delta;
+}
+
+/* Sum of the weights of slots [0, slot). */
+static size_t indexPrefix(struct buffer *bufr, int slot) {
+	size_t sum = 0;
+	for (int i = slot; i > 0; i -= i & -i)
+		sum += bufr->rowsum[i];
+	return sum;
+}
+
+/* Rebuild the whole tree in O(rowcap). */
+static void indexRebuild(struct buffer *bufr) {
+	bufr->rowsum[0] = 0;
+	for (int i = 1; i <= bufr->rowcap; i++)
+		bufr->rowsum[i] = slotWeight(bufr, i - 1);
+	for (int i = 1; i <= bufr->rowcap; i++) {
+		int up = i + (i & -i);
+		if (up <= bufr->rowcap)
+			bufr->rowsum[up] += bufr->rowsum[i];
+	}
+}
+
+/* Move the gap so that it opens before logical row `at`.  The rows that
+ * cross it change slot, so the index moves with them: per row while
+ * that is cheaper than a rebuild, by a rebuild once it is not. */
+static void bufMoveGap(struct buffer *bufr, int at) {
+	int gapsize = bufr->rowcap - bufr->numrows;
+	if (gapsize == 0 || at == bufr->rowgap) {
+		bufr->rowgap = at;
+		return;
+	}
+	int from, to, n;
+	if (at < bufr->rowgap) {
+		from = at;
+		to = at + gapsize;
+		n = bufr->rowgap - at;
+	} else {
+		from = bufr->rowgap + gapsize;
+		to = bufr->rowgap;
+		n = at - bufr->rowgap;
+	}
+
+	int log2cap = 0;
+	while ((1 << log2cap) < bufr->rowcap)
+		log2cap++;
+	int rebuild = n > bufr->rowcap / (2 * log2cap + 1);
+	if (!rebuild) {
+		for (int i = 0; i < n; i++) {
+			int w = bufr->row[from + i].size + 1;
+			indexAdd(bufr, from + i, -w);
+			indexAdd(bufr, to + i, w);
+		}
+	}
+	memmove(&bufr->row[to], &bufr->row[from], sizeof(erow) * n);
+	bufr->rowgap = at;
+	if (rebuild)
+		indexRebuild(bufr);
+}
+
+/* Make room for `n` more rows, zeroing the new slots. */
+static void bufEnsureRowCap(struct buffer *bufr, int n) {
+	if (n <= bufr->rowcap - bufr->numrows)
 		return;
 	/* The row count is bounded at INT_MAX / 2 by the load path, so the
 	 * cap below is reached before the multiplication can overflow.*/
-	int new_cap = !bufr->rowcap		 ? 16 :
-		      bufr->rowcap > INT_MAX / 2 ? INT_MAX :
-						   bufr->rowcap * 2;
+	int new_cap = bufr->rowcap;
+	while (new_cap - bufr->numrows < n && new_cap < INT_MAX)
+		new_cap = !new_cap		? 16 :
+			  new_cap > INT_MAX / 2 ? INT_MAX :
+						  new_cap * 2;
+	/* Park the gap at the end so the realloc keeps the rows in
+	 * order.  A full array has no gap, and this moves nothing. */
+	bufMoveGap(bufr, bufr->numrows);
 	bufr->row = xrealloc(bufr->row, sizeof(erow) * new_cap);
 	memset(&bufr->row[bufr->rowcap], 0,
 	       sizeof(erow) * (new_cap - bufr->rowcap));
 	bufr->rowcap = new_cap;
+	/* Fenwick nodes cover ranges that depend on the array length, so
+	 * the tree does not extend in place.  Growth doubles, which keeps
+	 * the rebuild amortised O(1) per row. */
+	bufr->rowsum = xrealloc(bufr->rowsum, sizeof(size_t) * (new_cap + 1));
+	indexRebuild(bufr);
+}
+
+/* Rows from `at` on no longer match the file: see saved_rows.  Every
+ * edit reaches one of the row changers below, which call this; the
+ * raw loaders do not, as what they add is the file's. */
+static void rowsChanged(struct buffer *bufr, int at) {
+	if (at < bufr->saved_rows)
+		bufr->saved_rows = at;
+}
+
+/* Report that `row`, which must belong to bufr, changed size by delta
+ * bytes.  See the offset index note above. */
+void bufRowResized(struct buffer *bufr, const erow *row, int delta) {
+	int slot = (int)(row - bufr->row);
+	indexAdd(bufr, slot, delta);
+	rowsChanged(bufr, slot < bufr->rowgap ?
+				  slot :
+				  slot - (bufr->rowcap - bufr->numrows));
+}
+
+/* Fill the first gap slot, which becomes logical row `rowgap`. */
+static void bufFillGap(struct buffer *bufr, const uint8_t *s, size_t len) {
+	erow *row = &bufr->row[bufr->rowgap];
+	row->size = len;
+	rowAlloc(bufr, row, len + 1);
+	memcpy(row->chars, s, len);
+	row->chars[len] = '\0';
+	row->cached_width = -1;
+	row->cache = NULL; /* the slot may hold a moved row's stale copy */
+	indexAdd(bufr, bufr->rowgap, (int)len + 1);
+
+	bufr->rowgap++;
+	bufr->numrows++;
 }
 
 void insertRow(struct buffer *bufr, int at, const uint8_t *s, size_t len) {
 	if (at < 0 || at > bufr->numrows)
 		return;
 
-	bufEnsureRowCap(bufr);
-
-	if (at < bufr->numrows) {
-		memmove(&bufr->row[at + 1], &bufr->row[at],
-			sizeof(erow) * (bufr->numrows - at));
-	}
-
-	bufr->row[at].size = len;
-	bufr->row[at].chars = xmalloc(len + 1);
-	bufr->row[at].charcap = len + 1;
-	memcpy(bufr->row[at].chars, s, len);
-	bufr->row[at].chars[len] = '\0';
+	bufEnsureRowCap(bufr, 1);
+	bufMoveGap(bufr, at);
+	bufFillGap(bufr, s, len);
+	rowsChanged(bufr, at);
+	markBufferDirty(bufr);
+}
 
-	bufr->row[at].cached_width = -1;
+/* Insert the lines of s -- split at '\n', the last one unterminated,
+ * so n newlines make n + 1 rows -- as rows at, at + 1, ...  The gap is
+ * opened once for all of them, so the cost is one memmove plus the
+ * bytes, however many rows the text holds.  Returns the number of rows
+ * inserted, or 0 if `at` is out of range. */
+int insertRows(struct buffer *bufr, int at, const uint8_t *s, size_t len) {
+	if (at < 0 || at > bufr->numrows)
+		return 0;
 
-	bufr->numrows++;
+	const uint8_t *end = s + len;
+	int n = 1;
+	for (const uint8_t *p = s; (p = memchr(p, '\n', end - p)) != NULL; p++)
+		n++;
+
+	bufEnsureRowCap(bufr, n);
+	bufMoveGap(bufr, at);
+	for (const uint8_t *p = s;;) {
+		const uint8_t *nl = memchr(p, '\n', end - p);
+		bufFillGap(bufr, p, (nl ? nl : end) - p);
+		if (nl == NULL)
+			break;
+		p = nl + 1;
+	}
+	rowsChanged(bufr, at);
 	markBufferDirty(bufr);
+	return n;
 }
 
 /* Append a row without side effects.  Used by `editorOpen` when the
  * buffer is being populated from disk.
  */
 void appendRowRaw(struct buffer *bufr, const uint8_t *s, size_t len) {
-	bufEnsureRowCap(bufr);
-
-	int at = bufr->numrows;
-	bufr->row[at].size = len;
-	bufr->row[at].chars = xmalloc(len + 1);
-	bufr->row[at].charcap = len + 1;
-	memcpy(bufr->row[at].chars, s, len);
-	bufr->row[at].chars[len] = '\0';
-	bufr->row[at].cached_width = -1;
+	bufEnsureRowCap(bufr, 1);
+	bufMoveGap(bufr, bufr->numrows);
+	bufFillGap(bufr, s, len);
+}
 
-	bufr->numrows++;
+/* Drop rows [at, numrows) without side effects: appendRowRaw() in
+ * reverse, for follow mode re-reading a file's tail.  Like
+ * bufferResetRows(), the caller restores the row-count invariant. */
+void truncateRowsRaw(struct buffer *bufr, int at) {
+	if (at < 0 || at >= bufr->numrows)
+		return;
+	bufMoveGap(bufr, bufr->numrows);
+	for (int i = at; i < bufr->numrows; i++) {
+		indexAdd(bufr, i, -(bufr->row[i].size + 1));
+		freeRow(&bufr->row[i]);
+	}
+	bufr->rowgap = at;
+	bufr->numrows = at;
 }
 
+/* Arena rows own no bytes; those go with the blocks.  The row
+ * cache is always the row's own. */
 void freeRow(erow *row) {
-	free(row->chars);
+	if (row->charcap > 0)
+		free(row->chars);
+	invalidateRowCache(row);
 }
 
 void delRow(struct buffer *bufr, int at) {
-	if (at < 0 || at >= bufr->numrows)
+	delRows(bufr, at, 1);
+}
+
+/* Delete rows [at, at + n).  With the gap moved to open after them,
+ * they are the last n slots before it, and deleting them just widens
+ * the gap: one memmove however many rows go. */
+void delRows(struct buffer *bufr, int at, int n) {
+	if (at < 0 || n <= 0 || n > bufr->numrows - at)
 		return;
-	freeRow(&bufr->row[at]);
-	if (at == bufr->numrows - 1) {
-		// Last row, no need to memmove
-		bufr->numrows--;
-	} else {
-		memmove(&bufr->row[at], &bufr->row[at + 1],
-			sizeof(erow) * (bufr->numrows - at - 1));
-		bufr->numrows--;
+	bufMoveGap(bufr, at + n);
+	for (int i = at; i < at + n; i++) {
+		indexAdd(bufr, i, -(bufr->row[i].size + 1));
+		freeRow(&bufr->row[i]);
 	}
+	bufr->rowgap = at;
+	bufr->numrows -= n;
+	rowsChanged(bufr, at);
 	markBufferDirty(bufr);
 }
 
@@ -171,8 +460,9 @@ void rowInsertChar(struct buffer *bufr, erow *row, int at, int c) {
 	memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
 	row->size++;
 	row->chars[at] = c;
+	bufRowResized(bufr, row, 1);
 	markBufferDirty(bufr);
-	row->cached_width = -1;
+	invalidateRowCacheFrom(row, at);
 }
 
 struct buffer *newBuffer(void) {
@@ -190,7 +480,11 @@ struct buffer *newBuffer(void) {
 	ret->cy = 0;
 	ret->numrows = 0;
 	ret->rowcap = 0;
+	ret->rowgap = 0;
 	ret->row = NULL;
+	ret->rowsum = NULL;
+	ret->rowarena = NULL;
+	ret->changes = 0;
 	ret->filename = NULL;
 	ret->display_name = NULL;
 	ret->min_name_len = 0;
@@ -213,9 +507,20 @@ struct buffer *newBuffer(void) {
 	ret->rectangle_mode = 0;
 	ret->read_only = 0;
 	ret->read_only_by_lock = 0;
+	ret->crlf = 0;
+	ret->deferred = 0;
 	ret->lock_fd = -1;
+	ret->watch_wd = -1;
+	ret->watch_name = NULL;
+	ret->follow = 0;
+	ret->follow_off = 0;
+	ret->follow_ino = 0;
+	ret->view = NULL;
 	ret->open_mtime = 0;
+	ret->open_mtime_nsec = 0;
 	ret->open_size = 0;
+	ret->open_ino = 0;
+	ret->saved_rows = 0;
 	ret->external_mod = 0;
 	ret->lock_blocked_pid = 0;
 	ret->internal_mod = 0;
@@ -230,16 +535,21 @@ struct buffer *newBuffer(void) {
  * invariant before returning; see the invariant note in buffer.h. */
 void bufferResetRows(struct buffer *bufr) {
 	for (int i = 0; i < bufr->numrows; i++)
-		freeRow(&bufr->row[i]);
+		freeRow(bufRow(bufr, i));
 	free(bufr->row);
+	free(bufr->rowsum);
+	freeRowBlocks(bufr->rowarena);
 	bufr->row = NULL;
+	bufr->rowsum = NULL;
+	bufr->rowarena = NULL;
 	bufr->numrows = 0;
 	bufr->rowcap = 0;
+	bufr->rowgap = 0;
 }
 
 /* The empty buffer is the one-row buffer whose single row is empty. */
 int bufferIsEmpty(struct buffer *bufr) {
-	return bufr->numrows == 1 && bufr->row[0].size == 0;
+	return bufr->numrows == 1 && bufRow(bufr, 0)->size == 0;
 }
 
 /* The number of lines of text, as a user counts them, which is not
@@ -251,7 +561,7 @@ int bufferIsEmpty(struct buffer *bufr) {
  * may legitimately sit on the final empty row, so the cursor line
  * stays cy + 1 and can exceed this count by one.*/
 int bufferLineCount(struct buffer *bufr) {
-	if (bufr->numrows > 0 && bufr->row[bufr->numrows - 1].size == 0)
+	if (bufr->numrows > 0 && bufRow(bufr, bufr->numrows - 1)->size == 0)
 		return bufr->numrows - 1;
 	return bufr->numrows;
 }
@@ -259,6 +569,11 @@ int bufferLineCount(struct buffer *bufr) {
 void destroyBuffer(struct buffer *buf) {
 	if (E.lastVisitedBuffer == buf)
 		E.lastVisitedBuffer = NULL;
+	forgetBackgroundSave(buf);
+	forgetStdinStream(buf);
+	forgetPrefetch(buf);
+	unwatchBuffer(buf);
+	viewClose(buf);
 	releaseLock(buf);
 	clearUndosAndRedos(buf);
 	free(buf->filename);
@@ -271,15 +586,17 @@ void destroyBuffer(struct buffer *buf) {
 		free(buf->completionState.matches);
 	}
 	for (int i = 0; i < buf->numrows; i++) {
-		freeRow(&buf->row[i]);
+		freeRow(bufRow(buf, i));
 	}
 	free(buf->row);
+	free(buf->rowsum);
+	freeRowBlocks(buf->rowarena);
 	free(buf);
 }
 
 void updateBuffer(struct buffer *buf) {
 	for (int i = 0; i < buf->numrows; i++) {
-		buf->row[i].cached_width = -1;
+		invalidateRowCache(bufRow(buf, i));
 	}
 }
 
@@ -472,6 +789,7 @@ void switchToNamedBuffer(void) {
 			E.windows[i]->buf = E.buf;
 		}
 	}
+	loadDeferred(E.buf);
 
 	free(buffer_name);
 }
@@ -487,6 +805,7 @@ void previousBuffer(void) {
 		}
 	}
 	resetFileCheckThrottle();
+	loadDeferred(E.buf);
 }
 
 void nextBuffer(void) {
@@ -510,6 +829,7 @@ void nextBuffer(void) {
 		}
 	}
 	resetFileCheckThrottle();
+	loadDeferred(E.buf);
 }
 
 /* Confirm only for a modified buffer that is visiting a file, matching
@@ -538,51 +858,31 @@ void killBuffer(void) {
 		}
 	}
 
-	// Find the previous buffer (if any)
-	struct buffer *prevBuf = NULL;
-	if (E.buf != E.headbuf) {
-		prevBuf = E.headbuf;
-		while (prevBuf->next != E.buf) {
-			prevBuf = prevBuf->next;
-		}
-	}
-
-	struct buffer *scratch = NULL;
-	if (bufr->next == NULL && prevBuf == NULL) {
-		scratch = newBuffer();
-		scratch->filename = xstrdup("*scratch*");
-		scratch->special_buffer = 1;
-	}
-
-	// Update window focus
-	for (int i = 0; i < E.nwindows; i++) {
-		if (E.windows[i]->buf == bufr) {
-			// If it's the last buffer, use the shared scratch
-			if (scratch != NULL) {
-				E.windows[i]->buf = scratch;
-				E.headbuf = scratch;
-				E.buf = E.headbuf;
-			} else if (bufr->next == NULL) {
-				E.windows[i]->buf = E.headbuf;
-				E.buf = E.headbuf;
-			} else {
-				E.windows[i]->buf = bufr->next;
-				E.buf = bufr->next;
-			}
-		}
-	}
-
-	// Update the main buffer list
-	if (E.headbuf == bufr) {
-		E.headbuf = bufr->next;
-	} else if (prevBuf != NULL) {
-		prevBuf->next = bufr->next;
-	}
+	removeBuffer(bufr);
+}
 
-	// Update the focused buffer
-	if (E.buf == bufr) {
-		E.buf = (bufr->next != NULL) ? bufr->next : prevBuf;
+/* Unlink bufr from the buffer list and destroy it.  Windows showing it
+ * show the buffer after it instead, or the first if it was the last;
+ * if it was the only buffer, a new *scratch* takes its place. */
+void removeBuffer(struct buffer *bufr) {
+	struct buffer **link = &E.headbuf;
+	while (*link != NULL && *link != bufr)
+		link = &(*link)->next;
+	if (*link == bufr)
+		*link = bufr->next;
+
+	struct buffer *other = bufr->next != NULL ? bufr->next : E.headbuf;
+	if (other == NULL) {
+		other = newBuffer();
+		other->filename = xstrdup("*scratch*");
+		other->special_buffer = 1;
+		E.headbuf = other;
 	}
+	for (int i = 0; i < E.nwindows; i++)
+		if (E.windows[i]->buf == bufr)
+			E.windows[i]->buf = other;
+	if (E.buf == bufr)
+		E.buf = other;
 
 	destroyBuffer(bufr);
 	resetFileCheckThrottle();
@@ -799,16 +1099,16 @@ void computeDisplayNames(void) {
 void clampToBuffer(struct buffer *buf, int *px, int *py) {
 	if (*py >= buf->numrows) {
 		*py = buf->numrows - 1;
-		*px = buf->row[*py].size;
-	} else if (*py >= 0 && *px > buf->row[*py].size) {
-		*px = buf->row[*py].size;
+		*px = bufRow(buf, *py)->size;
+	} else if (*py >= 0 && *px > bufRow(buf, *py)->size) {
+		*px = bufRow(buf, *py)->size;
 	}
 	/* The mark is a position like any other and can be carried
 	 * across rows by an edit, so it snaps to a character boundary
 	 * on the same rule as the cursor. */
 	if (*py >= 0 && *py < buf->numrows)
-		*px = utf8_snapToBoundary(buf->row[*py].chars,
-					  buf->row[*py].size, *px, +1);
+		*px = utf8_snapToBoundary(bufRow(buf, *py)->chars,
+					  bufRow(buf, *py)->size, *px, +1);
 }
 
 /* Clamp cursor and mark to valid buffer positions. Called after every command.*/
@@ -817,16 +1117,16 @@ void clampPositions(struct buffer *buf) {
 	 * row.  numrows >= 1, so numrows - 1 is always valid. */
 	if (buf->cy > buf->numrows - 1)
 		buf->cy = buf->numrows - 1;
-	if (buf->cx > buf->row[buf->cy].size)
-		buf->cx = buf->row[buf->cy].size;
+	if (buf->cx > bufRow(buf, buf->cy)->size)
+		buf->cx = bufRow(buf, buf->cy)->size;
 
 	/* A byte offset is a legal cursor position only at the start of
 	 * a character or at end of line.  Enforced here, after every
 	 * command, rather than trusted to each of the many places that
 	 * move a cursor: any command that carries cx from one row to
 	 * another can otherwise leave it inside a multibyte character. */
-	buf->cx = utf8_snapToBoundary(buf->row[buf->cy].chars,
-				      buf->row[buf->cy].size, buf->cx, +1);
+	buf->cx = utf8_snapToBoundary(bufRow(buf, buf->cy)->chars,
+				      bufRow(buf, buf->cy)->size, buf->cx, +1);
 
 	/* Clamp mark */
 	if (buf->marky >= 0)
@@ -835,12 +1135,15 @@ void clampPositions(struct buffer *buf) {
 
 /* See the contract in buffer.h.  These define the flat offset space
  * against the row array so callers can migrate to offsets before the
- * storage changes. */
+ * storage changes.  Each is answered from the offset index; the walks
+ * below are the definition, kept for EMIL_DEBUG_OFFSET_INDEX to check
+ * the index against. */
 
-size_t bufTextLen(struct buffer *bufr) {
+#ifdef EMIL_DEBUG_OFFSET_INDEX
+static size_t walkTextLen(struct buffer *bufr) {
 	size_t total = 0;
 	for (int i = 0; i < bufr->numrows; i++)
-		total += (size_t)bufr->row[i].size;
+		total += (size_t)bufRow(bufr, i)->size;
 	/* One separator between each pair of rows.  Matches
 	 * rowsToString(), which emits '\n' before every row but the
 	 * first, so an N-row buffer carries N-1 separators. */
@@ -849,40 +1152,88 @@ size_t bufTextLen(struct buffer *bufr) {
 	return total;
 }
 
+static size_t walkRowOffset(struct buffer *bufr, int cy) {
+	size_t off = 0;
+	for (int i = 0; i < cy; i++)
+		off += (size_t)bufRow(bufr, i)->size + 1;
+	return off;
+}
+
+static void indexMismatch(const char *what, size_t indexed, size_t walked) {
+	fprintf(stderr, "emil: stale offset index in %s: indexed %zu, "
+			"walked %zu\n",
+		what, indexed, walked);
+	abort();
+}
+#endif
+
+size_t bufTextLen(struct buffer *bufr) {
+	/* The index weighs each row size + 1, so its total carries one
+	 * newline per row; the text has one fewer, none after the last. */
+	size_t total = bufr->numrows > 0 ?
+			       indexPrefix(bufr, bufr->rowcap) - 1 :
+			       0;
+#ifdef EMIL_DEBUG_OFFSET_INDEX
+	if (total != walkTextLen(bufr))
+		indexMismatch("bufTextLen", total, walkTextLen(bufr));
+#endif
+	return total;
+}
+
 size_t bufOffset(struct buffer *bufr, int cx, int cy) {
 	if (cy < 0)
 		return 0;
 	if (cy > bufr->numrows - 1)
 		cy = bufr->numrows - 1;
-	size_t off = 0;
-	for (int i = 0; i < cy; i++)
-		off += (size_t)bufr->row[i].size + 1;
+	erow *row = bufRow(bufr, cy);
+	size_t off = indexPrefix(bufr, (int)(row - bufr->row));
+#ifdef EMIL_DEBUG_OFFSET_INDEX
+	if (off != walkRowOffset(bufr, cy))
+		indexMismatch("bufOffset", off, walkRowOffset(bufr, cy));
+#endif
 	if (cx < 0)
 		cx = 0;
-	if (cx > bufr->row[cy].size)
-		cx = bufr->row[cy].size;
+	if (cx > row->size)
+		cx = row->size;
 	return off + (size_t)cx;
 }
 
 void bufPos(struct buffer *bufr, size_t off, int *cx, int *cy) {
-	size_t walked = 0;
-	for (int i = 0; i < bufr->numrows; i++) {
-		size_t rowlen = (size_t)bufr->row[i].size;
-		/* off == walked + rowlen is the end-of-row position,
-		 * which belongs to this row rather than to the start of
-		 * the next: the cursor sits after the last byte, not
-		 * before the first byte of what follows.  The last row
-		 * is the only one where that position is also the end
-		 * of the buffer. */
-		if (off <= walked + rowlen) {
-			*cy = i;
-			*cx = (int)(off - walked);
-			return;
+	/* Fenwick descent for the last slot whose prefix is <= off.  A
+	 * gap slot weighs nothing, so the descent always passes over it
+	 * and lands on a row: the one with prefix <= off < prefix + size
+	 * + 1.  That range includes off == prefix + size, the end-of-row
+	 * position, which belongs to this row rather than to the start of
+	 * the next: the cursor sits after the last byte, not before the
+	 * first byte of what follows. */
+	int slot = 0;
+	size_t rem = off;
+	int step = 1;
+	while (step * 2 <= bufr->rowcap)
+		step *= 2;
+	for (; step > 0; step /= 2) {
+		if (slot + step <= bufr->rowcap &&
+		    bufr->rowsum[slot + step] <= rem) {
+			slot += step;
+			rem -= bufr->rowsum[slot];
 		}
-		walked += rowlen + 1; /* + the separator newline */
 	}
-	/* Past the end: clamp to the last valid position.  numrows >= 1
-	 * is an invariant, so row[numrows - 1] exists. */
-	*cy = bufr->numrows - 1;
-	*cx = bufr->row[*cy].size;
+
+	if (slot < bufr->rowcap) {
+		int gapsize = bufr->rowcap - bufr->numrows;
+		*cy = slot < bufr->rowgap ? slot : slot - gapsize;
+		*cx = (int)rem;
+	} else {
+		/* Past the end: clamp to the last valid position.
+		 * numrows >= 1 is an invariant, so row[numrows - 1]
+		 * exists. */
+		*cy = bufr->numrows - 1;
+		*cx = bufRow(bufr, *cy)->size;
+	}
+#ifdef EMIL_DEBUG_OFFSET_INDEX
+	size_t start = walkRowOffset(bufr, *cy);
+	if (off <= walkTextLen(bufr) &&
+	    (start > off || off - start != (size_t)*cx))
+		indexMismatch("bufPos", start + (size_t)*cx, off);
+#endif
 }
@@ -13,13 +13,36 @@
 struct buffer;
 int rejectIfReadOnly(struct buffer *buf);
 
+/* The row array is a gap buffer: logical rows [0, rowgap) occupy the
+ * front of the allocation and [rowgap, numrows) its back, with the
+ * rowcap - numrows spare slots between them.  This is the only way to
+ * index a row; the pointer it returns is valid until the next call
+ * that inserts or deletes rows. */
+static inline erow *bufRow(const struct buffer *bufr, int at) {
+	return &bufr->row[at < bufr->rowgap ? at :
+					     at + (bufr->rowcap - bufr->numrows)];
+}
+
 void insertRow(struct buffer *bufr, int at, const uint8_t *s, size_t len);
+int insertRows(struct buffer *bufr, int at, const uint8_t *s, size_t len);
 void appendRowRaw(struct buffer *bufr, const uint8_t *s, size_t len);
+void truncateRowsRaw(struct buffer *bufr, int at);
 int killBufferNeedsConfirm(const struct buffer *bufr);
 void rowEnsureCap(erow *row, int needed);
 void freeRow(erow *row);
+/* Repack the buffer's row bytes, dropping what edits have abandoned in
+ * the row arena.  Every row's chars pointer may change. */
+void bufCompactRows(struct buffer *bufr);
 void delRow(struct buffer *bufr, int at);
+void delRows(struct buffer *bufr, int at, int n);
 void rowInsertChar(struct buffer *bufr, erow *row, int at, int c);
+
+/* Every change to the size of a buffer's row must be reported here,
+ * with the signed change in bytes, so the offset index behind
+ * bufOffset() and bufPos() stays in step.  The row primitives in
+ * buffer.c report their own; code that edits row->size directly, as
+ * the bulk paths in undo.c do, must call this. */
+void bufRowResized(struct buffer *bufr, const erow *row, int delta);
 struct buffer *newBuffer(void);
 void destroyBuffer(struct buffer *buf);
 void updateBuffer(struct buffer *buf);
@@ -27,6 +50,7 @@ void switchToNamedBuffer(void);
 void nextBuffer(void);
 void previousBuffer(void);
 void killBuffer(void);
+void removeBuffer(struct buffer *bufr);
 void computeDisplayNames(void);
 void clampToBuffer(struct buffer *buf, int *px, int *py);
 void clampPositions(struct buffer *buf);
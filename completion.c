@@ -394,7 +394,7 @@ void closeCompletionsBuffer(void) {
 
 void handleMinibufferCompletion(struct buffer *minibuf, enum promptType type) {
 	/* Get current buffer text */
-	char *current_text = (char *)minibuf->row[0].chars;
+	char *current_text = (char *)bufRow(minibuf, 0)->chars;
 
 	/* Check if text changed since last completion */
 	if (minibuf->completionState.last_completed_text == NULL ||
@@ -492,7 +492,7 @@ void handleMinibufferCompletion(struct buffer *minibuf, enum promptType type) {
 	minibuf->completionState.successive_tabs++;
 	free(minibuf->completionState.last_completed_text);
 	minibuf->completionState.last_completed_text =
-		xstrdup((char *)minibuf->row[0].chars);
+		xstrdup((char *)bufRow(minibuf, 0)->chars);
 
 	/* Cleanup */
 	freeCompletionResult(&result);
@@ -5,6 +5,7 @@
 #include <limits.h>
 #include <unistd.h>
 #include "ctags.h"
+#include "buffer.h"
 #include "emil.h"
 
 #include "fileio.h"
@@ -44,7 +45,7 @@ static int isIdentChar(uint8_t c) {
 }
 
 static char *wordAtPoint(void) {
-	erow *row = &E.buf->row[E.buf->cy];
+	erow *row = bufRow(E.buf, E.buf->cy);
 	int cx = E.buf->cx;
 	if (cx >= row->size || !isIdentChar(row->chars[cx])) {
 		if (cx > 0 && isIdentChar(row->chars[cx - 1]))
@@ -246,8 +247,8 @@ void ctagsJump(void) {
 		} else if (tagpat[0]) {
 			size_t plen = strlen(tagpat);
 			for (int r = 0; r < buf->numrows; r++) {
-				if ((size_t)buf->row[r].size >= plen &&
-				    memcmp(buf->row[r].chars, tagpat, plen) ==
+				if ((size_t)bufRow(buf, r)->size >= plen &&
+				    memcmp(bufRow(buf, r)->chars, tagpat, plen) ==
 					    0) {
 					buf->cy = r;
 					buf->cx = 0;
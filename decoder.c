@@ -28,6 +28,7 @@
 
 #include "decoder.h"
 #include "keymap.h"
+#include <string.h>
 
 /* Record a byte for reporting, silently truncating past the cap. */
 static void note(uint8_t *seen, int *n, uint8_t b) {
@@ -67,6 +68,23 @@ static int decodeSS3(escByteSourceFn next, uint8_t *seen, int *n_seen) {
 	return 033;
 }
 
+/* The reply to DECRQM for mode 2026, "[?2026;" Ps "$" before the
+ * final 'y': Ps 0 or 4 is no synchronized output, 1 to 3 is. */
+static int syncReport(const uint8_t *seen, int n_seen, int *n_out) {
+	if (n_seen != 9 || memcmp(seen, "[?2026;", 7) != 0 || seen[8] != '$')
+		return 033;
+	switch (seen[7]) {
+	case '1':
+	case '2':
+	case '3':
+		return decKey(n_out, KEY_SYNC_SUPPORTED);
+	case '0':
+	case '4':
+		return decKey(n_out, KEY_SYNC_UNSUPPORTED);
+	}
+	return 033;
+}
+
 /* CSI state (after ESC [): accumulate body bytes until the final
  * byte, per the ECMA-48 grammar
  *     CSI  P..P  I..I  F
@@ -124,6 +142,16 @@ static int decodeCSI(escByteSourceFn next, uint8_t *seen, int *n_seen) {
 				case '6':
 					return decKey(n_seen, KEY_PAGE_DOWN);
 				}
+			} else if (body == 3 && b == '~' &&
+				   memcmp(seen + 1, "20", 2) == 0 &&
+				   (seen[3] == '0' || seen[3] == '1')) {
+				return decKey(n_seen, seen[3] == '0' ?
+							      KEY_PASTE_START :
+							      KEY_PASTE_END);
+			} else if (b == 'y') {
+				int key = syncReport(seen, *n_seen, n_seen);
+				if (key != 033)
+					return key;
 			}
 			note(seen, n_seen, b);
 			return 033;
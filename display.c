@@ -8,10 +8,12 @@
 #include "history.h"
 
 #include "region.h"
+#include "screen.h"
 #include "wrap.h"
 #include "terminal.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include "window.h"
 #include <errno.h>
 #include <limits.h>
@@ -19,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #ifdef __sun
 #include <termios.h>
@@ -48,7 +51,7 @@ static void computeRowHighlightBounds(struct buffer *buf, int filerow,
 	hl->match_start = -1;
 	hl->match_end = -1;
 
-	erow *row = &buf->row[filerow];
+	erow *row = bufRow(buf, filerow);
 
 	/* Completions buffer: highlight the basename portion of the
 	 * currently selected match row only.  buf->cy tracks the
@@ -287,13 +290,9 @@ static inline int scrollAllowance(struct window *win, struct buffer *buf,
 
 /* Walk back `n` screen lines from (row, subline), reporting where it
  * lands.  Stops at the start of the buffer.  Sub-lines within the
- * starting row cost nothing; each earlier row costs its own wrap.
- *
- * That per-row cost is a whole-row walk, not a bounded one: entering a
- * row from below means starting at its LAST sub-line, and the only way
- * to number that is countScreenLines() over the entire row.  Under
- * wrap this is the dominant cost of scroll()'s below-window branch, of
- * page-up and of recenter() on long rows. */
+ * starting row cost nothing; each earlier row costs a lookup of its
+ * sub-line count in the row's wrap cache, and a whole-row wrap only
+ * when that is cold. */
 static inline void linesBack(struct buffer *buf, int row, int subline, int n,
 			     int *out_row, int *out_subline) {
 	while (n > 0) {
@@ -304,7 +303,7 @@ static inline void linesBack(struct buffer *buf, int row, int subline, int n,
 				break;
 			row--;
 			subline = buf->word_wrap ?
-					  countScreenLines(&buf->row[row],
+					  countScreenLines(bufRow(buf, row),
 							   E.screencols) -
 						  1 :
 					  0;
@@ -427,7 +426,7 @@ static inline void cursorSubline(struct buffer *buf, int cursor_col,
 	if (!buf->word_wrap)
 		return;
 
-	cursorScreenLine(&buf->row[buf->cy], cursor_col, E.screencols, sub_line,
+	cursorScreenLine(bufRow(buf, buf->cy), cursor_col, E.screencols, sub_line,
 			 sub_col);
 }
 
@@ -488,15 +487,16 @@ void clampCursorToViewport(struct window *win, struct buffer *buf) {
 		buf->cy = 0;
 	if (buf->cy >= buf->numrows)
 		buf->cy = buf->numrows - 1;
-	if (buf->cx > buf->row[buf->cy].size)
-		buf->cx = buf->row[buf->cy].size;
+	if (buf->cx > bufRow(buf, buf->cy)->size)
+		buf->cx = bufRow(buf, buf->cy)->size;
 }
 
 /* Render a line with highlighting support.
  *
  * start_col / end_col: the display-column range to render.
  * start_byte: byte offset in row->chars corresponding to start_col,
- *             or -1 to scan from the beginning.  The word-wrap caller
+ *             or -1 to scan for it, from the column checkpoint
+ *             before start_col in a long row.  The word-wrap caller
  *             already knows the byte offset; passing it in avoids an
  *             O(line-length) skip loop for every wrapped sub-line.
  *
@@ -512,11 +512,14 @@ static int renderLineWithHighlighting(erow *row, struct abuf *ab, int start_col,
 	int current_highlight = 0;
 
 	/* Skip to start column.  If the caller provided a byte hint we
-	 * can jump straight there; otherwise scan from byte 0. */
+	 * can jump straight there; otherwise scan for it. */
 	if (start_byte >= 0 && start_byte <= row->size) {
 		char_idx = start_byte;
 		render_x = start_col;
 	} else {
+		struct wrapPoint from = columnCheckpoint(row, start_col);
+		char_idx = from.byte;
+		render_x = from.col;
 		while (char_idx < row->size && render_x < start_col) {
 			if (row->chars[char_idx] < 0x80 &&
 			    !ISCTRL(row->chars[char_idx])) {
@@ -606,7 +609,7 @@ static int renderLineWithHighlighting(erow *row, struct abuf *ab, int start_col,
 void screenCursorPos(struct window *win, int cursor_col, int *scx_out,
 		     int *scy_out) {
 	struct buffer *buf = win->buf;
-	erow *row = &buf->row[buf->cy]; /* cy < numrows (#105) */
+	erow *row = bufRow(buf, buf->cy); /* cy < numrows (#105) */
 	int total_width = cursor_col >= 0 ? cursor_col :
 					    charsToDisplayColumn(row, buf->cx);
 	int sub_line, sub_col;
@@ -645,13 +648,13 @@ int scroll(void) {
 
 	if (buf->cy > buf->numrows - 1) {
 		buf->cy = buf->numrows - 1;
-		buf->cx = buf->row[buf->cy].size;
-	} else if (buf->cx > buf->row[buf->cy].size) {
-		buf->cx = buf->row[buf->cy].size;
+		buf->cx = bufRow(buf, buf->cy)->size;
+	} else if (buf->cx > bufRow(buf, buf->cy)->size) {
+		buf->cx = bufRow(buf, buf->cy)->size;
 	}
 
 	if (buf->word_wrap) {
-		cursor_col = charsToDisplayColumn(&buf->row[buf->cy], buf->cx);
+		cursor_col = charsToDisplayColumn(bufRow(buf, buf->cy), buf->cx);
 		int cursor_sub_line, sub_col;
 		cursorSubline(buf, cursor_col, &cursor_sub_line, &sub_col);
 
@@ -687,7 +690,7 @@ int scroll(void) {
 	if (!buf->word_wrap) {
 		int rx = 0;
 		if (buf->cy < buf->numrows) {
-			rx = charsToDisplayColumn(&buf->row[buf->cy], buf->cx);
+			rx = charsToDisplayColumn(bufRow(buf, buf->cy), buf->cx);
 		}
 		cursor_col = rx;
 		if (rx < win->coloff) {
@@ -715,7 +718,7 @@ void drawRows(struct window *win, struct abuf *ab, int screenrows,
 		if (filerow >= buf->numrows) {
 			abAppend(ab, " ", 1);
 		} else {
-			erow *row = &buf->row[filerow];
+			erow *row = bufRow(buf, filerow);
 			if (!buf->word_wrap) {
 				// Truncated mode with visual marking
 				int end_col = win->coloff + screencols;
@@ -742,10 +745,22 @@ void drawRows(struct window *win, struct abuf *ab, int screenrows,
 				filerow++;
 			} else {
 				/* Word-wrap mode: break lines at word
-				 * boundaries when possible. */
-				int line_start_col = 0;
-				int line_start_byte = 0;
-				int sub_line_idx = 0;
+				 * boundaries when possible.  The breaks
+				 * come from the row's cache. */
+				const struct wrapPoint *at;
+				int nsub = rowBreaks(row, screencols, &at);
+
+				/* Skip sub-lines above the visible area
+				 * (only for the first rendered row, i.e.
+				 * rowoff).  A skip past the row's last
+				 * sub-line means the row shrank, or the
+				 * terminal widened, under a stored top;
+				 * nothing clamps it on write, so clamp it
+				 * here and draw the last sub-line rather
+				 * than leave the top line blank. */
+				int sub_line_idx = skip < nsub ? skip : nsub - 1;
+				int line_start_col = at[sub_line_idx].col;
+				int line_start_byte = at[sub_line_idx].byte;
 
 				/* Wrapped columns accumulate across
 				 * sub-lines, so the row's own columns run
@@ -757,36 +772,13 @@ void drawRows(struct window *win, struct abuf *ab, int screenrows,
 
 				while (line_start_byte < row->size &&
 				       y < screenrows) {
-					int break_col, break_byte;
-					int more = wordWrapBreak(
-						row, screencols, line_start_col,
-						line_start_byte, &break_col,
-						&break_byte);
-
-					/* Skip sub-lines that are above the
-					 * visible area (only for the first
-					 * rendered row, i.e. rowoff) */
-					if (sub_line_idx < skip) {
-						if (more) {
-							sub_line_idx++;
-							line_start_col =
-								break_col;
-							line_start_byte =
-								break_byte;
-							continue;
-						}
-						/* The skip names a sub-line
-						 * this row does not have: the
-						 * row shrank, or the terminal
-						 * widened, under a stored top.
-						 * Nothing clamps it on write
-						 * so clamp it here and draw
-						 * the row's last sub-line.
-						 * Breaking out instead left
-						 * the window's top line blank.
-						 */
-						skip = sub_line_idx;
-					}
+					int more = sub_line_idx + 1 < nsub;
+					int break_col =
+						more ? at[sub_line_idx + 1].col :
+						       calculateLineWidth(row);
+					int break_byte =
+						more ? at[sub_line_idx + 1].byte :
+						       row->size;
 
 					/* --- Render the span --- */
 					renderLineWithHighlighting(
@@ -964,21 +956,23 @@ static int statusMid(const struct window *win, char *out, char fc,
 	 * this exact position earlier in the frame and passes it in as
 	 * cursor_col.  A non-focused window reports its own saved cursor,
 	 * which nothing else in the frame asks about, so it computes. */
-	int ry = win->focused ? bufr->cy + 1 : win->cy + 1;
 	int cur_y = win->focused ? bufr->cy : win->cy;
+	long long ry = viewLine(bufr, cur_y) + 1;
 	int cur_x = win->focused ? bufr->cx : win->cx;
 	int rx = cur_x;
 	if (cursor_col >= 0)
 		rx = cursor_col;
 	else if (cur_y >= 0 && cur_y < bufr->numrows)
-		rx = charsToDisplayColumn(&bufr->row[cur_y], cur_x);
-	char linecol[24];
+		rx = charsToDisplayColumn(bufRow(bufr, cur_y), cur_x);
+	char linecol[40];
 	int linecol_len =
-		snprintf(linecol, sizeof(linecol), "%s%d:%d", sep, ry, rx);
+		snprintf(linecol, sizeof(linecol), "%s%lld:%d", sep, ry, rx);
 	if (linecol_len < 0)
 		linecol_len = 0;
 	char pos[8];
-	if (bufferIsEmpty(bufr))
+	if (bufr->view)
+		viewPosition(bufr, win->rowoff, pos, sizeof(pos));
+	else if (bufferIsEmpty(bufr))
 		memcpy(pos, "Emp", 4);
 	else if (bufr->end && win->rowoff == 0)
 		memcpy(pos, "All", 4);
@@ -1260,9 +1254,45 @@ void drawMinibuffer(struct abuf *ab) {
 	}
 }
 
+/* What the terminal shows, as last sent, and the frame being drawn;
+ * swapped after each refresh.  See screen.c. */
+static struct screen front, back;
+static struct abuf frame_out;
+static size_t frame_bytes;
+
+/* While keys are waiting the main loop runs them without drawing, but
+ * for no longer than this after the first frame it put off: a paste or
+ * a held key still shows progress.  The wait stretches to FRAME_SHARE times a
+ * slow frame's cost, so that drawing cannot crowd out the keys. */
+#define FRAME_DEADLINE_NS (16 * 1000000L)
+#define FRAME_SHARE 4
+
+static long frame_ns;		  /* time the last frame took */
+static struct timespec skip_start; /* first frame put off, if skipping */
+static int skipping;
+static unsigned long frames_skipped;
+
+static long nsSince(const struct timespec *t) {
+	struct timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+		return 0;
+	return (now.tv_sec - t->tv_sec) * 1000000000L +
+	       (now.tv_nsec - t->tv_nsec);
+}
+
 void refreshScreen(void) {
+	/* A buffer is read when it is first shown. */
+	loadDeferred(E.buf);
+	for (int i = 0; i < E.nwindows; i++)
+		loadDeferred(E.windows[i]->buf);
+
 	/* Check for external modification of the focused buffer's file */
 	checkFileModified();
+	viewSettle(E.buf);
+
+	struct timespec start;
+	if (clock_gettime(CLOCK_MONOTONIC, &start) != 0)
+		start.tv_sec = start.tv_nsec = 0;
 
 	struct abuf *ab = &E.render_buf;
 	ab->len = 0; /* Reset for this frame; keep the allocation */
@@ -1369,16 +1399,81 @@ void refreshScreen(void) {
 		cursor_y = cumulative_height - statusbar_height;
 	}
 
+	/* The frame drawn above is the whole screen.  What goes to the
+	 * terminal is only how it differs from the last one sent. */
+	screenParse(&back, E.screenrows, E.screencols, ab->b, ab->len);
+	struct abuf *out = &frame_out;
+	out->len = 0;
+	/* Where the terminal can, have it show the frame all at once
+	 * rather than as the bytes arrive. */
+	if (E.sync_output)
+		abAppend(out, "\x1b[?2026h", 8);
+	abAppend(out, "\x1b[?7l", 5);  // Disable auto-wrap
+	abAppend(out, "\x1b[?25l", 6); // Hide cursor
+	int top = 0;
+	for (int i = 0; i < E.nwindows; i++) {
+		int height = E.windows[i]->height;
+		screenScroll(out, &front, &back, top, top + height);
+		top += height + statusbar_height;
+	}
+	screenDiff(out, &front, &back);
+	struct screen tmp = front;
+	front = back;
+	back = tmp;
+
 	snprintf(buf, sizeof(buf), "\x1b[%d;%dH", cursor_y, scx + 1);
-	abAppend(ab, buf, strlen(buf));
-	abAppend(ab, "\x1b[?7h", 5);  // Enable auto-wrap
-	abAppend(ab, "\x1b[?25h", 6); // Show cursor
+	abAppend(out, buf, strlen(buf));
+	abAppend(out, "\x1b[?7h", 5);  // Enable auto-wrap
+	abAppend(out, "\x1b[?25h", 6); // Show cursor
+	if (E.sync_output)
+		abAppend(out, "\x1b[?2026l", 8);
 
 	/* Looped: a signal landing mid-write returns a short count and
 	 * would drop the frame's tail (CSI ?7h, CSI ?25h), leaving
 	 * auto-wrap off and the cursor hidden until the next full frame.
 	 * Reachable at ordinary terminal sizes -- see writeAll(). */
-	IGNORE_RETURN(writeAll(STDOUT_FILENO, ab->b, ab->len));
+	IGNORE_RETURN(writeAll(STDOUT_FILENO, out->b, out->len));
+	frame_bytes = (size_t)out->len;
+	frame_ns = nsSince(&start);
+	skipping = 0;
+}
+
+int frameDue(void) {
+	if (!skipping)
+		return 0;
+	long wait = FRAME_DEADLINE_NS;
+	if (frame_ns > wait / FRAME_SHARE)
+		wait = frame_ns * FRAME_SHARE;
+	return nsSince(&skip_start) >= wait;
+}
+
+void skipFrame(void) {
+	if (!skipping && clock_gettime(CLOCK_MONOTONIC, &skip_start) == 0)
+		skipping = 1;
+	frames_skipped++;
+}
+
+long lastFrameTime(void) {
+	return frame_ns;
+}
+
+unsigned long skippedFrames(void) {
+	return frames_skipped;
+}
+
+void frameStats(void) {
+	setStatusMessage("Last frame %ld.%03ld ms, %zu bytes; %lu frames "
+			 "skipped",
+			 frame_ns / 1000000, frame_ns / 1000 % 1000, frame_bytes,
+			 frames_skipped);
+}
+
+void invalidateScreen(void) {
+	front.valid = 0;
+}
+
+size_t lastFrameBytes(void) {
+	return frame_bytes;
 }
 
 void cursorBottomLine(int curs) {
@@ -1415,6 +1510,9 @@ void resizeScreen(void) {
 		E.windows[i]->height = 0;
 	}
 	computeDisplayNames();
+	/* Resized, or back from a stop or the shell drawer: what the
+	 * terminal shows is not what was last sent. */
+	invalidateScreen();
 	refreshScreen();
 }
 
@@ -1422,7 +1520,7 @@ void whatCursor(void) {
 	int rx = 0;
 	int line_len = 0;
 	if (E.buf->cy < E.buf->numrows) {
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 		line_len = row->size;
 		rx = charsToDisplayColumn(row, E.buf->cx);
 	}
@@ -1431,8 +1529,8 @@ void whatCursor(void) {
 	/* TODO Unicode codepoint uint32_t cp = utf8Decode(row->chars, E.buf->cx); */
 	char ch[8] = "EOL";
 	if (E.buf->cy < E.buf->numrows &&
-	    E.buf->cx < E.buf->row[E.buf->cy].size) {
-		uint8_t c = E.buf->row[E.buf->cy].chars[E.buf->cx];
+	    E.buf->cx < bufRow(E.buf, E.buf->cy)->size) {
+		uint8_t c = bufRow(E.buf, E.buf->cy)->chars[E.buf->cx];
 		if (c < 32) {
 			snprintf(ch, sizeof(ch), "^%c", c + 64);
 		} else if (c == 127) {
@@ -1461,7 +1559,7 @@ void recenter(struct window *win) {
 	int subline = 0;
 
 	if (buf->word_wrap) {
-		erow *row = &buf->row[buf->cy];
+		erow *row = bufRow(buf, buf->cy);
 		int col;
 		cursorScreenLine(row, charsToDisplayColumn(row, buf->cx),
 				 E.screencols, &subline, &col);
@@ -30,6 +30,21 @@ void screenCursorPos(struct window *win, int cursor_col, int *scx_out,
 		     int *scy_out);
 void cursorBottomLine(int curs);
 void resizeScreen(void);
+/* Make the next refreshScreen() repaint every cell, for when the
+ * terminal's contents are not what the editor last sent. */
+void invalidateScreen(void);
+/* Bytes the last refreshScreen() wrote to the terminal. */
+size_t lastFrameBytes(void);
+/* Nanoseconds the last refreshScreen() took to draw. */
+long lastFrameTime(void);
+/* Whether a frame is owed: frames have been put off for keys since
+ * the last one, for as long as they may be. */
+int frameDue(void);
+/* Count a frame put off because keys were waiting. */
+void skipFrame(void);
+unsigned long skippedFrames(void);
+/* Show the last frame's time and size and the frames skipped. */
+void frameStats(void);
 void recenter(struct window *win);
 void toggleVisualLineMode(void);
 void editorVersion(void);
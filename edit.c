@@ -4,6 +4,7 @@
 #include "buffer.h"
 #include "display.h"
 #include "emil.h"
+#include "fileio.h"
 #include "history.h"
 #include "keymap.h"
 
@@ -38,7 +39,7 @@ void insertChar(struct buffer *bufr, int c, int count) {
 
 	for (int i = 0; i < count; i++) {
 		/* No virtual row to materialise: cy < numrows (#105). */
-		rowInsertChar(bufr, &bufr->row[bufr->cy], bufr->cx, c);
+		rowInsertChar(bufr, bufRow(bufr, bufr->cy), bufr->cx, c);
 		bufr->cx++;
 	}
 }
@@ -75,6 +76,25 @@ void insertUnicode(int count) {
 	insertRepeat(E.buf, E.unicode, E.nunicode, UARG_COUNT(count));
 }
 
+/* Insert the text of a bracketed paste at point as it came, in one
+ * mutation: one undo record, and none of the indentation or other
+ * handling the same text would get if it were typed.  The terminal
+ * passes the bytes through unchecked, so they are held to the same
+ * UTF-8 rule as a typed character or a loaded file; the rows depend
+ * on it. */
+void insertPaste(void) {
+	if (E.paste.len == 0 || rejectIfReadOnly(E.buf))
+		return;
+	if (!utf8_validate(E.paste.buf, E.paste.len)) {
+		setStatusMessage("Paste contains invalid UTF-8");
+		return;
+	}
+
+	E.buf->mark_active = 0;
+	mutateInsert(E.buf, E.buf->cx, E.buf->cy, E.paste.buf, E.paste.len,
+		     &E.buf->cx, &E.buf->cy);
+}
+
 /* Insert 'c' 'count' times at point, recording undo.  This is the
  * undoable typing path; insertChar above is the raw primitive, used
  * for minibuffer text that is not part of the undo history. */
@@ -125,7 +145,7 @@ void insertNewlineAndIndent(int count) {
 
 	for (int j = 0; j < count; j++) {
 		insertNewline(1);
-		erow *prev = &E.buf->row[E.buf->cy - 1];
+		erow *prev = bufRow(E.buf, E.buf->cy - 1);
 		int i = 0;
 		while (i < prev->size &&
 		       (prev->chars[i] == ' ' || prev->chars[i] == CTRL('i'))) {
@@ -135,7 +155,7 @@ void insertNewlineAndIndent(int count) {
 					 &ex, &ey);
 			E.buf->cx = ex;
 			E.buf->cy = ey;
-			prev = &E.buf->row[E.buf->cy - 1];
+			prev = bufRow(E.buf, E.buf->cy - 1);
 			i++;
 		}
 	}
@@ -149,7 +169,7 @@ void unindent(int rept) {
 
 	E.buf->mark_active = 0;
 
-	struct erow *row = &E.buf->row[E.buf->cy];
+	struct erow *row = bufRow(E.buf, E.buf->cy);
 
 	/* Calculate size of unindent */
 	/* NB: trunc is bounded by the NUL terminator at chars[size],
@@ -192,10 +212,10 @@ void delChar(int count) {
 	int times = UARG_COUNT(count);
 	for (int i = 0; i < times; i++) {
 		if (E.buf->cy == E.buf->numrows - 1 &&
-		    E.buf->cx == E.buf->row[E.buf->cy].size)
+		    E.buf->cx == bufRow(E.buf, E.buf->cy)->size)
 			return;
 
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 		if (E.buf->cx == row->size) {
 			/* Deleting the row separator joins the next row
 			 * onto this one. */
@@ -233,7 +253,7 @@ void backSpace(int count) {
 		if (E.buf->cy == 0 && E.buf->cx == 0)
 			return;
 
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 		if (E.buf->cx > 0) {
 			/* Walk back over any UTF-8 continuation bytes so
 			 * the whole character is one deletion. */
@@ -250,7 +270,7 @@ void backSpace(int count) {
 			 * separator between them. */
 			const uint8_t nl = '\n';
 			int prevy = E.buf->cy - 1;
-			int prevx = E.buf->row[prevy].size;
+			int prevx = bufRow(E.buf, prevy)->size;
 			mutateDeleteChar(E.buf, prevx, prevy, 0, E.buf->cy, &nl,
 					 1);
 			E.buf->cx = prevx;
@@ -410,7 +430,7 @@ void transposeWords(int uarg) {
 		setStatusMessage("Beginning of buffer");
 		return;
 	} else if (E.buf->cy == E.buf->numrows - 1 &&
-		   E.buf->cx == E.buf->row[E.buf->cy].size) {
+		   E.buf->cx == bufRow(E.buf, E.buf->cy)->size) {
 		setStatusMessage("End of buffer");
 		return;
 	}
@@ -443,7 +463,7 @@ static void transposeCharsBackward(void) {
 		return;
 	}
 
-	erow *row = &E.buf->row[E.buf->cy];
+	erow *row = bufRow(E.buf, E.buf->cy);
 
 	/* Need two characters before point on this line. */
 	if (E.buf->cx == 0) {
@@ -471,7 +491,7 @@ static void transposeCharsBackward(void) {
 	/* Point lands after the dragged character, which is now first in
 	 * the transformed range.  Re-read the row: the replace may have
 	 * reallocated its chars. */
-	row = &E.buf->row[E.buf->cy];
+	row = bufRow(E.buf, E.buf->cy);
 	E.buf->cx = c1x + utf8_nBytes(row->chars[c1x]);
 }
 
@@ -487,7 +507,7 @@ void transposeChars(int uarg) {
 		return;
 	}
 
-	erow *row = &E.buf->row[E.buf->cy];
+	erow *row = bufRow(E.buf, E.buf->cy);
 
 	/* If nothing after point, back up one character. */
 	if (E.buf->cx >= row->size) {
@@ -532,7 +552,7 @@ void killLine(int count) {
 		if (bufferIsEmpty(E.buf))
 			return;
 
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 
 		if (E.buf->cx == row->size) {
 			/* At end of logical line: join with next line */
@@ -579,6 +599,12 @@ void quit(void) {
 	if (E.recording) {
 		E.recording = 0;
 	}
+	/* A save still running decides whether its buffer is unsaved. */
+	if (backgroundSaveRunning()) {
+		setStatusMessage("Finishing background save...");
+		refreshScreen();
+		finishBackgroundSave();
+	}
 	// Check all buffers for unsaved changes, except the special buffers
 	struct buffer *current = E.headbuf;
 	int hasUnsavedChanges = 0;
@@ -861,7 +887,7 @@ void zapToChar(void) {
 	int sy = E.buf->cy;
 
 	while (sy < E.buf->numrows) {
-		erow *row = &E.buf->row[sy];
+		erow *row = bufRow(E.buf, sy);
 		int start = (sy == E.buf->cy) ? E.buf->cx : 0;
 		for (int x = start; x < row->size; x++) {
 			if (row->chars[x] == (uint8_t)c) {
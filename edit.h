@@ -9,6 +9,7 @@
 void insertChar(struct buffer *bufr, int c, int count);
 void selfInsert(struct buffer *bufr, int c, int count);
 void insertUnicode(int count);
+void insertPaste(void);
 
 /* Line operations */
 void insertNewline(int count);
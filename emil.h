@@ -4,6 +4,7 @@
 #define EMIL_H 1
 
 #include "abuf.h"
+#include "dbuf.h"
 #include "keymap.h"
 #include <stdint.h>
 #include <stdlib.h>
@@ -66,11 +67,15 @@ enum promptType {
 
 typedef struct erow {
 	int size;
-	int charcap; /* bytes allocated (>= size + 1) */
+	int charcap; /* bytes allocated (>= size + 1), or 0 when chars
+		      * is carved from the buffer's row arena */
 	uint8_t *chars;
 	int cached_width; /* display width in columns, or -1 if stale.
 			   * INVARIANT: any code that modifies
-			   * row text must set this to -1. */
+			   * row text must call invalidateRowCache()
+			   * or invalidateRowCacheFrom(). */
+	struct rowCache *cache; /* wrap breaks and column checkpoints,
+				 * or NULL; see wrap.c */
 } erow;
 
 struct undo {
@@ -122,11 +127,22 @@ struct buffer {
 	int mark_ring_idx; /* next slot to write (circular) */
 	int numrows;
 	int rowcap;
+	int rowgap; /* logical row at which the row array's gap opens;
+		     * reach rows through bufRow(), never row[] */
+	size_t *rowsum; /* offset index over the row array; see buffer.c */
+	struct rowblock *rowarena; /* blocks holding row bytes; see buffer.c */
+	struct fileView *view; /* non-NULL: rows are a window of a file too
+				* large to load; see view.c */
 	int end;
 	int dirty;
+	unsigned long changes; /* edits ever made; see background save */
 	int special_buffer;
 	int word_wrap;
 	int rectangle_mode;
+	int crlf; /* lines end "\r\n" on disk: the rows hold them without
+		   * the CR, and writeRows() puts it back */
+	int deferred; /* opened but not yet read: filename is set, the rows
+		       * are not; see loadDeferred() */
 	int read_only;
 	/* 1 when read_only was imposed by us because another process
 	 * held an advisory lock at open time, and NOT by a failed
@@ -139,12 +155,28 @@ struct buffer {
 	 * Safe across the 2038 boundary.  Do NOT do arithmetic on
 	 * this field. */
 	time_t open_mtime;    /* st_mtime at open/save, 0 if unset */
+	long open_mtime_nsec; /* its sub-second part, where the system
+	                       * records one, else 0 */
 	off_t open_size;      /* st_size at the same moment; only
 	                       * meaningful when open_mtime != 0.
 	                       * st_mtime is whole seconds, so a write
 	                       * in the load's second is invisible to
 	                       * it alone. */
+	ino_t open_ino;       /* and st_ino */
+	int saved_rows;       /* rows [0, saved_rows) are byte for byte
+	                       * what the file holds as of open/save, so
+	                       * a save need only write the rest */
 	int external_mod;     /* 1 if file changed on disk since open/save */
+	int watch_wd;         /* inotify watch on the file's directory,
+	                       * or -1 when the file is polled instead */
+	char *watch_name;     /* the file's name in that directory, after
+	                       * symlinks are resolved */
+	int follow;           /* follow-mode: take in what the file grows
+	                       * by rather than flag it as changed */
+	off_t follow_off;     /* offset after the file's last '\n' in the
+	                       * rows; short of open_size when the last
+	                       * line is still being written */
+	ino_t follow_ino;     /* the file being followed */
 	int lock_blocked_pid; /* PID holding the lock we couldn't acquire,
 	                       * or -1 if held by unknown process, or 0
 	                       * if we are not blocked */
@@ -245,6 +277,7 @@ struct config {
 	int screencols;
 	uint8_t unicode[4];
 	int nunicode;
+	struct dbuf paste; /* Text of the last KEY_PASTE */
 	char statusmsg[1024];
 	char prefix_display[32]; /* Display prefix commands like C-u */
 
@@ -300,6 +333,7 @@ struct config {
 	struct timespec last_file_check; /* monotonic time of last
 	                                  * checkFileModified syscall */
 	struct abuf render_buf;		 /* Persistent screen-render buffer */
+	int sync_output; /* Terminal takes synchronized updates (?2026) */
 };
 
 /*** prototypes ***/
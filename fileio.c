@@ -6,13 +6,14 @@
 #include "display.h"
 #include "emil.h"
 #include "keymap.h"
-
+#include "linediff.h"
 #include "mutate.h"
 #include "prompt.h"
 #include "terminal.h"
 #include "undo.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include <errno.h>
 #include <fcntl.h>
 #include <glob.h>
@@ -24,8 +25,21 @@
 #include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0 && !defined(EMIL_NO_THREADS)
+#define EMIL_LOAD_THREADS
+#include <pthread.h>
+#endif
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
 
 /* Access global editor state */
 
@@ -70,6 +84,11 @@ static void disarmTimer(void) {
 /* How many seconds between file-check syscalls. */
 #define FILE_CHECK_INTERVAL_SEC 2
 
+/* The same for a buffer the file watcher covers, which is polled only
+ * for the changes inotify cannot see: those made on another NFS
+ * client, say. */
+#define FILE_WATCH_POLL_SEC 10
+
 /* Force the next checkFileModified call to run immediately,
  * bypassing the throttle.  Called on events where the user's
  * context has changed and stale state should be caught promptly:
@@ -257,6 +276,19 @@ void relockAll(void) {
 }
 #endif /* EMIL_NO_FILE_LOCKING */
 
+/* The sub-second part of st's mtime.  Where the struct has no field
+ * for it, 0, and st_mtime alone is compared. */
+static long mtimeNsec(const struct stat *st) {
+#if defined(__APPLE__)
+	return (long)st->st_mtimespec.tv_nsec;
+#elif defined(_POSIX_VERSION) && _POSIX_VERSION >= 200809L
+	return (long)st->st_mtim.tv_nsec;
+#else
+	(void)st;
+	return 0;
+#endif
+}
+
 static void clearLockWarning(struct buffer *bufr) {
 	bufr->lock_blocked_pid = 0;
 	if (bufr->read_only_by_lock) {
@@ -265,6 +297,37 @@ static void clearLockWarning(struct buffer *bufr) {
 	}
 }
 
+static int savingInBackground(const struct buffer *buf);
+static void awaitBackgroundSave(const struct buffer *buf);
+static void followGrowth(struct buffer *bufr, const char *iopath,
+			 const struct stat *st);
+
+/* Set bufr->external_mod if the file's mtime or size has drifted
+ * since open/save.  One-shot: skipped once the flag is set, and while
+ * a background save of this buffer is still writing the file.  A
+ * clean buffer in follow mode takes the change in instead.  Returns 1
+ * if the file had changed, 0 if the buffer was left alone. */
+static int noteExternalChange(struct buffer *bufr) {
+	if (bufr->open_mtime == 0 || bufr->external_mod ||
+	    savingInBackground(bufr))
+		return 0;
+	char *iopath = expandTilde(bufr->filename);
+	struct stat st;
+	armTimer();
+	int rc = stat(iopath, &st);
+	disarmTimer();
+	int changed = rc == 0 && (st.st_mtime != bufr->open_mtime ||
+				  st.st_size != bufr->open_size);
+	if (changed) {
+		if (bufr->follow && !bufr->dirty)
+			followGrowth(bufr, iopath, &st);
+		else
+			bufr->external_mod = 1;
+	}
+	free(iopath);
+	return changed;
+}
+
 /* Check whether the underlying file has been modified externally, and
  * opportunistically clear a stale lock_blocked_pid warning if the
  * blocking process has since released the lock.
@@ -272,7 +335,9 @@ static void clearLockWarning(struct buffer *bufr) {
  * Called periodically (from refreshScreen) on the focused buffer, at
  * most once every FILE_CHECK_INTERVAL_SEC seconds on the monotonic
  * clock, with each stat() / lockFile() wrapped in a 50ms SIGALRM
- * deadline so a hung filesystem never stalls the editor.
+ * deadline so a hung filesystem never stalls the editor.  A buffer
+ * the file watcher covers runs Job 1 only every FILE_WATCH_POLL_SEC,
+ * for the filesystems whose changes inotify does not report.
  *
  * Two independent jobs:
  *
@@ -303,6 +368,16 @@ void checkFileModified(void) {
 	if (E.buf->filename == NULL || E.buf->special_buffer)
 		return;
 
+	/* Nothing to poll for: skip the clock as well as the stat. */
+	int want_mtime = E.buf->open_mtime != 0 && !E.buf->external_mod;
+	int want_lock = E.buf->lock_blocked_pid != 0 && E.buf->lock_fd < 0 &&
+			!E.buf->external_mod;
+	if (!want_mtime && !want_lock)
+		return;
+	int interval = E.buf->watch_wd >= 0 && !want_lock ?
+			       FILE_WATCH_POLL_SEC :
+			       FILE_CHECK_INTERVAL_SEC;
+
 	/* Throttle: skip if we checked recently.  Fails closed -- if
 	 * the clock is unreadable we skip the check rather than run it
 	 * unthrottled on every frame. */
@@ -310,23 +385,12 @@ void checkFileModified(void) {
 	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
 		return;
 	long elapsed = now.tv_sec - E.last_file_check.tv_sec;
-	if (elapsed >= 0 && elapsed < FILE_CHECK_INTERVAL_SEC)
+	if (elapsed >= 0 && elapsed < interval)
 		return;
 	E.last_file_check = now;
 
 	/* Job 1: mtime check. */
-	if (E.buf->open_mtime != 0 && !E.buf->external_mod) {
-		char *iopath = expandTilde(E.buf->filename);
-		struct stat st;
-		armTimer();
-		int rc = stat(iopath, &st);
-		disarmTimer();
-		if (rc == 0 && (st.st_mtime != E.buf->open_mtime ||
-				st.st_size != E.buf->open_size)) {
-			E.buf->external_mod = 1;
-		}
-		free(iopath);
-	}
+	noteExternalChange(E.buf);
 
 	/* Job 2: stale-lock clearing. */
 	if (E.buf->lock_blocked_pid != 0 && E.buf->lock_fd < 0 &&
@@ -372,6 +436,166 @@ void checkFileModified(void) {
 	}
 }
 
+/*** file watching ***/
+
+/* On Linux every file-backed buffer's directory is watched with
+ * inotify, and the main loop sleeps on the watch descriptor alongside
+ * the terminal.  An event naming a buffer's file runs the same mtime
+ * check that checkFileModified() polls for, so external_mod is set as
+ * soon as the file changes, in unfocused buffers too.  Our own saves
+ * raise events as well; they pass the check because saving records
+ * the new mtime first.
+ *
+ * The directory rather than the file is watched so that a file
+ * replaced by rename(), as many editors save, is still seen.  It is
+ * the directory of the file's real path, so a symlink to a file
+ * elsewhere reports changes to its target.  Buffers in the same
+ * directory share one watch descriptor.  A buffer with no watch
+ * (watch_wd < 0) -- inotify unavailable, out of watches, or the
+ * directory gone -- is polled by checkFileModified() as before, and a
+ * watched one is still polled, less often, for the changes inotify
+ * never hears of: those made on another host of a network
+ * filesystem. */
+
+#ifdef __linux__
+static int watchFd = -1;
+static int watchBroken; /* inotify_init1 failed: poll everything */
+
+static const char *baseName(const char *path) {
+	const char *slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+/* Drop our interest in wd, removing the watch if no buffer still
+ * shares it. */
+static void dropWatch(int wd) {
+	if (wd < 0)
+		return;
+	for (struct buffer *b = E.headbuf; b != NULL; b = b->next)
+		if (b->watch_wd == wd)
+			return;
+	inotify_rm_watch(watchFd, wd);
+}
+
+/* Create the inotify instance on first use.  Returns 0 if there is
+ * none, and stops trying after the first failure. */
+static int openWatchFd(void) {
+	if (watchFd < 0 && !watchBroken) {
+		watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (watchFd < 0)
+			watchBroken = 1;
+	}
+	return watchFd >= 0;
+}
+
+/* (Re)watch buf's file, which may have been renamed since.  The old
+ * watch is dropped after the new one is added, so a buffer that stays
+ * in its directory keeps the same descriptor throughout. */
+void watchBuffer(struct buffer *buf) {
+	int old = buf->watch_wd;
+	buf->watch_wd = -1;
+	free(buf->watch_name);
+	buf->watch_name = NULL;
+	if (buf->filename != NULL && !buf->special_buffer && openWatchFd()) {
+		char *iopath = expandTilde(buf->filename);
+		/* A file not there yet is watched under the name given. */
+		char *real = realpath(iopath, NULL);
+		if (real != NULL) {
+			free(iopath);
+			iopath = real;
+		}
+		buf->watch_name = xstrdup(baseName(iopath));
+		char *slash = strrchr(iopath, '/');
+		const char *dir = ".";
+		if (slash == iopath)
+			dir = "/";
+		else if (slash != NULL) {
+			*slash = '\0';
+			dir = iopath;
+		}
+		buf->watch_wd = inotify_add_watch(
+			watchFd, dir,
+			IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE |
+				IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+		free(iopath);
+	}
+	if (old != buf->watch_wd)
+		dropWatch(old);
+}
+
+void unwatchBuffer(struct buffer *buf) {
+	int wd = buf->watch_wd;
+	buf->watch_wd = -1;
+	free(buf->watch_name);
+	buf->watch_name = NULL;
+	dropWatch(wd);
+}
+
+int fileWatchFd(void) {
+	return watchFd;
+}
+
+/* Drain the watch descriptor and check every buffer an event names.
+ * Returns 1 if that changed a buffer, and the screen wants redrawing:
+ * in a busy directory most events concern files that are not open. */
+int readFileWatch(void) {
+	char in[4096];
+	int changed = 0;
+
+	if (watchFd < 0)
+		return 0;
+	for (;;) {
+		ssize_t n = read(watchFd, in, sizeof(in));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return changed;
+
+		for (ssize_t off = 0; off < n;) {
+			/* Copied out: the byte buffer promises no alignment. */
+			struct inotify_event ev;
+			memcpy(&ev, in + off, sizeof(ev));
+			const char *name = in + off + sizeof(ev);
+			off += (ssize_t)(sizeof(ev) + ev.len);
+
+			for (struct buffer *b = E.headbuf; b != NULL;
+			     b = b->next) {
+				if (ev.mask & IN_Q_OVERFLOW) {
+					/* Events were lost: check all. */
+					if (b->watch_wd >= 0)
+						changed |= noteExternalChange(b);
+				} else if (b->watch_wd != ev.wd) {
+					continue;
+				} else if (ev.mask & IN_IGNORED) {
+					/* The directory went away; the
+					 * poll takes over. */
+					b->watch_wd = -1;
+				} else if (ev.len == 0 ||
+					   strcmp(name, b->watch_name) == 0) {
+					changed |= noteExternalChange(b);
+				}
+			}
+		}
+	}
+}
+#else
+void watchBuffer(struct buffer *buf) {
+	(void)buf;
+}
+
+void unwatchBuffer(struct buffer *buf) {
+	(void)buf;
+}
+
+int fileWatchFd(void) {
+	return -1;
+}
+
+int readFileWatch(void) {
+	return 0;
+}
+#endif
+
 /*** file i/o ***/
 
 /* Serialise the buffer: rows joined by '\n', with no terminator.  A
@@ -379,14 +603,14 @@ void checkFileModified(void) {
  * from this function (see the invariant note in buffer.h).  The
  * result is NUL-terminated for convenience; *buflen excludes it.
  *
- * Byte-exact against editorOpen for LF files.  CRLF input is
- * converted to LF on load and written back as LF; preserving CRLF is
- * a separate question. */
+ * This is the buffer's text, the offset space of buffer.h, so it is
+ * '\n'-separated whatever the file's line endings: those are applied
+ * on the way to disk, by writeRows(). */
 char *rowsToString(struct buffer *bufr, size_t *buflen) {
 	size_t totlen = 0;
 	int j;
 	for (j = 0; j < bufr->numrows; j++)
-		totlen += bufr->row[j].size;
+		totlen += bufRow(bufr, j)->size;
 	if (bufr->numrows > 1)
 		totlen += (size_t)bufr->numrows - 1;
 	*buflen = totlen;
@@ -398,134 +622,379 @@ char *rowsToString(struct buffer *bufr, size_t *buflen) {
 			*p = '\n';
 			p++;
 		}
-		memcpy(p, bufr->row[j].chars, bufr->row[j].size);
-		p += bufr->row[j].size;
+		memcpy(p, bufRow(bufr, j)->chars, bufRow(bufr, j)->size);
+		p += bufRow(bufr, j)->size;
 	}
 	*p = '\0';
 
 	return buf;
 }
 
+/* The most iovecs one writev() is given: two per row, its text and
+ * the separator before it.  POSIX only promises 16 (_XOPEN_IOV_MAX). */
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define ROW_IOVECS IOV_MAX
+#else
+#define ROW_IOVECS 1024
+#endif
+
+static int writeRowsFrom(int fd, struct buffer *bufr, int first);
+static off_t writtenOffset(struct buffer *bufr, int row);
+
+/* In a background save's child, the result pipe: writeRowsFrom()
+ * reports there each SAVE_PROGRESS_BYTES how far into the file it
+ * has written.  See "Background save". */
+static int saveProgressFd = -1;
+#define SAVE_PROGRESS_BYTES (8 * 1024 * 1024)
+
+/* Write the buffer to fd as rowsToString() would serialise it, but
+ * straight from the rows: writev() batches of row text and
+ * separators, so saving a 900 MB buffer needs no second 900 MB copy.
+ * The separator is "\r\n" for a CRLF buffer, so keeping a DOS file's
+ * line endings costs one more byte per iovec, not a pass over the
+ * text.  Retries on EINTR and resumes short writes mid-iovec.  Returns
+ * 0, or -1 with errno set; on failure fd may hold any prefix of the
+ * text. */
+int writeRows(int fd, struct buffer *bufr) {
+	return writeRowsFrom(fd, bufr, 0);
+}
+
+/* The same from row 'first' on: the text after the separator ending
+ * row first - 1. */
+static int writeRowsFrom(int fd, struct buffer *bufr, int first) {
+	static char crlf[] = "\r\n";
+	char *newline = bufr->crlf ? crlf : crlf + 1;
+	size_t newline_len = bufr->crlf ? 2 : 1;
+	struct iovec iov[ROW_IOVECS];
+	int row = first;
+	long long at = 0, reported = 0;
+	if (saveProgressFd >= 0)
+		at = reported = (long long)writtenOffset(bufr, first);
+
+	while (row < bufr->numrows) {
+		int n = 0;
+		for (; row < bufr->numrows && n + 2 <= ROW_IOVECS; row++) {
+			if (row > first) {
+				iov[n].iov_base = newline;
+				iov[n++].iov_len = newline_len;
+			}
+			erow *r = bufRow(bufr, row);
+			if (r->size > 0) {
+				iov[n].iov_base = r->chars;
+				iov[n++].iov_len = (size_t)r->size;
+			}
+		}
+
+		struct iovec *v = iov;
+		while (n > 0) {
+			ssize_t w = writev(fd, v, n);
+			if (w < 0) {
+				if (errno == EINTR)
+					continue;
+				return -1;
+			}
+			if (w == 0) {
+				errno = EIO;
+				return -1;
+			}
+			at += w;
+			while (n > 0 && (size_t)w >= v->iov_len) {
+				w -= (ssize_t)v->iov_len;
+				v++;
+				n--;
+			}
+			if (n > 0) {
+				v->iov_base = (char *)v->iov_base + w;
+				v->iov_len -= (size_t)w;
+			}
+		}
+		if (saveProgressFd >= 0 &&
+		    at - reported >= SAVE_PROGRESS_BYTES) {
+			IGNORE_RETURN(writeAll(saveProgressFd, &at, sizeof(at)));
+			reported = at;
+		}
+	}
+	return 0;
+}
+
+/* Where writeRows() puts row 'row': its text offset plus the CRs
+ * before it. */
+static off_t writtenOffset(struct buffer *bufr, int row) {
+	size_t off = bufOffset(bufr, 0, row);
+	if (bufr->crlf)
+		off += (size_t)row;
+	return (off_t)off;
+}
+
+/* The length of what writeRows() writes. */
+static size_t writtenLen(struct buffer *bufr) {
+	size_t len = bufTextLen(bufr);
+	if (bufr->crlf && bufr->numrows > 1)
+		len += (size_t)bufr->numrows - 1;
+	return len;
+}
+
+/* toggle-line-endings: write the buffer back with the other line
+ * endings.  Nothing in the rows changes, so there is nothing to undo;
+ * the buffer is simply modified until saved. */
+void toggleLineEndings(void) {
+	struct buffer *buf = E.buf;
+	if (buf->read_only) {
+		setStatusMessage("Buffer is read-only");
+		return;
+	}
+	buf->crlf = !buf->crlf;
+	buf->saved_rows = 0; /* every separator changes */
+	markBufferDirty(buf);
+	buf->internal_mod = 1; /* undo cannot take it back to clean */
+	setStatusMessage(buf->crlf ? "Line endings: DOS (CRLF)" :
+				     "Line endings: Unix (LF)");
+}
+
 /* Validate UTF-8 in the buffer and check for null bytes.
  * Also rejects overlong encodings, surrogates (U+D800-U+DFFF),
  * and codepoints above U+10FFFF.
- * Returns 1 if valid, 0 if invalid. */
+ * Returns 1 if valid, 0 if invalid.
+ *
+ * Only rows from saved_rows on are checked.  Those before it are
+ * still the bytes the load scan validated, so a save that writes
+ * only the changed tail does not pay for a pass over the whole
+ * buffer first. */
 
 static int checkUTF8Validity(struct buffer *bufr) {
-	for (int row = 0; row < bufr->numrows; row++) {
-		if (!utf8_validate(bufr->row[row].chars, bufr->row[row].size))
+	for (int row = bufr->saved_rows; row < bufr->numrows; row++) {
+		if (!utf8_validate(bufRow(bufr, row)->chars, bufRow(bufr, row)->size))
 			return 0;
 	}
 	return 1;
 }
 
-/* Pre-scan an open file for null bytes.  Returns 1 if null bytes
- * are found, 0 if clean.  Rewinds the file on return.
- * This is needed because emil_getline uses fgets/strlen internally,
- * which treats '\0' as a string terminator and would silently
- * truncate lines containing null bytes. */
+/* What scanRows() saw on the way through. */
+struct rowScan {
+	int nul;	      /* a NUL byte; the rows are incomplete */
+	int bad_utf8;	      /* invalid UTF-8; the rows are incomplete */
+	int crlf_lines;	      /* lines ended "\r\n" */
+	int lf_lines;	      /* lines ended by a bare '\n' */
+	int no_final_newline; /* the last line had no '\n' */
+	int max_width;	      /* widest row, in display columns */
+};
+
+/* Append the lines of p to bufr as rows in a single pass that touches
+ * each byte once: finding the line end, rejecting NUL and invalid
+ * UTF-8, and measuring the display width are one walk, and the width
+ * lands in cached_width so nothing re-measures the row until it is
+ * edited.  utf8_skipPrintable() takes the printable-ASCII runs in
+ * vector strides; the loop here handles only the bytes that stop it.
+ * A line loses its '\n' and the '\r' before it.  A last line without
+ * a '\n' keeps a final '\r': it ends no line, so nothing would write
+ * it back.  No row is added for the empty remainder after a final
+ * '\n'; that is the caller's policy.
+ *
+ * Stops at the first NUL byte or invalid UTF-8 sequence.  NUL is
+ * reported in preference to bad UTF-8 wherever it falls, as the old
+ * whole-file NUL pre-scan did, so the rest of the text is searched
+ * for one before giving up. */
+static void scanRows(struct buffer *bufr, const uint8_t *p, size_t len,
+		     struct rowScan *scan) {
+	const uint8_t *end = p + len;
+	memset(scan, 0, sizeof(*scan));
+	while (p < end) {
+		const uint8_t *q = p;
+		const uint8_t *nl = NULL;
+		int width = 0;
+
+		for (;;) {
+			const uint8_t *r = utf8_skipPrintable(q, end);
+			width += (int)(r - q);
+			q = r;
+			if (q == end)
+				break;
+			uint8_t c = *q;
+			if (c == '\n') {
+				nl = q;
+				break;
+			} else if (c == '\0') {
+				scan->nul = 1;
+				return;
+			} else if (c == '\t') {
+				width = (width / EMIL_TAB_STOP + 1) *
+					EMIL_TAB_STOP;
+				q++;
+			} else if (c < 0x80) {
+				width += 2; /* other controls and DEL, as ^X */
+				q++;
+			} else {
+				int n = utf8_nBytes(c);
+				if (n > end - q)
+					n = (int)(end - q);
+				if (!utf8_validate(q, n)) {
+					scan->bad_utf8 = 1;
+					scan->nul = memchr(q, '\0', end - q) != NULL;
+					return;
+				}
+				width += charInStringWidth(q, 0);
+				q += n;
+			}
+			if (q - p > INT_MAX / 2) {
+				scan->bad_utf8 = 1; /* unrepresentable */
+				return;
+			}
+		}
 
-static int fileContainsNullBytes(FILE *fp) {
-	unsigned char buf[8192];
-	size_t n;
-	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
-		if (memchr(buf, '\0', n) != NULL) {
-			rewind(fp);
-			return 1;
+		size_t linelen = q - p;
+		/* A CR counts as a DOS ending only when it precedes the
+		 * '\n'.  A lone CR is an ordinary byte, kept as-is on save,
+		 * and so is any CR before the one ending the line: a
+		 * CRLF buffer writes exactly one back. */
+		int cr = nl && linelen > 0 && p[linelen - 1] == '\r';
+		if (cr)
+			scan->crlf_lines++;
+		else if (nl)
+			scan->lf_lines++;
+		scan->no_final_newline = (nl == NULL);
+
+		/* The stripped CR was counted as a two-column ^M. */
+		if (cr) {
+			linelen--;
+			width -= 2;
 		}
+		appendRowRaw(bufr, p, linelen);
+		bufRow(bufr, bufr->numrows - 1)->cached_width = width;
+		if (width > scan->max_width)
+			scan->max_width = width;
+		if (nl == NULL)
+			break;
+		p = nl + 1;
 	}
-	rewind(fp);
-	return 0;
 }
 
-/* Open a file into a buffer.
- * Returns 0 on success, -1 on failure (file not found is not a failure;
- * the buffer is left empty with the filename set). */
+/* The size of each read() a load makes. */
+#define LOAD_CHUNK (1024 * 1024)
 
-static int editorOpenBody(struct buffer *bufr, const char *filename);
+/* Read fd to its end and append its lines to bufr, a chunk at a time.
+ * Each read is scanned up to its last '\n'; the unfinished line after
+ * that moves to the front of the chunk for the next read to complete,
+ * and a line longer than the chunk grows it.  So a load holds the rows
+ * and one chunk, never the whole file a second time.
+ *
+ * Not mmap(): a load runs mid-session too (revert, insert-file, a
+ * deferred buffer shown), and another process truncating a mapped
+ * file -- a log being rotated -- would raise SIGBUS and take every
+ * unsaved buffer with the editor.  A read just comes up short, and a
+ * read error likewise ends the text where it stopped.
+ *
+ * *scan is as scanRows() leaves it for the whole file, so a NUL after
+ * the first bad UTF-8 sequence is still found and reported. */
+static void readRows(int fd, struct buffer *bufr, struct rowScan *scan) {
+	size_t cap = LOAD_CHUNK;
+	uint8_t *chunk = xmalloc(cap);
+	size_t have = 0;    /* bytes in chunk */
+	size_t checked = 0; /* leading bytes known to hold no '\n' */
+	int eof = 0;
+
+	memset(scan, 0, sizeof(*scan));
+	while (!eof) {
+		if (have == cap) {
+			cap <<= 1;
+			chunk = xrealloc(chunk, cap);
+		}
+		ssize_t n = read(fd, chunk + have, cap - have);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			eof = 1;
+		else
+			have += (size_t)n;
 
-/* The wrapper exists so that relockAll() cannot be bypassed. */
-int editorOpen(struct buffer *bufr, const char *filename) {
-	int rc = editorOpenBody(bufr, filename);
-	relockAll();
-	return rc;
-}
+		size_t end = have;
+		if (!eof)
+			while (end > checked && chunk[end - 1] != '\n')
+				end--;
+		if (end == checked && !eof) {
+			checked = have;
+			continue;
+		}
+		if (end == 0)
+			break;
 
-static int editorOpenBody(struct buffer *bufr, const char *filename) {
-	free(bufr->filename);
-	bufr->filename = collapseHome(filename);
+		struct rowScan part;
+		scanRows(bufr, chunk, end, &part);
+		scan->crlf_lines += part.crlf_lines;
+		scan->lf_lines += part.lf_lines;
+		scan->no_final_newline = part.no_final_newline;
+		if (part.max_width > scan->max_width)
+			scan->max_width = part.max_width;
+		memmove(chunk, chunk + end, have - end);
+		have -= end;
+		checked = have;
+		if (part.nul || part.bad_utf8) {
+			scan->nul = part.nul;
+			scan->bad_utf8 = part.bad_utf8;
+			break;
+		}
+	}
 
-	/* Resolve to an OS-usable path for all I/O in this function */
-	char *iopath = expandTilde(bufr->filename);
+	/* Bad UTF-8 gives way to a NUL anywhere later in the file. */
+	if (scan->bad_utf8 && !scan->nul) {
+		scan->nul = memchr(chunk, '\0', have) != NULL;
+		while (!scan->nul && !eof) {
+			ssize_t n = read(fd, chunk, cap);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+			scan->nul = memchr(chunk, '\0', (size_t)n) != NULL;
+		}
+	}
+	free(chunk);
+}
 
-	FILE *fp = fopen(iopath, "r");
+/* A load in two parts.  loadFile() reads the file and splits it into
+ * rows, touching nothing but the buffer, so that it can run on a
+ * thread of its own: several at once in editorOpenFiles(), or the
+ * prefetch below.  finishLoad() does
+ * the rest on the main thread: the status message, the lock probe,
+ * display names, and the view of a file too large to load. */
+struct load {
+	struct buffer *buf;
+	char *iopath;
+	int err;	/* errno from opening the file, or 0 */
+	int too_large;	/* over EMIL_MAX_FILE_SIZE: a view, not rows */
+	int deferred;	/* not to be read yet: see editorOpenDeferred() */
+	time_t mtime;	/* the file as read, for a prefetch to check */
+	off_t size;
+	struct rowScan scan;
+};
+
+static void loadFile(struct load *ld) {
+	struct buffer *bufr = ld->buf;
+
+	FILE *fp = fopen(ld->iopath, "r");
 	if (!fp) {
-		if (errno == ENOENT) {
-			/* A path with a trailing '/' names a directory;
-			 * it can never be created as a regular file, so
-			 * don't offer it as a "new file". */
-			size_t plen = strlen(iopath);
-			if (plen > 0 && iopath[plen - 1] == '/') {
-				setStatusMessage("Can't open file: %s",
-						 strerror(EISDIR));
-				free(bufr->filename);
-				bufr->filename = NULL;
-				free(iopath);
-				return -1;
-			}
-			setStatusMessage("%s (New file)", bufr->filename);
-			free(iopath);
-			return 0;
-		}
-		setStatusMessage("Can't open file: %s", strerror(errno));
-		free(bufr->filename);
-		bufr->filename = NULL;
-		free(iopath);
-		return -1;
+		ld->err = errno;
+		return;
 	}
 
 	/* Reject directories (fopen(dir, "r") succeeds on many
 	 * systems and reads then silently fail with EISDIR, which
 	 * would present the directory as an empty new buffer) and
 	 * check regular files against the hard size limit. */
-	{
-		struct stat st;
-		if (fstat(fileno(fp), &st) == 0) {
-			if (S_ISDIR(st.st_mode)) {
-				fclose(fp);
-				setStatusMessage("Can't open file: %s",
-						 strerror(EISDIR));
-				free(bufr->filename);
-				bufr->filename = NULL;
-				free(iopath);
-				return -1;
-			}
-			if (S_ISREG(st.st_mode) &&
-			    (size_t)st.st_size > EMIL_MAX_FILE_SIZE) {
-				fclose(fp);
-				setStatusMessage("Exceeds 1 GiB limit");
-				free(bufr->filename);
-				bufr->filename = NULL;
-				free(iopath);
-				return -1;
-			}
-		}
-	}
-
-	/* Pre-scan for null bytes before line-based reading because
-	 * emil_getline (fgets/strlen) silently truncates at '\0'. */
-	if (fileContainsNullBytes(fp)) {
+	struct stat fst;
+	if (fstat(fileno(fp), &fst) != 0) {
+		/* Type unknown: read it as it comes. */
+		memset(&fst, 0, sizeof(fst));
+	} else if (S_ISDIR(fst.st_mode)) {
 		fclose(fp);
-		setStatusMessage("File contains null bytes (binary file?)");
-		free(bufr->filename);
-		bufr->filename = NULL;
-		free(iopath);
-		return -1;
+		ld->err = EISDIR;
+		return;
+	} else if (S_ISREG(fst.st_mode) &&
+		   (size_t)fst.st_size > EMIL_MAX_FILE_SIZE) {
+		fclose(fp);
+		ld->too_large = 1;
+		return;
 	}
-
-	char *line = NULL;
-	size_t linecap = 0;
-	ssize_t linelen;
+	ld->mtime = fst.st_mtime;
+	ld->size = fst.st_size;
 
 	/* Rebuild the row array from scratch: the buffer arrives from
 	 * newBuffer (or a previous load, via revert) already holding
@@ -536,25 +1005,8 @@ static int editorOpenBody(struct buffer *bufr, const char *filename) {
 	/* A text file is lines each terminated by '\n'.  Input departing
 	 * from that is normalised on the way in, and the user told, so
 	 * the file does not quietly change at save. */
-	int dos_endings = 0;
-	int no_final_newline = 0;
-
-	while ((linelen = emil_getline(&line, &linecap, fp)) != -1) {
-		/* Sampled before stripping and overwritten each pass, so
-		 * after the loop it describes the final line. */
-		no_final_newline = (linelen == 0 || line[linelen - 1] != '\n');
-
-		/* A CR counts as a DOS ending only when it precedes the
-		 * '\n'.  A lone CR is an ordinary byte, kept as-is on save.*/
-		if (linelen >= 2 && line[linelen - 1] == '\n' &&
-		    line[linelen - 2] == '\r')
-			dos_endings = 1;
-
-		while (linelen > 0 &&
-		       (line[linelen - 1] == '\n' || line[linelen - 1] == '\r'))
-			linelen--;
-		appendRowRaw(bufr, (const uint8_t *)line, linelen);
-	}
+	readRows(fileno(fp), bufr, &ld->scan);
+	fclose(fp);
 
 	/* The file is the rows joined by '\n', so a trailing newline is
 	 * one more (empty) row.  Appended unconditionally: emil's buffers
@@ -563,42 +1015,80 @@ static int editorOpenBody(struct buffer *bufr, const char *filename) {
 	 * holds from load onwards.
 	 *
 	 * An empty file is the single empty row, which serialises back to
-	 * zero bytes. */
+	 * zero bytes.  A file the scan stopped short in is replaced by
+	 * that row alone. */
+	if (ld->scan.nul || ld->scan.bad_utf8)
+		bufferResetRows(bufr);
 	appendRowRaw(bufr, (const uint8_t *)"", 0);
+}
+
+/* Forget the file: a failed load leaves no name on the buffer. */
+static int loadFailed(struct load *ld) {
+	free(ld->buf->filename);
+	ld->buf->filename = NULL;
+	return -1;
+}
+
+/* Open a file into a buffer.
+ * Returns 0 on success, -1 on failure (file not found is not a failure;
+ * the buffer is left empty with the filename set). */
+static int finishLoad(struct load *ld) {
+	struct buffer *bufr = ld->buf;
+	const char *iopath = ld->iopath;
+
+	if (ld->err == ENOENT) {
+		/* A path with a trailing '/' names a directory; it can
+		 * never be created as a regular file, so don't offer it
+		 * as a "new file". */
+		size_t plen = strlen(iopath);
+		if (plen > 0 && iopath[plen - 1] == '/') {
+			setStatusMessage("Can't open file: %s", strerror(EISDIR));
+			return loadFailed(ld);
+		}
+		setStatusMessage("%s (New file)", bufr->filename);
+		return 0;
+	}
+	if (ld->err) {
+		setStatusMessage("Can't open file: %s", strerror(ld->err));
+		return loadFailed(ld);
+	}
+	if (ld->too_large) {
+		/* Too large to load: page through it read-only. */
+		int rc = viewOpen(bufr, iopath);
+		if (rc != 0)
+			loadFailed(ld);
+		computeDisplayNames();
+		return rc;
+	}
 
-	/* Get the display length of the longest column */
-	int max_width = 0;
-	for (int i = 0; i < bufr->numrows; i++) {
-		int w = calculateLineWidth(&bufr->row[i]);
-		if (w > max_width)
-			max_width = w;
+	/* Validated during the scan: a NUL byte cannot be represented
+	 * in a row, and row primitives (see rowDelChar) assume every
+	 * row is valid UTF-8. */
+	const struct rowScan *scan = &ld->scan;
+	if (scan->nul || scan->bad_utf8) {
+		setStatusMessage(scan->nul ?
+					 "File contains null bytes (binary file?)" :
+					 "Failed UTF-8 validation");
+		return loadFailed(ld);
 	}
+	int no_final_newline = scan->no_final_newline;
 
-	free(line);
-	fclose(fp);
+	/* The line endings are the file's, and stay so at save: a DOS
+	 * file edited here is not rewritten line by line.  A file mixing
+	 * the two takes the more common, which is what it then gets. */
+	int mixed = scan->crlf_lines > 0 && scan->lf_lines > 0;
+	bufr->crlf = scan->crlf_lines > scan->lf_lines;
+
+	/* The display length of the longest row, measured by the scan */
+	int max_width = scan->max_width;
 
 	/* Guard against pathological files with billions of tiny lines. */
 	if (bufr->numrows > INT_MAX / 2) {
 		bufferResetRows(bufr);
 		appendRowRaw(bufr, (const uint8_t *)"", 0);
-		free(bufr->filename);
-		bufr->filename = NULL;
 		setStatusMessage("File has too many lines");
-		free(iopath);
-		return -1;
-	}
-
-	/* Validate UTF-8 encoding of the loaded content */
-	if (!checkUTF8Validity(bufr)) {
-		bufferResetRows(bufr);
-		appendRowRaw(bufr, (const uint8_t *)"", 0);
-		free(bufr->filename);
-		bufr->filename = NULL;
-		setStatusMessage("Failed UTF-8 validation");
-		free(iopath);
-		return -1;
+		return loadFailed(ld);
 	}
-
 	/* The load used appendRowRaw which  does not dirty the buffer
 	 *  or invalidate per-row; invalidate the screen cache once here
 	 *  now that all rows are in place. */
@@ -612,17 +1102,27 @@ static int editorOpenBody(struct buffer *bufr, const char *filename) {
 		struct stat st;
 		if (stat(iopath, &st) == 0) {
 			bufr->open_mtime = st.st_mtime;
+			bufr->open_mtime_nsec = mtimeNsec(&st);
 			bufr->open_size = st.st_size;
+			bufr->open_ino = st.st_ino;
 		}
 	}
 
+	/* The rows are the file, but for what the load normalised: every
+	 * line ending of a mixed file, and a last line that lacked its
+	 * '\n'. */
+	if (mixed)
+		bufr->saved_rows = 0;
+	else if (no_final_newline)
+		bufr->saved_rows = bufr->numrows - 2;
+	else
+		bufr->saved_rows = INT_MAX;
+
 	/* Probe for an advisory lock held by another process.  If one
 	 * is found, open the buffer read-only so the user doesn't
 	 * accidentally collide with the other editor instance. */
 	int lock_pid = probeLock(iopath);
 
-	free(iopath);
-
 	computeDisplayNames();
 
 	/* Enable word wrap by default for prose-oriented file types */
@@ -655,22 +1155,332 @@ static int editorOpenBody(struct buffer *bufr, const char *filename) {
 		else
 			setStatusMessage(
 				"Read only: advisory lock by another process");
-	} else if (dos_endings && no_final_newline) {
-		setStatusMessage("%d lines, %d columns; DOS line endings and "
-				 "no final newline, both fixed on save",
-				 bufferLineCount(bufr), max_width);
-	} else if (dos_endings) {
-		setStatusMessage("%d lines, %d columns; DOS line endings, "
-				 "will be converted to Unix on save",
-				 bufferLineCount(bufr), max_width);
-	} else if (no_final_newline) {
-		setStatusMessage("%d lines, %d columns; no final newline, "
-				 "one will be added on save",
-				 bufferLineCount(bufr), max_width);
 	} else {
-		setStatusMessage("%d lines, %d columns", bufferLineCount(bufr),
-				 max_width);
+		const char *endings = "";
+		if (mixed)
+			endings = bufr->crlf ? "; mixed line endings, all DOS "
+					       "on save" :
+					       "; mixed line endings, all Unix "
+					       "on save";
+		else if (bufr->crlf)
+			endings = "; DOS line endings";
+		setStatusMessage("%d lines, %d columns%s%s",
+				 bufferLineCount(bufr), max_width, endings,
+				 no_final_newline ? "; no final newline, one "
+						    "will be added on save" :
+						    "");
+	}
+	return 0;
+}
+
+static int editorOpenBody(struct buffer *bufr, const char *filename) {
+	free(bufr->filename);
+	bufr->filename = collapseHome(filename);
+
+	/* Resolve to an OS-usable path for all I/O in the load */
+	struct load ld;
+	memset(&ld, 0, sizeof(ld));
+	ld.buf = bufr;
+	ld.iopath = expandTilde(bufr->filename);
+	loadFile(&ld);
+	int rc = finishLoad(&ld);
+	free(ld.iopath);
+	return rc;
+}
+
+/* The wrapper exists so that relockAll() cannot be bypassed. */
+int editorOpen(struct buffer *bufr, const char *filename) {
+	int rc = editorOpenBody(bufr, filename);
+	relockAll();
+	watchBuffer(bufr);
+	return rc;
+}
+
+#ifdef EMIL_LOAD_THREADS
+/* Threads beyond this add little: the loads are then waiting on the
+ * disk, or on each other in malloc. */
+#define LOAD_THREADS_MAX 16
+
+struct loadQueue {
+	struct load *loads;
+	int n;
+	int next; /* the next load to take, under lock */
+	pthread_mutex_t lock;
+};
+
+static void *loadWorker(void *arg) {
+	struct loadQueue *q = arg;
+	for (;;) {
+		pthread_mutex_lock(&q->lock);
+		int i = q->next++;
+		pthread_mutex_unlock(&q->lock);
+		if (i >= q->n)
+			return NULL;
+		if (!q->loads[i].deferred)
+			loadFile(&q->loads[i]);
+	}
+}
+
+/* loadFile() each of loads not deferred, on as many threads as there
+ * are cores and such loads, the calling one among them.  Files are
+ * taken one at a time, so a large one holds up only its own thread.
+ * A thread that cannot be started just leaves its share to the
+ * others. */
+static void loadAll(struct load *loads, int n) {
+	long cores = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	int eager = 0;
+	for (int i = 0; i < n; i++)
+		eager += !loads[i].deferred;
+	int nthreads = cores < 1 ? 1 : cores > LOAD_THREADS_MAX ? LOAD_THREADS_MAX :
+								 (int)cores;
+	if (nthreads > eager)
+		nthreads = eager;
+
+	struct loadQueue q;
+	q.loads = loads;
+	q.n = n;
+	q.next = 0;
+	if (nthreads < 2 || pthread_mutex_init(&q.lock, NULL) != 0) {
+		for (int i = 0; i < n; i++)
+			if (!loads[i].deferred)
+				loadFile(&loads[i]);
+		return;
+	}
+	pthread_t tid[LOAD_THREADS_MAX];
+	int started = 0;
+	while (started < nthreads - 1 &&
+	       pthread_create(&tid[started], NULL, loadWorker, &q) == 0)
+		started++;
+	loadWorker(&q);
+	for (int i = 0; i < started; i++)
+		pthread_join(tid[i], NULL);
+	pthread_mutex_destroy(&q.lock);
+}
+#else
+static void loadAll(struct load *loads, int n) {
+	for (int i = 0; i < n; i++)
+		if (!loads[i].deferred)
+			loadFile(&loads[i]);
+}
+#endif
+
+/* Whether the file at iopath can wait to be read: a regular file,
+ * small enough to load and readable, so that reading it later is
+ * unlikely to fail where reading it now would not.  Anything else is
+ * read at once, and its failure reported where it was named. */
+static int deferrable(const char *iopath) {
+	struct stat st;
+	return stat(iopath, &st) == 0 && S_ISREG(st.st_mode) &&
+	       (size_t)st.st_size <= EMIL_MAX_FILE_SIZE &&
+	       access(iopath, R_OK) == 0;
+}
+
+int editorOpenFiles(struct buffer **bufs, char *const *names, int n,
+		    int defer) {
+	struct load *loads = xmalloc(sizeof(*loads) * (size_t)(n ? n : 1));
+	for (int i = 0; i < n; i++) {
+		memset(&loads[i], 0, sizeof(loads[i]));
+		loads[i].buf = bufs[i];
+		free(bufs[i]->filename);
+		bufs[i]->filename = collapseHome(names[i]);
+		loads[i].iopath = expandTilde(bufs[i]->filename);
+		loads[i].deferred =
+			defer && i < n - 1 && deferrable(loads[i].iopath);
+	}
+
+	loadAll(loads, n);
+
+	int done = 0;
+	for (; done < n; done++) {
+		if (loads[done].deferred) {
+			bufs[done]->deferred = 1;
+			continue;
+		}
+		if (finishLoad(&loads[done]) != 0)
+			break;
+		watchBuffer(bufs[done]);
+	}
+	relockAll();
+	for (int i = 0; i < n; i++)
+		free(loads[i].iopath);
+	free(loads);
+	return done;
+}
+
+int editorOpenDeferred(struct buffer *bufr, const char *filename) {
+	char *name = collapseHome(filename);
+	char *iopath = expandTilde(name);
+	int defer = deferrable(iopath);
+	free(iopath);
+	if (!defer) {
+		free(name);
+		return editorOpen(bufr, filename);
+	}
+	free(bufr->filename);
+	bufr->filename = name;
+	bufr->deferred = 1;
+	return 0;
+}
+
+/* Prefetch: the next deferred buffer read on a thread of its own while
+ * the user looks at this one, so that moving on to it finds the rows
+ * waiting.  One at a time, and only ever loadFile(): the buffer stays
+ * deferred, and untouched by the main thread, until loadDeferred()
+ * takes the result.  A prefetch not taken is kept, not repeated. */
+#ifdef EMIL_LOAD_THREADS
+static struct {
+	struct buffer *buf; /* being or been read, or NULL */
+	int running;	    /* the thread is yet to be joined */
+	pthread_t tid;
+	struct load ld;
+} prefetch;
+
+static void *prefetchWorker(void *arg) {
+	loadFile(arg);
+	return NULL;
+}
+
+void prefetchDeferred(struct buffer *after) {
+	if (prefetch.buf != NULL || after == NULL)
+		return;
+	struct buffer *b = after->next;
+	while (b != NULL && !b->deferred)
+		b = b->next;
+	for (struct buffer *w = E.headbuf; b == NULL && w != NULL && w != after;
+	     w = w->next)
+		if (w->deferred)
+			b = w;
+	if (b == NULL)
+		return;
+
+	memset(&prefetch.ld, 0, sizeof(prefetch.ld));
+	prefetch.ld.buf = b;
+	prefetch.ld.iopath = expandTilde(b->filename);
+	if (pthread_create(&prefetch.tid, NULL, prefetchWorker,
+			   &prefetch.ld) != 0) {
+		free(prefetch.ld.iopath);
+		return;
+	}
+	prefetch.buf = b;
+	prefetch.running = 1;
+}
+
+/* Let the thread finish.  Before fork(): a child must not inherit
+ * a thread that was midway through an allocation. */
+static void waitPrefetch(void) {
+	if (prefetch.running) {
+		pthread_join(prefetch.tid, NULL);
+		prefetch.running = 0;
+	}
+}
+
+void forgetPrefetch(struct buffer *buf) {
+	if (prefetch.buf == NULL || prefetch.buf != buf)
+		return;
+	waitPrefetch();
+	free(prefetch.ld.iopath);
+	prefetch.buf = NULL;
+}
+
+/* The prefetched load of ld->buf into *ld, if there is one and the
+ * file is still the one it read: same path, which a change of
+ * directory can alter, and same size and mtime.  Returns 0 if the
+ * file is to be read afresh, with the prefetched rows dropped: the
+ * fresh read may fail before it replaces them, and must not leave
+ * the old file's text under a "(New file)". */
+static int takePrefetch(struct load *ld) {
+	if (prefetch.buf != ld->buf)
+		return 0;
+	waitPrefetch();
+	struct load *p = &prefetch.ld;
+	struct stat st;
+	int fresh = strcmp(p->iopath, ld->iopath) == 0 && p->err == 0 &&
+		    !p->too_large && stat(ld->iopath, &st) == 0 &&
+		    st.st_mtime == p->mtime && st.st_size == p->size;
+	if (fresh) {
+		ld->scan = p->scan;
+		ld->mtime = p->mtime;
+		ld->size = p->size;
+	} else {
+		bufferResetRows(ld->buf);
+		appendRowRaw(ld->buf, (const uint8_t *)"", 0);
 	}
+	free(p->iopath);
+	prefetch.buf = NULL;
+	return fresh;
+}
+#else
+void prefetchDeferred(struct buffer *after) {
+	(void)after;
+}
+
+static void waitPrefetch(void) {
+}
+
+void forgetPrefetch(struct buffer *buf) {
+	(void)buf;
+}
+
+static int takePrefetch(struct load *ld) {
+	(void)ld;
+	return 0;
+}
+#endif
+
+/* A deferred file that fails to load -- binary, invalid UTF-8, made
+ * unreadable since -- fails too late to stop startup, and finishLoad()
+ * would leave an empty buffer with no name.  The buffer goes instead,
+ * and the message names the file.  Whatever is shown in its place is
+ * read in turn.  Takes name, the file's. */
+static void dropDeferred(struct buffer *bufr, char *name) {
+	char why[sizeof(E.statusmsg)];
+	emil_strlcpy(why, E.statusmsg, sizeof(why));
+
+	removeBuffer(bufr);
+	loadDeferred(E.buf);
+	for (int i = 0; i < E.nwindows; i++)
+		loadDeferred(E.windows[i]->buf);
+
+	int n = snprintf(NULL, 0, "%s: %s", name, why);
+	char *showName = leftTruncate(name, nameFit(name, n));
+	setStatusMessage("%s: %s", showName, why);
+	free(showName);
+	free(name);
+}
+
+int loadDeferred(struct buffer *bufr) {
+	if (bufr == NULL || !bufr->deferred)
+		return 0;
+	bufr->deferred = 0;
+
+	struct load ld;
+	memset(&ld, 0, sizeof(ld));
+	ld.buf = bufr;
+	ld.iopath = expandTilde(bufr->filename);
+	if (!takePrefetch(&ld))
+		loadFile(&ld);
+	/* finishLoad() forgets the name of a file it fails on. */
+	char *name = xstrdup(bufr->filename);
+	int rc = finishLoad(&ld);
+	if (rc == 0)
+		watchBuffer(bufr);
+	relockAll();
+	free(ld.iopath);
+	if (rc != 0) {
+		dropDeferred(bufr, name);
+		return -1;
+	}
+	free(name);
+
+	/* A cursor placed before the load, by +LINE, lands in the file. */
+	if (bufr->cy >= bufr->numrows) {
+		bufr->cy = bufr->numrows - 1;
+		bufr->cx = 0;
+	}
+	prefetchDeferred(bufr);
 	return 0;
 }
 
@@ -681,6 +1491,8 @@ void revert(void) {
 		setStatusMessage("Buffer is not visiting a file");
 		return;
 	}
+	/* Read the file as the save leaves it, not half-written. */
+	awaitBackgroundSave(buf);
 
 	/* editorOpen returns 0 both when it loaded a file and when the
 	 * file does not exist (ENOENT posts "(New file)"), so a "< 0"
@@ -728,12 +1540,324 @@ void revert(void) {
 	if (new->cy >= new->numrows) {
 		new->cy = new->numrows - 1;
 		new->cx = 0;
-	} else if (new->cx > new->row[new->cy].size) {
-		new->cx = new->row[new->cy].size;
+	} else if (new->cx > bufRow(new, new->cy)->size) {
+		new->cx = bufRow(new, new->cy)->size;
 	}
 	destroyBuffer(buf);
 }
 
+/* revert-buffer-with-fine-grain: bring the buffer to what is on disk by
+ * editing only the lines that differ.  The file is loaded into a
+ * scratch buffer, diffLines() finds the hunks, and each is applied
+ * through mutateReplace() from the bottom up, so the row numbers of
+ * those above stay true.  The hunks are chained into one undo step,
+ * and the cursor, mark and windows move with the text as they would
+ * for any edit. */
+
+struct revertRows {
+	struct buffer *buf, *disk;
+	uint64_t *hbuf, *hdisk;
+};
+
+static uint64_t rowHash(const erow *row) {
+	uint64_t h = 14695981039346656037ULL; /* FNV-1a */
+	for (int i = 0; i < row->size; i++) {
+		h ^= row->chars[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static uint64_t *rowHashes(struct buffer *b) {
+	uint64_t *h = xmalloc(sizeof(*h) * (size_t)b->numrows);
+	for (int i = 0; i < b->numrows; i++)
+		h[i] = rowHash(bufRow(b, i));
+	return h;
+}
+
+static int sameRow(void *ctx, int a, int b) {
+	struct revertRows *r = ctx;
+	if (r->hbuf[a] != r->hdisk[b])
+		return 0;
+	const erow *ra = bufRow(r->buf, a);
+	const erow *rb = bufRow(r->disk, b);
+	return ra->size == rb->size &&
+	       memcmp(ra->chars, rb->chars, ra->size) == 0;
+}
+
+void revertFineGrain(void) {
+	struct buffer *buf = E.buf;
+
+	if (buf->filename == NULL) {
+		setStatusMessage("Buffer is not visiting a file");
+		return;
+	}
+	if (buf->view) {
+		revert(); /* a view holds nothing to keep */
+		return;
+	}
+	awaitBackgroundSave(buf);
+	char *iopath = expandTilde(buf->filename);
+	struct stat rst;
+	if (stat(iopath, &rst) != 0) {
+		setStatusMessage("File %s no longer exists!", buf->filename);
+		free(iopath);
+		return;
+	}
+	free(iopath);
+
+	struct buffer *disk = newBuffer();
+	if (editorOpen(disk, buf->filename) < 0) {
+		destroyBuffer(disk);
+		return;
+	}
+	if (disk->view) {
+		destroyBuffer(disk);
+		setStatusMessage("File too large to compare; use revert-buffer");
+		return;
+	}
+
+	/* Both end in the empty row after the final newline (see
+	 * buffer.h), which the diff keeps out of every hunk: each hunk
+	 * ends before a row that exists, so it is whole lines. */
+	struct revertRows r = { buf, disk, rowHashes(buf), rowHashes(disk) };
+	struct lineHunk *h;
+	int nh = diffLines(buf->numrows, disk->numrows, sameRow, &r, &h);
+	free(r.hbuf);
+	free(r.hdisk);
+
+	/* Reverting is not an edit the user could be refused. */
+	int read_only = buf->read_only;
+	buf->read_only = 0;
+	for (int i = nh - 1; i >= 0; i--) {
+		struct dbuf text = DBUF_INIT;
+		for (int j = h[i].b; j < h[i].b + h[i].blen; j++) {
+			dbuf_append(&text, bufRow(disk, j)->chars,
+				    bufRow(disk, j)->size);
+			dbuf_byte(&text, '\n');
+		}
+		int old_len;
+		uint8_t *old = collectRegionText(buf, 0, h[i].a, 0,
+						 h[i].a + h[i].alen, &old_len);
+		mutateReplace(buf, 0, h[i].a, 0, h[i].a + h[i].alen, old,
+			      old_len, text.buf, text.len, i != nh - 1,
+			      NULL, NULL);
+		free(old);
+		dbuf_free(&text);
+	}
+	buf->read_only = read_only;
+	clampPositions(buf);
+
+	/* The rows are the file's now; undo leads away from it. */
+	markBufferClean(buf);
+	buf->internal_mod = 1;
+	buf->external_mod = 0;
+	buf->follow = 0;
+	buf->crlf = disk->crlf;
+	buf->open_mtime = disk->open_mtime;
+	buf->open_mtime_nsec = disk->open_mtime_nsec;
+	buf->open_size = disk->open_size;
+	buf->open_ino = disk->open_ino;
+	buf->saved_rows = disk->saved_rows;
+	destroyBuffer(disk);
+	free(h);
+
+	if (nh == 0)
+		setStatusMessage("Buffer already matches %s", buf->filename);
+	else
+		setStatusMessage("Reverted %d change%s from %s", nh,
+				 nh == 1 ? "" : "s", buf->filename);
+}
+
+/*** follow mode ***/
+
+/* M-x follow-mode keeps a buffer on a growing file, as tail -f does.
+ * When the change check sees the file grow -- through the watcher, or
+ * the poll where there is none -- only the bytes past the old end are
+ * read, and their lines appended by the load path's scanRows().  A
+ * last line still unfinished when read is read again with the rest of
+ * it: follow_off marks where it starts.  A large-file view grows by
+ * re-reading its window, if that held the end.
+ *
+ * A cursor on the last row stays on it, so the newest line is in
+ * view; moved up, it stays put.  Growth is taken in only while the
+ * buffer is clean -- unsaved edits get the usual external change
+ * warning -- and a file that shrinks or is replaced, as log rotation
+ * does, ends follow mode with the same warning. */
+
+/* Offset just past the last '\n' in the first 'size' bytes of fd, 0 if
+ * there is none, or -1 on a read error. */
+static off_t lastLineStart(int fd, off_t size) {
+	uint8_t chunk[4096];
+	off_t end = size;
+	while (end > 0) {
+		size_t n = end < (off_t)sizeof(chunk) ? (size_t)end :
+							sizeof(chunk);
+		if (pread(fd, chunk, n, end - (off_t)n) != (ssize_t)n)
+			return -1;
+		for (size_t i = n; i > 0; i--)
+			if (chunk[i - 1] == '\n')
+				return end - (off_t)n + (off_t)i;
+		end -= (off_t)n;
+	}
+	return 0;
+}
+
+static void stopFollowing(struct buffer *bufr, const char *why) {
+	bufr->follow = 0;
+	bufr->external_mod = 1;
+	setStatusMessage("Follow mode disabled: %s %s", bufr->filename, why);
+}
+
+/* len, less a UTF-8 sequence that p[len - 1] leaves unfinished. */
+static size_t wholeChars(const uint8_t *p, size_t len) {
+	size_t lead = len;
+	while (lead > 0 && len - lead < 3 && utf8_isCont(p[lead - 1]))
+		lead--;
+	if (lead > 0 && utf8_nBytes(p[lead - 1]) > (int)(len - lead + 1))
+		return lead - 1;
+	return len;
+}
+
+/* Append the lines the file at iopath, now described by st, has gained
+ * since open_size. */
+static void followGrowth(struct buffer *bufr, const char *iopath,
+			 const struct stat *st) {
+	if (st->st_ino != bufr->follow_ino || st->st_size < bufr->open_size) {
+		stopFollowing(bufr, "was truncated or replaced");
+		return;
+	}
+
+	if (bufr->view) {
+		int pin = viewAtEnd(bufr, bufr->cy);
+		viewGrow(bufr, st->st_size);
+		if (pin) {
+			bufr->cy = viewShow(bufr, VIEW_LAST_LINE);
+			bufr->cx = 0;
+		}
+		bufr->open_size = st->st_size;
+		bufr->open_mtime = st->st_mtime;
+		bufr->open_mtime_nsec = mtimeNsec(st);
+		return;
+	}
+
+	int fd = open(iopath, O_RDONLY);
+	if (fd < 0)
+		return; /* tried again on the next change */
+	size_t len = (size_t)(st->st_size - bufr->follow_off);
+	uint8_t *p = xmalloc(len ? len : 1);
+	size_t got = 0;
+	while (got < len) {
+		ssize_t n = pread(fd, p + got, len - got,
+				  bufr->follow_off + (off_t)got);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		got += (size_t)n;
+	}
+	close(fd);
+
+	/* The last row is the empty one after the final newline, and if
+	 * the last line was unfinished, the row before holds its head.
+	 * Both are read again from follow_off. */
+	int old_last = bufr->numrows - 1;
+	int pin = bufr->cy == old_last;
+	truncateRowsRaw(bufr, bufr->numrows - (bufr->follow_off <
+							   bufr->open_size ?
+						       2 :
+						       1));
+	size_t tail = got;
+	while (tail > 0 && p[tail - 1] != '\n')
+		tail--;
+	int first = bufr->numrows;
+	struct rowScan scan;
+	scanRows(bufr, p, tail, &scan);
+	if (!scan.nul && !scan.bad_utf8 && tail < got) {
+		/* A flush can stop the unfinished line mid-character: show
+		 * it up to there.  Its bytes are judged with the rest of
+		 * the line, once its newline is written. */
+		int before = bufr->numrows;
+		struct rowScan part;
+		scanRows(bufr, p + tail, wholeChars(p + tail, got - tail),
+			 &part);
+		if (bufr->numrows == before)
+			appendRowRaw(bufr, (const uint8_t *)"", 0);
+	}
+	appendRowRaw(bufr, (const uint8_t *)"", 0);
+	if (bufr->crlf ? scan.lf_lines : scan.crlf_lines)
+		bufr->saved_rows = first; /* line endings normalised */
+	free(p);
+	bufr->open_size = bufr->follow_off + (off_t)got;
+	bufr->follow_off += (off_t)tail;
+	bufr->open_mtime = st->st_mtime;
+	bufr->open_mtime_nsec = mtimeNsec(st);
+
+	if (pin) {
+		bufr->cy = bufr->numrows - 1;
+		bufr->cx = 0;
+	}
+	for (int i = 0; i < E.nwindows; i++) {
+		struct window *w = E.windows[i];
+		if (w->buf == bufr && !w->focused && w->cy == old_last) {
+			w->cy = bufr->numrows - 1;
+			w->cx = 0;
+		}
+	}
+	clampPositions(bufr);
+
+	/* The rows hold the text up to the bad byte; the file has more. */
+	if (scan.nul || scan.bad_utf8)
+		stopFollowing(bufr, scan.nul ? "grew by binary data" :
+					       "grew by invalid UTF-8");
+}
+
+void followMode(void) {
+	struct buffer *buf = E.buf;
+
+	if (buf->follow) {
+		buf->follow = 0;
+		setStatusMessage("Follow mode disabled");
+		return;
+	}
+	if (buf->filename == NULL || buf->special_buffer) {
+		setStatusMessage("Buffer is not visiting a file");
+		return;
+	}
+	if (buf->dirty) {
+		setStatusMessage("Save or revert the buffer before following");
+		return;
+	}
+
+	char *iopath = expandTilde(buf->filename);
+	int fd = open(iopath, O_RDONLY);
+	free(iopath);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		setStatusMessage("Can only follow a regular file");
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+	off_t off = st.st_size;
+	if (!buf->view)
+		off = lastLineStart(fd, st.st_size);
+	close(fd);
+	if (buf->external_mod || off < 0 || st.st_size != buf->open_size ||
+	    st.st_mtime != buf->open_mtime) {
+		buf->external_mod = 1;
+		setStatusMessage("File changed on disk; revert before following");
+		return;
+	}
+
+	buf->follow = 1;
+	buf->follow_off = off;
+	buf->follow_ino = st.st_ino;
+	buf->cy = viewShow(buf, VIEW_LAST_LINE);
+	buf->cx = 0;
+	setStatusMessage("Follow mode enabled");
+}
+
 /*** Backup and Write Strategy (Vim backupcopy=yes style) ***/
 
 static int createBackupExclusive(const char *name) {
@@ -812,32 +1936,6 @@ static int backup_create(const char *path, char *backup, size_t backup_size) {
 	return -1;
 }
 
-/*
- * Write all bytes to fd, retrying on EINTR and handling short writes.
- */
-static int writeToFile(int fd, const char *buf, size_t len) {
-	size_t total = 0;
-
-	while (total < len) {
-		ssize_t n = write(fd, buf + total, len - total);
-
-		if (n < 0) {
-			if (errno == EINTR)
-				continue;
-			return -1;
-		}
-
-		if (n == 0) {
-			errno = EIO;
-			return -1;
-		}
-
-		total += (size_t)n;
-	}
-
-	return 0;
-}
-
 /*
  * Copy all bytes from from_fd to to_fd.
  */
@@ -877,9 +1975,78 @@ static int copyFd(int from_fd, int to_fd) {
 	}
 }
 
+#ifdef __linux__
+/* Put both descriptors back to offset 0 with to_fd empty, so a failed
+ * kernel copy can be retried by the next method. */
+static int rewindCopy(int from_fd, int to_fd) {
+	if (lseek(from_fd, 0, SEEK_SET) == -1 || ftruncate(to_fd, 0) == -1 ||
+	    lseek(to_fd, 0, SEEK_SET) == -1)
+		return -1;
+	return 0;
+}
+#endif
+
+/*
+ * Copy size bytes from from_fd to to_fd without passing them through
+ * the editor: a reflink where the filesystem can share extents (btrfs,
+ * XFS), else copy_file_range(), else sendfile().
+ *
+ * On -1 both descriptors are at offset 0 and to_fd is empty, so the
+ * caller can fall back to copyFd().
+ */
+static int copyFdKernel(int from_fd, int to_fd, off_t size) {
+#ifdef __linux__
+#ifdef FICLONE
+	if (ioctl(to_fd, FICLONE, from_fd) == 0)
+		return 0;
+#endif
+
+	off_t done = 0;
+#ifdef SYS_copy_file_range
+	while (done < size) {
+		ssize_t n = syscall(SYS_copy_file_range, from_fd, NULL, to_fd,
+				    NULL, (size_t)(size - done), 0u);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		done += n;
+	}
+	if (done == size)
+		return 0;
+	if (rewindCopy(from_fd, to_fd) == -1)
+		return -1;
+	done = 0;
+#endif
+
+	while (done < size) {
+		ssize_t n = sendfile(to_fd, from_fd, &done,
+				     (size_t)(size - done));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+	}
+	if (done == size)
+		return 0;
+	if (rewindCopy(from_fd, to_fd) == -1)
+		return -1;
+#else
+	(void)from_fd;
+	(void)to_fd;
+	(void)size;
+#endif
+	errno = ENOSYS;
+	return -1;
+}
+
 /*
  * Create a backup of path using backup_create(), then verify that the
- * backup was fully written, fsynced, and closed.
+ * backup was fully written, fsynced, and closed, and that it is as
+ * long as the original.
+ *
+ * Regular files are copied in the kernel where it can (copyFdKernel),
+ * so a large file's backup costs no copy through the editor.
  *
  * On failure, remove the partial backup and return -1.
  */
@@ -888,6 +2055,7 @@ static int makeVerifiedBackup(const char *path, char *backup_path,
 	int bfd;
 	int fd;
 	int saved_errno;
+	struct stat st, bst;
 
 	bfd = backup_create(path, backup_path, backup_path_size);
 	if (bfd == -1)
@@ -902,13 +2070,24 @@ static int makeVerifiedBackup(const char *path, char *backup_path,
 		return -1;
 	}
 
-	if (copyFd(fd, bfd) == -1) {
-		saved_errno = errno;
-		close(fd);
-		close(bfd);
-		unlink(backup_path);
-		errno = saved_errno;
-		return -1;
+	if (fstat(fd, &st) == -1)
+		goto fail;
+
+	if (!S_ISREG(st.st_mode) || copyFdKernel(fd, bfd, st.st_size) == -1) {
+		if (copyFd(fd, bfd) == -1)
+			goto fail;
+	}
+
+	/* A copy that stopped short, or a file that changed under it,
+	 * is not a backup. */
+	if (S_ISREG(st.st_mode)) {
+		struct stat now;
+		if (fstat(fd, &now) == -1 || fstat(bfd, &bst) == -1)
+			goto fail;
+		if (now.st_size != st.st_size || bst.st_size != st.st_size) {
+			errno = EIO;
+			goto fail;
+		}
 	}
 
 	if (close(fd) == -1) {
@@ -935,11 +2114,91 @@ static int makeVerifiedBackup(const char *path, char *backup_path,
 	}
 
 	return 0;
+
+fail:
+	saved_errno = errno;
+	close(fd);
+	close(bfd);
+	unlink(backup_path);
+	errno = saved_errno;
+	return -1;
+}
+
+/* Whether the file open as fd holds row 'row' of bufr and the
+ * separator after it where writeRows() would put them.  False on any
+ * failure to read. */
+static int rowOnDisk(int fd, struct buffer *bufr, int row) {
+	const erow *r = bufRow(bufr, row);
+	const char *newline = bufr->crlf ? "\r\n" : "\n";
+	size_t len = (size_t)r->size + strlen(newline);
+	off_t off = writtenOffset(bufr, row);
+	char chunk[4096];
+	size_t done = 0;
+	while (done < len) {
+		size_t want = len - done;
+		if (want > sizeof(chunk))
+			want = sizeof(chunk);
+		ssize_t n = pread(fd, chunk, want, off + (off_t)done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return 0;
+		for (size_t i = 0; i < (size_t)n; i++, done++) {
+			char want_c = done < (size_t)r->size ?
+					      (char)r->chars[done] :
+					      newline[done - (size_t)r->size];
+			if (chunk[i] != want_c)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+/* How many leading rows the file at path, open for the save and
+ * described by st, already holds: saved_rows, if it is the file they
+ * were loaded from or last saved to, its size and mtime (to the
+ * nanosecond, where recorded) say nothing has written it since, and
+ * the last of those rows is there on disk.  A rewrite of the same
+ * size inside the clock's resolution could pass the first checks, so
+ * any doubt gives 0: the whole file written, as before. */
+static int unchangedRows(const char *path, struct buffer *bufr,
+			 const struct stat *st) {
+	if (!S_ISREG(st->st_mode) || bufr->open_mtime == 0 ||
+	    bufr->external_mod || st->st_ino != bufr->open_ino ||
+	    st->st_mtime != bufr->open_mtime ||
+	    mtimeNsec(st) != bufr->open_mtime_nsec ||
+	    st->st_size != bufr->open_size)
+		return 0;
+
+	int rows = bufr->saved_rows;
+	if (rows > bufr->numrows - 1)
+		rows = bufr->numrows - 1;
+	/* Rows appended after a last line with no separator on disk:
+	 * that line is rewritten to gain one. */
+	while (rows > 0 && writtenOffset(bufr, rows) > st->st_size)
+		rows--;
+	if (rows == 0)
+		return 0;
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return 0;
+	struct stat rst;
+	if (fstat(fd, &rst) != 0 || rst.st_ino != st->st_ino ||
+	    rst.st_dev != st->st_dev || !rowOnDisk(fd, bufr, rows - 1))
+		rows = 0;
+	close(fd);
+	return rows;
 }
 
 /*
- * Open the target file, truncate it, write the new contents, fsync it,
- * and close it.
+ * Open the target file, write the buffer's rows to it, cut it to
+ * length, fsync it, and close it.
+ *
+ * Only the rows after those the file already holds are written (see
+ * unchangedRows()), so appending a line to a large file costs the
+ * line.  A file that is not the one loaded or last saved, or has
+ * changed since, is written whole.
  *
  * If require_regular is true, fail if the target descriptor is not a
  * regular file.  This is used when a backup exists, because deleting a
@@ -947,7 +2206,7 @@ static int makeVerifiedBackup(const char *path, char *backup_path,
  *
  * On failure, set *damaged if the target file may now be damaged.
  */
-static int writeInPlace(const char *path, const char *buf, size_t len,
+static int writeInPlace(const char *path, struct buffer *bufr,
 			int require_regular, int *damaged) {
 	int fd;
 	struct stat st;
@@ -956,22 +2215,30 @@ static int writeInPlace(const char *path, const char *buf, size_t len,
 	if (damaged)
 		*damaged = 0;
 
-	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	fd = open(path, O_WRONLY | O_CREAT, 0644);
 	if (fd == -1)
 		return -1;
 
-	if (writeToFile(fd, buf, len) == -1)
-		goto fail;
-
 	if (fstat(fd, &st) == -1)
 		goto fail;
 
-	if (S_ISREG(st.st_mode)) {
-		if (fsync(fd) == -1)
+	if (!S_ISREG(st.st_mode)) {
+		if (require_regular) {
+			errno = EIO;
+			goto fail;
+		}
+		if (writeRows(fd, bufr) == -1)
+			goto fail;
+	} else {
+		int from = unchangedRows(path, bufr, &st);
+		off_t off = writtenOffset(bufr, from);
+		if (from == 0 && ftruncate(fd, 0) == -1)
+			goto fail;
+		if (lseek(fd, off, SEEK_SET) == -1 ||
+		    writeRowsFrom(fd, bufr, from) == -1 ||
+		    ftruncate(fd, (off_t)writtenLen(bufr)) == -1 ||
+		    fsync(fd) == -1)
 			goto fail;
-	} else if (require_regular) {
-		errno = EIO;
-		goto fail;
 	}
 
 	if (close(fd) == -1) {
@@ -1029,6 +2296,44 @@ static int preSaveCheck(struct buffer *buf) {
 			"File has changed on disk since it was read. Save anyway? (y or n)");
 }
 
+/* Bookkeeping after len bytes of buf reached iopath.  'clean' says the
+ * rows still hold what was written; a background save whose buffer
+ * was edited meanwhile passes 0, and the buffer stays dirty.  Either
+ * way the file on disk is now ours, so the modification baseline
+ * moves to it. */
+static void saveSucceeded(struct buffer *buf, const char *iopath,
+			  size_t len, int clean) {
+	if (clean) {
+		markBufferClean(buf);
+		bufCompactRows(buf);
+		buf->saved_rows = INT_MAX;
+	}
+
+	struct stat save_st;
+	if (stat(iopath, &save_st) == 0) {
+		buf->open_mtime = save_st.st_mtime;
+		buf->open_mtime_nsec = mtimeNsec(&save_st);
+		buf->open_size = save_st.st_size;
+		buf->open_ino = save_st.st_ino;
+		/* What was written ends in a newline, or is empty. */
+		buf->follow_off = save_st.st_size;
+		buf->follow_ino = save_st.st_ino;
+	}
+
+	buf->external_mod = 0;
+	buf->internal_mod = 1;
+	watchBuffer(buf); /* a save-as may have moved it */
+
+	const char *fmt = clean ? "Wrote %d bytes to %s" :
+				  "Wrote %d bytes to %s; edited since";
+	int n = snprintf(NULL, 0, fmt, (int)len, buf->filename);
+	char *showName = leftTruncate(buf->filename, nameFit(buf->filename, n));
+
+	setStatusMessage(fmt, (int)len, showName);
+
+	free(showName);
+}
+
 /*
  * Save the current buffer.
  *
@@ -1041,7 +2346,6 @@ static int preSaveCheck(struct buffer *buf) {
  */
 static void saveBuffer(int skip_backup) {
 	char *iopath = NULL;
-	char *buf = NULL;
 	size_t len = 0;
 
 	char backup_path[PATH_MAX] = { 0 };
@@ -1083,12 +2387,7 @@ static void saveBuffer(int skip_backup) {
 		return;
 	}
 
-	buf = rowsToString(E.buf, &len);
-	if (buf == NULL) {
-		free(iopath);
-		setStatusMessage("Save failed: cannot read buffer");
-		return;
-	}
+	len = writtenLen(E.buf);
 
 	/*
 	 * Attempt to create a backup unless the user explicitly requested
@@ -1136,7 +2435,7 @@ static void saveBuffer(int skip_backup) {
 	 * the damaged file.
 	 */
 	while (1) {
-		int rc = writeInPlace(iopath, buf, len, have_backup, &damaged);
+		int rc = writeInPlace(iopath, E.buf, have_backup, &damaged);
 		relockAll();
 
 		if (rc == 0) {
@@ -1189,37 +2488,9 @@ static void saveBuffer(int skip_backup) {
 		}
 	}
 
-	markBufferClean(E.buf);
-
-	for (int i = 0; i < E.buf->numrows; i++) {
-		erow *row = &E.buf->row[i];
-
-		if (row->charcap > row->size + 1) {
-			row->chars = xrealloc(row->chars, row->size + 1);
-			row->charcap = row->size + 1;
-		}
-	}
-
-	struct stat save_st;
-	if (stat(iopath, &save_st) == 0) {
-		E.buf->open_mtime = save_st.st_mtime;
-		E.buf->open_size = save_st.st_size;
-	}
-
-	E.buf->external_mod = 0;
-	E.buf->internal_mod = 1;
-
-	int n = snprintf(NULL, 0, "Wrote %d bytes to %s", (int)len,
-			 E.buf->filename);
-	char *showName =
-		leftTruncate(E.buf->filename, nameFit(E.buf->filename, n));
-
-	setStatusMessage("Wrote %d bytes to %s", (int)len, showName);
-
-	free(showName);
+	saveSucceeded(E.buf, iopath, len, 1);
 
 out:
-	free(buf);
 	free(iopath);
 }
 
@@ -1229,9 +2500,21 @@ out:
  * A nonzero universal argument means: skip backup and perform an unsafe
  * save.
  */
+/* A view's rows are one window of its file: writing them anywhere
+ * would save a fragment. */
+static int refuseView(const struct buffer *buf) {
+	if (buf->view == NULL)
+		return 0;
+	setStatusMessage("Can't save a large-file view");
+	return 1;
+}
+
 void save(int uarg) {
 	int skip_backup = (uarg != 0);
 
+	if (refuseView(E.buf))
+		return;
+	awaitBackgroundSave(E.buf);
 	if (!preSaveCheck(E.buf)) {
 		setStatusMessage("Save aborted.");
 		return;
@@ -1247,10 +2530,13 @@ void save(int uarg) {
 }
 
 void saveAs(void) {
+	if (refuseView(E.buf))
+		return;
 	if (E.recording || E.playback) {
 		setStatusMessage("Not available during macro");
 		return;
 	}
+	awaitBackgroundSave(E.buf);
 
 	char *new_filename =
 		(char *)editorPrompt(E.buf, "Save as: ", PROMPT_FILES, NULL);
@@ -1283,6 +2569,326 @@ void saveAs(void) {
 	saveBuffer(0);
 }
 
+/*** Background save ***
+ *
+ * A save on a slow filesystem blocks in the backup copy, the write and
+ * the fsync, and the editor with it.  save-buffer-in-background forks
+ * instead.  The fork is the snapshot: the child's copy-on-write image
+ * of the rows is the buffer as it stood, whatever the parent does to
+ * its own.  The child runs the same backup and writeInPlace() steps as
+ * saveBuffer(), reports through a pipe, and exits; the parent goes on
+ * editing, and the main loop, which waits on the pipe with the
+ * terminal, picks the result up as soon as it is written.
+ *
+ * The child cannot ask questions, so the prompts of a foreground save
+ * become failures it reports: a backup that cannot be made aborts
+ * before the file is touched, and a failed write is not retried.
+ * Either way the status line says so and C-x C-s is still there.
+ *
+ * The buffer is marked clean only if no edit landed after the fork,
+ * which buf->changes counts.
+ *
+ * While it writes, the child sends on the pipe how far into the file
+ * it has got, as a long long, and the status line shows that as a
+ * percentage of the file.  Its result follows BG_SAVE_END. */
+
+#define BG_SAVE_END (-1LL)
+
+struct bgSaveResult {
+	int ok;
+	int backup_failed; /* nothing was written */
+	int err;
+	int damaged;
+	int have_backup;
+	char backup_path[PATH_MAX];
+};
+
+static struct {
+	pid_t pid; /* 0 when no save is in flight */
+	int fd;	   /* read end of the result pipe */
+	struct buffer *buf;
+	unsigned long changes; /* buf->changes at the fork */
+	size_t len;
+	char *iopath;
+} bgSave;
+
+static void sendResult(int fd, const struct bgSaveResult *r) {
+	long long end = BG_SAVE_END;
+	if (writeAll(fd, &end, sizeof(end)) == 0)
+		IGNORE_RETURN(writeAll(fd, r, sizeof(*r)));
+}
+
+static void backgroundSaveChild(int fd, struct buffer *buf,
+				const char *iopath) {
+	/* Inherited handlers belong to the editor: the fatal ones
+	 * restore the parent's terminal, and the job-control ones
+	 * redraw it.  Hanging up the terminal must not cut a save
+	 * short. */
+	signal(SIGSEGV, SIG_DFL);
+	signal(SIGABRT, SIG_DFL);
+#ifdef SIGBUS
+	signal(SIGBUS, SIG_DFL);
+#endif
+	signal(SIGTSTP, SIG_DFL);
+	signal(SIGCONT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGHUP, SIG_IGN);
+	signal(SIGINT, SIG_IGN);
+
+	struct bgSaveResult r;
+	memset(&r, 0, sizeof(r));
+
+	struct stat st;
+	if (stat(iopath, &st) == 0 && S_ISREG(st.st_mode)) {
+		if (makeVerifiedBackup(iopath, r.backup_path,
+				       sizeof(r.backup_path)) != 0) {
+			r.backup_failed = 1;
+			r.err = errno;
+			sendResult(fd, &r);
+			_exit(1);
+		}
+		r.have_backup = 1;
+	}
+
+	saveProgressFd = fd;
+	if (writeInPlace(iopath, buf, r.have_backup, &r.damaged) == 0) {
+		if (r.have_backup)
+			unlink(r.backup_path);
+		r.ok = 1;
+	} else {
+		r.err = errno;
+	}
+	sendResult(fd, &r);
+	_exit(r.ok ? 0 : 1);
+}
+
+/* "Saving NAME in the background...", and how far it has got when
+ * 'percent' is not negative. */
+static void showBackgroundSave(const char *filename, int percent) {
+	char done[16] = "";
+	if (percent >= 0)
+		snprintf(done, sizeof(done), " %d%%", percent);
+	int n = snprintf(NULL, 0, "Saving %s in the background...%s",
+			 filename, done);
+	char *showName = leftTruncate(filename, nameFit(filename, n));
+	setStatusMessage("Saving %s in the background...%s", showName, done);
+	free(showName);
+}
+
+void saveInBackground(void) {
+	struct buffer *buf = E.buf;
+
+	if (refuseView(buf))
+		return;
+	if (bgSave.pid != 0) {
+		setStatusMessage("A background save is already running");
+		return;
+	}
+	if (E.recording || E.playback) {
+		setStatusMessage("Not available during macro");
+		return;
+	}
+	/* Naming the file needs the prompt, so does a foreground save. */
+	if (buf->filename == NULL || buf->special_buffer) {
+		save(0);
+		return;
+	}
+	if (!preSaveCheck(buf)) {
+		setStatusMessage("Save aborted.");
+		return;
+	}
+	if (!buf->dirty && !buf->external_mod) {
+		setStatusMessage("(No changes need to be saved)");
+		return;
+	}
+	if (!checkUTF8Validity(buf)) {
+		setStatusMessage("Save failed: buffer contains invalid UTF-8");
+		return;
+	}
+
+	char *iopath = expandTilde(buf->filename);
+	int p[2];
+	if (iopath == NULL || pipe(p) == -1) {
+		free(iopath);
+		setStatusMessage("Save failed: %s", strerror(errno));
+		return;
+	}
+
+	waitPrefetch();
+	pid_t pid = fork();
+	if (pid == -1) {
+		int err = errno;
+		close(p[0]);
+		close(p[1]);
+		free(iopath);
+		setStatusMessage("Save failed: %s", strerror(err));
+		return;
+	}
+	if (pid == 0) {
+		close(p[0]);
+		backgroundSaveChild(p[1], buf, iopath);
+	}
+	close(p[1]);
+	(void)fcntl(p[0], F_SETFD, FD_CLOEXEC);
+
+	bgSave.pid = pid;
+	bgSave.fd = p[0];
+	bgSave.buf = buf;
+	bgSave.changes = buf->changes;
+	bgSave.len = writtenLen(buf);
+	bgSave.iopath = iopath;
+
+	showBackgroundSave(buf->filename, -1);
+}
+
+/* read() until len bytes or end of file.  Returns the count. */
+static size_t readFull(int fd, void *p, size_t len) {
+	size_t got = 0;
+	while (got < len) {
+		ssize_t n = read(fd, (char *)p + got, len - got);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		got += (size_t)n;
+	}
+	return got;
+}
+
+/* Read the child's next message.  A progress report goes to the status
+ * line, and 0 is returned.  Otherwise it is the child's result, or its
+ * end without one: *r is filled in and 1 returned.  Each message is
+ * written whole, so once the pipe is readable the read does not wait
+ * long. */
+static int readBackgroundSave(struct bgSaveResult *r) {
+	long long msg = BG_SAVE_END;
+	size_t got = readFull(bgSave.fd, &msg, sizeof(msg));
+	if (got == sizeof(msg) && msg >= 0) {
+		if (bgSave.buf != NULL && bgSave.len > 0)
+			showBackgroundSave(bgSave.buf->filename,
+					   (int)(msg * 100 /
+						 (long long)bgSave.len));
+		return 0;
+	}
+	memset(r, 0, sizeof(*r));
+	if (got < sizeof(msg) || msg != BG_SAVE_END ||
+	    readFull(bgSave.fd, r, sizeof(*r)) < sizeof(*r)) {
+		/* Killed, or died before reporting. */
+		memset(r, 0, sizeof(*r));
+		r->err = EIO;
+		r->damaged = 1;
+	}
+	return 1;
+}
+
+/* Report the result of a child that has been reaped, and clear
+ * bgSave. */
+static void backgroundSaveDone(const struct bgSaveResult *res) {
+	struct bgSaveResult r = *res;
+	struct buffer *buf = bgSave.buf;
+	close(bgSave.fd);
+
+	if (r.ok && buf != NULL) {
+		saveSucceeded(buf, bgSave.iopath, bgSave.len,
+			      buf->changes == bgSave.changes);
+	} else if (r.ok) {
+		setStatusMessage("Background save done; buffer was killed");
+	} else if (r.backup_failed) {
+		setStatusMessage("Background save failed: cannot create "
+				 "backup: %s",
+				 strerror(r.err));
+	} else if (r.damaged && r.have_backup) {
+		setStatusMessage("Background save failed: %s. File contents "
+				 "may be incomplete or corrupt; backup is in %s",
+				 strerror(r.err), r.backup_path);
+	} else if (r.damaged) {
+		setStatusMessage("Background save failed: %s. File may be "
+				 "damaged.",
+				 strerror(r.err));
+	} else {
+		setStatusMessage("Background save failed: %s",
+				 strerror(r.err));
+	}
+
+	free(bgSave.iopath);
+	memset(&bgSave, 0, sizeof(bgSave));
+}
+
+/* Wait for the child, which has sent its last message, and report. */
+static void reapBackgroundSave(const struct bgSaveResult *r) {
+	int status;
+	pid_t p;
+	do {
+		p = waitpid(bgSave.pid, &status, 0);
+	} while (p == -1 && errno == EINTR);
+	backgroundSaveDone(r);
+}
+
+/* Take in what the background save has sent, and reap it if it has
+ * finished.  Cheap when nothing is in flight; called when its result
+ * pipe is readable, on SIGCHLD, and once per main-loop pass.  Once the
+ * result, or the end of a child that died without one, is read, the
+ * child is past its last write and only exiting, so waiting for it is
+ * brief. */
+void pollBackgroundSave(void) {
+	if (bgSave.pid == 0)
+		return;
+	for (;;) {
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(bgSave.fd, &fds);
+		struct timeval tv = { 0, 0 };
+		if (select(bgSave.fd + 1, &fds, NULL, NULL, &tv) <= 0)
+			return;
+		struct bgSaveResult r;
+		if (readBackgroundSave(&r)) {
+			reapBackgroundSave(&r);
+			return;
+		}
+	}
+}
+
+int backgroundSaveRunning(void) {
+	return bgSave.pid != 0;
+}
+
+int backgroundSaveFd(void) {
+	return bgSave.pid != 0 ? bgSave.fd : -1;
+}
+
+static int savingInBackground(const struct buffer *buf) {
+	return bgSave.pid != 0 && bgSave.buf == buf;
+}
+
+/* Block until the background save, if any, finishes.  For quit, which
+ * must not report a buffer unsaved that is about to be clean, or exit
+ * under a child still writing. */
+void finishBackgroundSave(void) {
+	if (bgSave.pid == 0)
+		return;
+	struct bgSaveResult r;
+	while (!readBackgroundSave(&r))
+		;
+	reapBackgroundSave(&r);
+}
+
+/* A foreground save or a revert of a buffer the child is still writing
+ * would race it, and the child's older snapshot would land last over a
+ * buffer marked clean.  Let the child finish first; its result moves
+ * the modification baseline, so the check that follows sees our own
+ * write rather than an external change. */
+static void awaitBackgroundSave(const struct buffer *buf) {
+	if (savingInBackground(buf))
+		finishBackgroundSave();
+}
+
+/* A buffer being destroyed must not be written back to by a save that
+ * outlives it. */
+void forgetBackgroundSave(struct buffer *buf) {
+	if (bgSave.buf == buf)
+		bgSave.buf = NULL;
+}
+
 /* Switch the focused window to the named file.  If a buffer with that
  * filename already exists, reuse it; otherwise open a new one.
  * Returns the buffer on success, NULL on failure. */
@@ -1293,6 +2899,8 @@ struct buffer *switchToFile(const char *filename) {
 		E.buf = buf;
 		E.windows[windowFocusedIdx()]->buf = buf;
 		resetFileCheckThrottle();
+		if (loadDeferred(buf) != 0)
+			return NULL;
 		return buf;
 	}
 
@@ -1309,6 +2917,23 @@ struct buffer *switchToFile(const char *filename) {
 	return nb;
 }
 
+/* Add the named file to the buffer list without showing it, deferred.
+ * An existing buffer is left as it is.  Returns the buffer, or NULL
+ * on failure. */
+static struct buffer *addFile(const char *filename) {
+	struct buffer *buf = findBufferByName(filename);
+	if (buf)
+		return buf;
+	buf = newBuffer();
+	if (editorOpenDeferred(buf, filename) < 0) {
+		destroyBuffer(buf);
+		return NULL;
+	}
+	buf->next = E.headbuf;
+	E.headbuf = buf;
+	return buf;
+}
+
 /* Check whether a filename contains glob wildcard characters. */
 static int hasGlobChars(const char *s) {
 	for (; *s; s++) {
@@ -1349,6 +2974,15 @@ void findFile(int read_only) {
 			return;
 		}
 
+		/* Only the last match is shown, so only it is read now;
+		 * the rest are deferred. */
+		size_t shown = gl.gl_pathc;
+		for (size_t i = 0; i < gl.gl_pathc; i++) {
+			size_t plen = strlen(gl.gl_pathv[i]);
+			if (plen > 0 && gl.gl_pathv[i][plen - 1] != '/')
+				shown = i;
+		}
+
 		struct buffer *last = NULL;
 		int opened = 0;
 		for (size_t i = 0; i < gl.gl_pathc; i++) {
@@ -1356,7 +2990,9 @@ void findFile(int read_only) {
 			size_t plen = strlen(gl.gl_pathv[i]);
 			if (plen > 0 && gl.gl_pathv[i][plen - 1] == '/')
 				continue;
-			struct buffer *buf = switchToFile(gl.gl_pathv[i]);
+			struct buffer *buf = i == shown ?
+						     switchToFile(gl.gl_pathv[i]) :
+						     addFile(gl.gl_pathv[i]);
 			if (buf) {
 				if (read_only) {
 					/* Explicit user request: not
@@ -1462,44 +3098,25 @@ static int insertFileAtPathBody(struct buffer *buf, const char *path,
 		return 1;
 	}
 
-	/* Pre-scan for null bytes */
-	if (fileContainsNullBytes(fp)) {
-		fclose(fp);
-		setStatusMessage("File contains null bytes (binary file?)");
-		return 1;
-	}
-
 	/* Load into a temporary buffer so we can validate before
-	 * modifying the real buffer.  Split on newlines exactly as
+	 * modifying the real buffer.  Split and validated exactly as
 	 * editorOpen does, so tmpbuf holds the normal representation. */
 	struct buffer *tmpbuf = newBuffer();
 	bufferResetRows(tmpbuf);
 
-	char *line = NULL;
-	size_t linecap = 0;
-	ssize_t linelen;
-	int ends_with_newline = 0;
-
-	while ((linelen = emil_getline(&line, &linecap, fp)) != -1) {
-		ends_with_newline = (linelen > 0 && line[linelen - 1] == '\n');
-		while (linelen > 0 && (line[linelen - 1] == '\n' ||
-				       line[linelen - 1] == '\r')) {
-			linelen--;
-		}
-		appendRowRaw(tmpbuf, (const uint8_t *)line, linelen);
-	}
-	if (tmpbuf->numrows == 0 || ends_with_newline)
-		appendRowRaw(tmpbuf, (const uint8_t *)"", 0);
-
-	free(line);
+	struct rowScan scan;
+	readRows(fileno(fp), tmpbuf, &scan);
 	fclose(fp);
 
-	/* Validate UTF-8 before inserting */
-	if (!checkUTF8Validity(tmpbuf)) {
+	if (scan.nul || scan.bad_utf8) {
 		destroyBuffer(tmpbuf);
-		setStatusMessage("Failed UTF-8 validation");
+		setStatusMessage(scan.nul ?
+					 "File contains null bytes (binary file?)" :
+					 "Failed UTF-8 validation");
 		return 1;
 	}
+	if (tmpbuf->numrows == 0 || !scan.no_final_newline)
+		appendRowRaw(tmpbuf, (const uint8_t *)"", 0);
 
 	int lines_inserted = bufferLineCount(tmpbuf);
 
@@ -1515,23 +3132,23 @@ static int insertFileAtPathBody(struct buffer *buf, const char *path,
 
 		size_t rawlen = 0;
 		char *raw = rowsToString(tmpbuf, &rawlen);
-		struct dbuf d = DBUF_INIT;
-		dbuf_append(&d, (const uint8_t *)raw, (int)rawlen);
-		if (rawlen == 0 || raw[rawlen - 1] != '\n')
-			dbuf_byte(&d, '\n');
-		free(raw);
-
-		int byte_len;
-		uint8_t *bytes = dbuf_detach(&d, &byte_len);
+		if (rawlen == 0 || raw[rawlen - 1] != '\n') {
+			/* rowsToString allocated rawlen + 1 for its NUL,
+			 * which the newline can take instead. */
+			raw[rawlen++] = '\n';
+		}
 
+		/* One mutateInsert, so however many lines the file has
+		 * they reach the row array through a single insertRows. */
 		int ex, ey;
-		mutateInsert(buf, 0, saved_cy, bytes, byte_len, &ex, &ey);
-		free(bytes);
+		mutateInsert(buf, 0, saved_cy, (const uint8_t *)raw,
+			     (int)rawlen, &ex, &ey);
+		free(raw);
 
 		(void)ex;
 		(void)ey;
 		buf->cy = saved_cy + lines_inserted - 1;
-		buf->cx = buf->row[buf->cy].size;
+		buf->cx = bufRow(buf, buf->cy)->size;
 	}
 
 	destroyBuffer(tmpbuf);
@@ -1840,64 +3457,205 @@ char *readAllFromFd(int fd, size_t *out_len) {
 	return buf;
 }
 
+/* The *stdin* buffer.  Stdin content is read-only: the pseudo-file
+ * has no disk backing to save to. */
+static struct buffer *newStdinBuffer(void) {
+	struct buffer *buf = newBuffer();
+	buf->filename = xstrdup("*stdin*");
+	buf->read_only = 1;
+	buf->word_wrap = 1;
+	return buf;
+}
+
+/* Append the complete lines of p to buf, ahead of its final empty row
+ * (kept empty: the buffer stays read-only while the stream is open),
+ * and at eof the unterminated remainder too.  The rows are built by
+ * scanRows(), as editorOpen() builds them, so the same NUL-free UTF-8
+ * invariant holds (row primitives such as rowDelChar rely on it).
+ * Returns the bytes taken, or -1 if they are not valid text, in which
+ * case the rows hold the lines before the bad one. */
+static ssize_t appendStdinLines(struct buffer *buf, const uint8_t *p,
+				size_t len, int eof) {
+	size_t end = len;
+	if (!eof)
+		while (end > 0 && p[end - 1] != '\n')
+			end--;
+	if (end == 0)
+		return 0;
+
+	truncateRowsRaw(buf, buf->numrows - 1);
+	struct rowScan scan;
+	scanRows(buf, p, end, &scan);
+	appendRowRaw(buf, (const uint8_t *)"", 0);
+	if (scan.nul || scan.bad_utf8)
+		return -1;
+	return (ssize_t)end;
+}
+
 /*
- * Load piped stdin data into a new editor buffer.  The data is split
- * on newline boundaries and inserted row by row, matching the same
- * approach used by editorOpen().  The buffer is named "*stdin*" and
- * marked read-only.
+ * Load piped stdin data into a new editor buffer named "*stdin*".
  *
  * Returns the new buffer, or NULL if the data contains null bytes
- * or is not valid UTF-8.  editorOpen() enforces the same invariant
- * for files; every load path must, because row primitives (see
- * rowDelChar) assume all buffer content is valid UTF-8.
+ * or is not valid UTF-8.
  */
 struct buffer *loadStdinBuffer(const char *data, size_t len) {
-	/* Reject binary data: null bytes can't be represented */
-	if (memchr(data, '\0', len) != NULL) {
+	struct buffer *buf = newStdinBuffer();
+	if (appendStdinLines(buf, (const uint8_t *)data, len, 1) < 0) {
+		destroyBuffer(buf);
 		return NULL;
 	}
+	return buf;
+}
 
-	struct buffer *buf = newBuffer();
-	buf->filename = xstrdup("*stdin*");
-	bufferResetRows(buf); /* rebuilt from scratch below */
-
-	size_t start = 0;
-	for (size_t i = 0; i < len; i++) {
-		if (data[i] == '\n') {
-			/* Strip trailing \r for DOS line endings */
-			size_t end = i;
-			if (end > start && data[end - 1] == '\r')
-				end--;
-			appendRowRaw(buf, (const uint8_t *)&data[start],
-				     (int)(end - start));
-			start = i + 1;
+/* Piped stdin is read as it arrives rather than slurped before the
+ * editor starts, so `make 2>&1 | emil -` shows the first lines while
+ * make is still running.  The main loop selects on the pipe alongside
+ * the terminal and calls readStdinStream() when it has data.  Only
+ * complete lines become rows; an unfinished one waits in 'pending'
+ * for the rest of it, which also keeps a UTF-8 sequence split across
+ * two reads whole.  So the input is held once, as rows, plus at most
+ * a read's worth and a partial line. */
+
+#define STDIN_READ_CHUNK (64 * 1024)
+#define STDIN_READ_BUDGET (4 * 1024 * 1024) /* per call: keys go between */
+
+static struct {
+	int fd; /* -1: no stream */
+	struct buffer *buf;
+	uint8_t *pending;
+	size_t len, cap;
+	size_t total;
+} stdinStream = { -1, NULL, NULL, 0, 0, 0 };
+
+static void closeStdinStream(void) {
+	close(stdinStream.fd);
+	free(stdinStream.pending);
+	stdinStream.fd = -1;
+	stdinStream.buf = NULL;
+	stdinStream.pending = NULL;
+	stdinStream.len = 0;
+	stdinStream.cap = 0;
+}
+
+struct buffer *openStdinStream(int fd) {
+	(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+	stdinStream.fd = fd;
+	stdinStream.buf = newStdinBuffer();
+	stdinStream.total = 0;
+	setStatusMessage("Reading stdin...");
+	return stdinStream.buf;
+}
+
+int stdinStreamFd(void) {
+	return stdinStream.fd;
+}
+
+/* The pipe closed without a byte: an empty *stdin* buffer is only
+ * clutter, so take it out of the list and off any window showing it,
+ * as revert() swaps a buffer out.  Kept if it is the only buffer. */
+static void dropStdinBuffer(struct buffer *buf) {
+	struct buffer *prev = NULL;
+	for (struct buffer *b = E.headbuf; b != NULL && b != buf; b = b->next)
+		prev = b;
+	struct buffer *next = buf->next ? buf->next : prev;
+	if (next == NULL)
+		return;
+	if (prev)
+		prev->next = buf->next;
+	else
+		E.headbuf = buf->next;
+	for (int i = 0; i < E.nwindows; i++)
+		if (E.windows[i]->buf == buf)
+			E.windows[i]->buf = next;
+	if (E.buf == buf)
+		E.buf = next;
+	if (E.edbuf == buf)
+		E.edbuf = next;
+	destroyBuffer(buf);
+}
+
+void readStdinStream(void) {
+	if (stdinStream.fd < 0)
+		return;
+
+	struct buffer *buf = stdinStream.buf;
+	size_t budget = STDIN_READ_BUDGET;
+	int eof = 0;
+	const char *stopped = NULL;
+	while (budget > 0) {
+		if (stdinStream.cap - stdinStream.len < STDIN_READ_CHUNK) {
+			stdinStream.cap = stdinStream.len + STDIN_READ_CHUNK;
+			stdinStream.pending =
+				xrealloc(stdinStream.pending, stdinStream.cap);
+		}
+		ssize_t n = read(stdinStream.fd,
+				 stdinStream.pending + stdinStream.len,
+				 STDIN_READ_CHUNK);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && errno == EAGAIN)
+			break;
+		if (n <= 0) {
+			eof = 1;
+			break;
+		}
+		stdinStream.len += (size_t)n;
+		stdinStream.total += (size_t)n;
+		budget -= (size_t)n < budget ? (size_t)n : budget;
+		if (stdinStream.total > EMIL_MAX_FILE_SIZE) {
+			eof = 1;
+			stopped = "Exceeds 1 GiB limit; input truncated";
+			break;
 		}
-	}
-	/* Handle a final line with no trailing newline. */
-	if (start < len) {
-		size_t end = len;
-		if (end > start && data[end - 1] == '\r')
-			end--;
-		appendRowRaw(buf, (const uint8_t *)&data[start],
-			     (int)(end - start));
 	}
 
-	/* Terminate unconditionally, as editorOpen does: piped input
-	 * without a final newline would otherwise leave the last row
-	 * non-empty, breaking the invariant in buffer.h. */
-	appendRowRaw(buf, (const uint8_t *)"", 0);
+	/* A cursor on the last row follows the input, once there is some;
+	 * one left at the top stays there.  So do other windows'. */
+	int old_last = buf->numrows - 1;
+	int pin = old_last > 0 && buf->cy == old_last;
+	ssize_t used = appendStdinLines(buf, stdinStream.pending,
+					stdinStream.len, eof);
+	if (used < 0) {
+		eof = 1;
+		stopped = "Failed UTF-8 validation; input truncated";
+	} else {
+		stdinStream.len -= (size_t)used;
+		memmove(stdinStream.pending, stdinStream.pending + used,
+			stdinStream.len);
+	}
+	if (pin) {
+		buf->cy = buf->numrows - 1;
+		buf->cx = 0;
+	}
+	for (int i = 0; i < E.nwindows; i++) {
+		struct window *w = E.windows[i];
+		if (w->buf == buf && !w->focused && old_last > 0 &&
+		    w->cy == old_last) {
+			w->cy = buf->numrows - 1;
+			w->cx = 0;
+		}
+	}
 
-	/* Validate UTF-8 encoding, mirroring editorOpen: the null-byte
-	 * check above only catches a subset of binary input. */
-	if (!checkUTF8Validity(buf)) {
-		destroyBuffer(buf);
-		return NULL;
+	if (eof) {
+		closeStdinStream();
+		if (stdinStream.total == 0) {
+			setStatusMessage("stdin: no input");
+			dropStdinBuffer(buf);
+		} else if (stopped)
+			setStatusMessage("stdin: %s", stopped);
+		else
+			setStatusMessage("stdin: %d lines",
+					 bufferLineCount(buf));
 	}
+}
 
-	/* Stdin content is read-only: the *stdin* pseudo-file has no
-	 * disk backing to save to. 
-	 */
-	buf->read_only = 1;
-	buf->word_wrap = 1;
-	return buf;
+int stdinStreamFills(const struct buffer *buf) {
+	return stdinStream.fd >= 0 && stdinStream.buf == buf;
+}
+
+/* buf is going away: stop filling it. */
+void forgetStdinStream(struct buffer *buf) {
+	if (stdinStream.fd >= 0 && stdinStream.buf == buf)
+		closeStdinStream();
 }
@@ -29,13 +29,58 @@ void relockAll(void);
 void checkFileModified(void);
 void initFileCheck(void);
 void resetFileCheckThrottle(void);
+void watchBuffer(struct buffer *buf);
+void unwatchBuffer(struct buffer *buf);
+int fileWatchFd(void);
+int readFileWatch(void);
 
 /* File I/O operations */
 char *rowsToString(struct buffer *bufr, size_t *buflen);
+int writeRows(int fd, struct buffer *bufr);
+void toggleLineEndings(void);
 int editorOpen(struct buffer *bufr, const char *filename);
+
+/* editorOpen() of names[i] into bufs[i], for each of n files at once.
+ * The reading and splitting into rows run on a thread per core; the
+ * rest runs on this one, in order, stopping at the first failure,
+ * whose status message is left set.  Returns n, or the index of the
+ * file that failed.  With defer set, every file but the last is
+ * opened as by editorOpenDeferred(), and only the files that cannot
+ * be deferred are read at once. */
+int editorOpenFiles(struct buffer **bufs, char *const *names, int n,
+		    int defer);
+
+/* Open filename into bufr without reading it: the buffer is named and
+ * marked deferred, and loadDeferred() reads it when it is first shown.
+ * A file that is missing, not a regular file, too large or unreadable
+ * goes through editorOpen() at once instead, so that what can fail
+ * fails here.  Returns as editorOpen(). */
+int editorOpenDeferred(struct buffer *bufr, const char *filename);
+
+/* Read a deferred buffer's file now, as editorOpen() would have; a
+ * no-op for any other buffer.  Then starts the prefetch of the next
+ * deferred buffer after it.  A file that fails to load takes its
+ * buffer with it, as removeBuffer() does, and the status message
+ * names the file.  Returns 0, or -1 if bufr was removed. */
+int loadDeferred(struct buffer *bufr);
+
+/* Start reading, on a thread, the first deferred buffer after 'after'
+ * in the buffer list, unless one is already being read. */
+void prefetchDeferred(struct buffer *after);
+void forgetPrefetch(struct buffer *buf);
 void save(int uarg);
 void saveAs(void);
+void saveInBackground(void);
+void pollBackgroundSave(void);
+int backgroundSaveRunning(void);
+/* The result pipe of the background save, for the main loop to wait
+ * on, or -1 when none is running. */
+int backgroundSaveFd(void);
+void finishBackgroundSave(void);
+void forgetBackgroundSave(struct buffer *buf);
 void revert(void);
+void revertFineGrain(void);
+void followMode(void);
 void findFile(int read_only);
 struct buffer *switchToFile(const char *filename);
 void insertFile(void);
@@ -63,4 +108,17 @@ char *rebaseFilename(const char *filename, const char *old_cwd,
 char *readAllFromFd(int fd, size_t *out_len);
 struct buffer *loadStdinBuffer(const char *data, size_t len);
 
+/* Stream piped stdin, now on fd, into a new *stdin* buffer as it
+ * arrives.  The main loop waits on stdinStreamFd() (-1 once the pipe
+ * is done) and calls readStdinStream() when it is readable.  A pipe
+ * that closes empty takes its buffer with it: readStdinStream() then
+ * destroys the buffer openStdinStream() returned. */
+struct buffer *openStdinStream(int fd);
+int stdinStreamFd(void);
+void readStdinStream(void);
+/* Whether the open stream is still filling buf.  Its rows are appended
+ * outside undo, so it stays read-only until the pipe is done. */
+int stdinStreamFills(const struct buffer *buf);
+void forgetStdinStream(struct buffer *buf);
+
 #endif /* EMIL_FILEIO_H */
@@ -14,6 +14,7 @@
 #include "undo.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include <regex.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -38,9 +39,13 @@ static int initial_direction = 1;
  * point a fresh search runs from: by the second character it has already
  * drifted to the first character's match.  searchInteractive records the
  * real starting point here and findCallback searches from it whenever the
- * pattern changes. */
+ * pattern changes.
+ *
+ * Rows are kept as file lines (viewLine): in a large-file view the
+ * search can move the window, and a row index would then name some
+ * other line. */
 static int search_origin_cx = 0;
-static int search_origin_cy = 0;
+static long long search_origin_line = 0; /* viewLine() of the origin row */
 
 /* Set when a pass found nothing. */
 static int search_failing = 0;
@@ -212,7 +217,7 @@ static uint8_t *searchRowBackward(erow *row, uint8_t *query, int limit,
 /* Put cursor on a match and record its extent for highlighting. */
 static void placeMatch(struct buffer *bufr, int rowidx, uint8_t *match,
 		       int mlen) {
-	erow *row = &bufr->row[rowidx];
+	erow *row = bufRow(bufr, rowidx);
 	bufr->cy = rowidx;
 	bufr->cx = match - row->chars;
 	while (bufr->cx > 0 && utf8_isCont(row->chars[bufr->cx]))
@@ -223,7 +228,7 @@ static void placeMatch(struct buffer *bufr, int rowidx, uint8_t *match,
 }
 
 void findCallback(struct buffer *bufr, uint8_t *query, int key) {
-	static int last_match = -1;
+	static long long last_match = -1; /* a file line, as above */
 	static int direction = 1;
 
 	if (bufr->query != query) {
@@ -284,18 +289,21 @@ void findCallback(struct buffer *bufr, uint8_t *query, int key) {
 	 * cursor instead would let the starting point creep forward as the
 	 * pattern grows, and would not come back when a character is
 	 * deleted from the pattern. */
-	int from_cy = fresh ? search_origin_cy : bufr->cy;
+	long long stay = viewLine(bufr, bufr->cy); /* if this pass fails */
+	int from_cy = fresh ? viewShow(bufr, search_origin_line) : bufr->cy;
 	int from_cx = fresh ? search_origin_cx : bufr->cx;
 
-	int current = last_match;
-	if (current < 0) {
+	int current;
+	if (last_match >= 0) {
+		current = viewShow(bufr, last_match);
+	} else {
 		/* Seeded from the cursor's row for both directions: -1
 		 * here restarts the row-stepping loop below at row 0, so
 		 * C-s would scan from the top instead of from point. */
 		current = from_cy;
 	}
 	if (current >= 0 && current < bufr->numrows) {
-		erow *row = &bufr->row[current];
+		erow *row = bufRow(bufr, current);
 		uint8_t *match;
 		int mlen = 0;
 		if (direction == -1) {
@@ -325,14 +333,37 @@ void findCallback(struct buffer *bufr, uint8_t *query, int key) {
 			}
 		}
 		if (match) {
-			last_match = current;
+			last_match = viewLine(bufr, current);
 			placeMatch(bufr, current, match, mlen);
 		}
 	}
 
-	for (int i = 0; !bufr->match && i < bufr->numrows; i++) {
+	int view_wrapped = 0, interrupted = 0;
+	for (long long i = 0; !bufr->match && (bufr->view || i < bufr->numrows);
+	     i++) {
 		current += direction;
-		if (current == -1) {
+		if (bufr->view && (current == -1 || current == bufr->numrows)) {
+			/* The rows are one window of the file: move it on
+			 * rather than wrapping, until the file runs out.
+			 * A file of gigabytes takes a while to search, so a
+			 * key typed meanwhile stops it between windows; the
+			 * pass that key starts searches afresh. */
+			if (!E.playback && inputPending()) {
+				interrupted = 1;
+				break;
+			}
+			int at = viewStep(bufr, direction);
+			if (at >= 0) {
+				current = at;
+			} else if (allow_wrap && !view_wrapped) {
+				view_wrapped = 1;
+				current = viewShow(bufr, direction > 0 ?
+								 0 :
+								 VIEW_LAST_LINE);
+			} else {
+				break;
+			}
+		} else if (current == -1) {
 			/* Ran off the top. */
 			if (!allow_wrap)
 				break;
@@ -344,7 +375,7 @@ void findCallback(struct buffer *bufr, uint8_t *query, int key) {
 			current = 0;
 		}
 
-		erow *row = &bufr->row[current];
+		erow *row = bufRow(bufr, current);
 		uint8_t *match;
 		int mlen = 0;
 		if (direction == -1) {
@@ -366,7 +397,7 @@ void findCallback(struct buffer *bufr, uint8_t *query, int key) {
 				mlen = (int)strlen((const char *)query);
 		}
 		if (match) {
-			last_match = current;
+			last_match = viewLine(bufr, current);
 			placeMatch(bufr, current, match, mlen);
 		}
 	}
@@ -381,8 +412,14 @@ void findCallback(struct buffer *bufr, uint8_t *query, int key) {
 				E.minibuf->completionState.preserve_message = 1;
 		}
 		search_failing = 0;
+	} else if (interrupted) {
+		bufr->cy = viewShow(bufr, stay);
+		setStatusMessage("Searching... I-search: %s", query);
+		if (E.minibuf)
+			E.minibuf->completionState.preserve_message = 1;
 	} else {
 		/* Cursor stays where it is, on the last sucessful match.*/
+		bufr->cy = viewShow(bufr, stay);
 		setStatusMessage("Failing I-search: %s", query);
 		if (E.minibuf)
 			E.minibuf->completionState.preserve_message = 1;
@@ -397,9 +434,9 @@ static void searchInteractive(int direction, int regex,
 	initial_direction = direction;
 	search_failing = 0;
 	int saved_cx = E.buf->cx;
-	int saved_cy = E.buf->cy;
+	long long saved_line = viewLine(E.buf, E.buf->cy);
 	search_origin_cx = saved_cx;
-	search_origin_cy = saved_cy;
+	search_origin_line = saved_line;
 
 	uint8_t *query =
 		editorPrompt(E.buf, prompt_fmt, PROMPT_SEARCH, findCallback);
@@ -410,8 +447,8 @@ static void searchInteractive(int direction, int regex,
 	if (query) {
 		free(query);
 	} else {
+		E.buf->cy = viewShow(E.buf, saved_line);
 		E.buf->cx = saved_cx;
-		E.buf->cy = saved_cy;
 	}
 }
 
@@ -456,7 +493,7 @@ static int findNextMatch(uint8_t *needle, int skip_current) {
 	E.buf->match_len = 0;
 
 	while (E.buf->cy < E.buf->numrows) {
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 		uint8_t *match = (uint8_t *)strstr(
 			(const char *)&(row->chars[E.buf->cx]),
 			(const char *)needle);
@@ -627,7 +664,7 @@ void queryReplace(void) {
 			/* numrows >= 1 (#105): the end of the buffer is
 			 * always the end of a real row. */
 			E.buf->marky = E.buf->numrows - 1;
-			E.buf->markx = E.buf->row[E.buf->marky].size;
+			E.buf->markx = bufRow(E.buf, E.buf->marky)->size;
 			transformRegion(transformerReplaceString);
 			goto QR_CLEANUP;
 		case 'u':
@@ -20,6 +20,7 @@
 #include "undo.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include <errno.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -59,11 +60,16 @@ void setupCommands(void) {
 		{ "insert-file", insertFile },
 		{ "cd", changeDirectory },
 		{ "diff-buffer-with-file", diffBufferWithFile },
+		{ "follow-mode", followMode },
+		{ "frame-stats", frameStats },
 		{ "isearch-forward-regexp", regexFind },
 		{ "query-replace", queryReplace },
 		{ "replace-regexp", replaceRegex },
 		{ "replace-string", replaceString },
 		{ "revert-buffer", revert },
+		{ "revert-buffer-with-fine-grain", revertFineGrain },
+		{ "save-buffer-in-background", saveInBackground },
+		{ "toggle-line-endings", toggleLineEndings },
 		{ "visual-line-mode", toggleVisualLineMode },
 		{ "version", editorVersion },
 		{ "view-register", viewRegister },
@@ -95,24 +101,28 @@ void runCommand(char *cmd) {
 
 /*** editor operations ***/
 
+static void macroAppend(int v) {
+	E.macro.keys[E.macro.nkeys++] = v;
+	if (E.macro.nkeys >= E.macro.skeys) {
+		E.macro.skeys *= 2;
+		E.macro.keys =
+			xrealloc(E.macro.keys, E.macro.skeys * sizeof(int));
+	}
+}
+
+/* A key's bytes follow it in the macro: those of a KEY_UNICODE, or
+ * the length and bytes of a KEY_PASTE.  deserializeUnicode() and
+ * deserializePaste() read them back. */
 void recordKey(int c) {
 	if (E.recording) {
-		E.macro.keys[E.macro.nkeys++] = c;
-		if (E.macro.nkeys >= E.macro.skeys) {
-			E.macro.skeys *= 2;
-			E.macro.keys = xrealloc(E.macro.keys,
-						E.macro.skeys * sizeof(int));
-		}
+		macroAppend(c);
 		if (c == KEY_UNICODE) {
-			for (int i = 0; i < E.nunicode; i++) {
-				E.macro.keys[E.macro.nkeys++] = E.unicode[i];
-				if (E.macro.nkeys >= E.macro.skeys) {
-					E.macro.skeys *= 2;
-					E.macro.keys = xrealloc(
-						E.macro.keys,
-						E.macro.skeys * sizeof(int));
-				}
-			}
+			for (int i = 0; i < E.nunicode; i++)
+				macroAppend(E.unicode[i]);
+		} else if (c == KEY_PASTE) {
+			macroAppend(E.paste.len);
+			for (int i = 0; i < E.paste.len; i++)
+				macroAppend(E.paste.buf[i]);
 		}
 	}
 }
@@ -478,6 +488,8 @@ int resolveBinding(int key) {
 		return CMD_UNICODE;
 	case KEY_UNICODE_ERROR:
 		return CMD_UNICODE_ERROR;
+	case KEY_PASTE:
+		return CMD_PASTE;
 	}
 
 	/* Ctrl key combinations */
@@ -601,13 +613,13 @@ static int dispatchMove(int c, int uarg, struct window *win) {
 		return 1;
 	case CMD_BEG_OF_FILE:
 		setMarkSilent();
-		E.buf->cy = 0;
+		E.buf->cy = viewShow(E.buf, 0);
 		E.buf->cx = 0;
 		return 1;
 	case CMD_END_OF_FILE:
 		setMarkSilent();
-		E.buf->cy = E.buf->numrows - 1;
-		E.buf->cx = E.buf->row[E.buf->cy].size;
+		E.buf->cy = viewShow(E.buf, VIEW_LAST_LINE);
+		E.buf->cx = bufRow(E.buf, E.buf->cy)->size;
 		return 1;
 	case CMD_HOME:
 		beginningOfLine();
@@ -640,6 +652,9 @@ static int dispatchMove(int c, int uarg, struct window *win) {
 		backwardSentence(uarg);
 		return 1;
 	case CMD_RECENTER:
+		/* C-l also repaints the whole screen, for when something
+		 * else has written to the terminal. */
+		invalidateScreen();
 		recenter(win);
 		return 1;
 	case CMD_GOTO_LINE:
@@ -671,6 +686,9 @@ static int dispatchEdit(int c, int uarg) {
 	case CMD_UNICODE:
 		insertUnicode(uarg);
 		return 1;
+	case CMD_PASTE:
+		insertPaste();
+		return 1;
 	case CMD_KILL_LINE:
 		killLine(uarg);
 		return 1;
@@ -689,6 +707,8 @@ static int dispatchEdit(int c, int uarg) {
 		if (key == KEY_UNICODE) {
 			int count = UARG_COUNT(uarg);
 			insertUnicode(count);
+		} else if (key == KEY_PASTE) {
+			insertPaste();
 		} else if (key == '\n' && E.buf == E.minibuf &&
 			   E.prompt_type != PROMPT_REPLACE &&
 			   E.prompt_type != PROMPT_SHELL) {
@@ -854,6 +874,14 @@ static int dispatchBuffer(int c, int uarg) {
 		findFile(1);
 		return 1;
 	case CMD_TOGGLE_READ_ONLY:
+		if (E.buf->view) {
+			setStatusMessage("A large-file view is always read-only");
+			return 1;
+		}
+		if (stdinStreamFills(E.buf)) {
+			setStatusMessage("Still reading stdin");
+			return 1;
+		}
 		E.buf->read_only = !E.buf->read_only;
 		/* Whichever way it went, the state is now the user's
 		 * choice rather than one we imposed for an advisory
@@ -884,18 +912,18 @@ static int dispatchRegion(int c, int uarg) {
 			setMark();
 		}
 		return 1;
-	case CMD_SWAP_MARK:
+	case CMD_SWAP_MARK: {
+		long long swapline = viewFetchMark(E.buf);
 		if (0 <= E.buf->markx &&
 		    (0 <= E.buf->marky && E.buf->marky < E.buf->numrows)) {
 			int swapx = E.buf->cx;
-			int swapy = E.buf->cy;
 			E.buf->cx = E.buf->markx;
 			E.buf->cy = E.buf->marky;
-			E.buf->markx = swapx;
-			E.buf->marky = swapy;
+			viewSetMark(E.buf, swapx, swapline);
 			E.buf->mark_active = 1;
 		}
 		return 1;
+	}
 	case CMD_CUT:
 		if (E.buf->rectangle_mode)
 			killRectangle();
@@ -1162,6 +1190,10 @@ void processKeypress(int c) {
 		E.kill_ring_pos = -1;
 	}
 
+	/* A macro may switch to a deferred buffer and edit it before
+	 * any frame is drawn: read it first. */
+	loadDeferred(E.buf);
+
 	int windowIdx = windowFocusedIdx();
 	struct window *win = E.windows[windowIdx];
 
@@ -1274,6 +1306,8 @@ void execMacro(struct macro *macro) {
 		int key = macro->keys[E.playback++];
 		if (key == KEY_UNICODE) {
 			deserializeUnicode();
+		} else if (key == KEY_PASTE) {
+			deserializePaste();
 		}
 		if (key >= ' ' && key < KEY_ARROW_LEFT)
 			E.self_insert_key = key;
@@ -22,6 +22,17 @@ enum keyToken {
 	KEY_BACKTAB,
 	KEY_UNICODE,
 	KEY_UNICODE_ERROR,
+	/* Text pasted between bracketed-paste markers; the text is in
+	 * E.paste. */
+	KEY_PASTE,
+	/* Not keys: the terminal's answer to the synchronized-output
+	 * query (DECRQM for mode 2026), consumed by readKey(). */
+	KEY_SYNC_SUPPORTED,
+	KEY_SYNC_UNSUPPORTED,
+	/* Not keys: the bracketed-paste markers (CSI 200~ and CSI
+	 * 201~), which readKey() turns into KEY_PASTE. */
+	KEY_PASTE_START,
+	KEY_PASTE_END,
 	/* Meta + character: KEY_META_BASE + character value.
 	 * e.g. Meta-f = KEY_META_BASE + 'f' */
 	KEY_META_BASE = 2000,
@@ -76,6 +87,7 @@ enum command_t {
 	CMD_DELETE,
 	CMD_UNICODE,
 	CMD_UNICODE_ERROR,
+	CMD_PASTE,
 	CMD_KILL_LINE,
 	CMD_NEWLINE_INDENT,
 	CMD_OPEN_LINE,
@@ -0,0 +1,133 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* linediff.c: line-level diff, for revert-buffer-with-fine-grain.
+ *
+ * Myers' greedy O((N+M)D) algorithm after trimming the common head
+ * and tail, which for a file edited in a few places leaves little for
+ * it to do.  The path is recovered by keeping each round's V array,
+ * d^2 ints in all, so D is capped at LINEDIFF_MAX_D; a larger
+ * difference is reported as one hunk covering the trimmed middle.
+ */
+
+#include "linediff.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LINEDIFF_MAX_D 2048
+
+/* One step of the edit path, at the position before it was taken. */
+struct edit {
+	int x, y;
+	int del; /* 1: old line x goes; 0: new line y comes in */
+};
+
+int diffLines(int n, int m, lineEqualFn same, void *ctx,
+	      struct lineHunk **out) {
+	*out = NULL;
+
+	/* The tail first, so that a sequence ending in the same line
+	 * keeps it out of every hunk. */
+	int s = 0;
+	while (s < n && s < m && same(ctx, n - 1 - s, m - 1 - s))
+		s++;
+	int p = 0;
+	while (p < n - s && p < m - s && same(ctx, p, p))
+		p++;
+	int N = n - s - p;
+	int M = m - s - p;
+	if (N == 0 && M == 0)
+		return 0;
+
+	int cap = N + M < LINEDIFF_MAX_D ? N + M : LINEDIFF_MAX_D;
+	int found = -1;
+	int *trace = NULL;
+	size_t tcap = 0;
+	if (N > 0 && M > 0) {
+		int off = cap + 1;
+		int *v = xmalloc(sizeof(int) * (2 * (size_t)cap + 3));
+		memset(v, 0, sizeof(int) * (2 * (size_t)cap + 3));
+		for (int d = 0; d <= cap && found < 0; d++) {
+			for (int k = -d; k <= d; k += 2) {
+				int x;
+				if (k == -d ||
+				    (k != d && v[off + k - 1] < v[off + k + 1]))
+					x = v[off + k + 1];
+				else
+					x = v[off + k - 1] + 1;
+				int y = x - k;
+				while (x < N && y < M && same(ctx, p + x, p + y)) {
+					x++;
+					y++;
+				}
+				v[off + k] = x;
+				if (x >= N && y >= M) {
+					found = d;
+					break;
+				}
+			}
+			/* Round d's V for k in [-d, d], at offset d^2. */
+			size_t need = ((size_t)d + 1) * ((size_t)d + 1);
+			if (need > tcap) {
+				tcap = need * 2;
+				trace = xrealloc(trace, sizeof(int) * tcap);
+			}
+			memcpy(trace + (size_t)d * d, v + off - d,
+			       sizeof(int) * (2 * (size_t)d + 1));
+		}
+		free(v);
+	}
+
+	if (found < 0) {
+		/* One side empty, or past the cap. */
+		free(trace);
+		*out = xmalloc(sizeof(**out));
+		(*out)[0].a = p;
+		(*out)[0].alen = N;
+		(*out)[0].b = p;
+		(*out)[0].blen = M;
+		return 1;
+	}
+
+	/* Walk back from (N, M): each round contributes one edit. */
+	struct edit *edits = xmalloc(sizeof(*edits) * (size_t)(found + 1));
+	int x = N, y = M;
+	for (int d = found; d > 0; d--) {
+		const int *pv = trace + (size_t)(d - 1) * (d - 1) + (d - 1);
+		int k = x - y;
+		int pk;
+		if (k == -d || (k != d && pv[k - 1] < pv[k + 1]))
+			pk = k + 1;
+		else
+			pk = k - 1;
+		int px = pv[pk];
+		int py = px - pk;
+		edits[d - 1].x = px;
+		edits[d - 1].y = py;
+		edits[d - 1].del = (pk == k - 1);
+		x = px;
+		y = py;
+	}
+	free(trace);
+
+	/* Adjacent edits make one hunk. */
+	struct lineHunk *h = xmalloc(sizeof(*h) * (size_t)(found + 1));
+	int nh = 0;
+	for (int i = 0; i < found; i++) {
+		struct edit *e = &edits[i];
+		if (nh == 0 || e->x != h[nh - 1].a - p + h[nh - 1].alen ||
+		    e->y != h[nh - 1].b - p + h[nh - 1].blen) {
+			h[nh].a = p + e->x;
+			h[nh].alen = 0;
+			h[nh].b = p + e->y;
+			h[nh].blen = 0;
+			nh++;
+		}
+		if (e->del)
+			h[nh - 1].alen++;
+		else
+			h[nh - 1].blen++;
+	}
+	free(edits);
+	*out = h;
+	return nh;
+}
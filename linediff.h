@@ -0,0 +1,23 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+#ifndef EMIL_LINEDIFF_H
+#define EMIL_LINEDIFF_H
+
+/* Lines [a, a + alen) of the old sequence become lines [b, b + blen)
+ * of the new.  Either length may be 0. */
+struct lineHunk {
+	int a, alen;
+	int b, blen;
+};
+
+/* Whether old line a equals new line b. */
+typedef int (*lineEqualFn)(void *ctx, int a, int b);
+
+/* The hunks turning n old lines into m new ones, in order, as a
+ * xmalloc'd array in *out.  Returns the count, 0 when the sequences
+ * are equal.  Past a bound on the number of differing lines the
+ * whole differing middle comes back as one hunk: still correct, no
+ * longer minimal. */
+int diffLines(int n, int m, lineEqualFn same, void *ctx,
+	      struct lineHunk **out);
+
+#endif
@@ -37,10 +37,12 @@ static volatile sig_atomic_t got_sigwinch = 0;
 static volatile sig_atomic_t got_sigcont = 0;
 static volatile sig_atomic_t got_sigterm = 0;
 static volatile sig_atomic_t got_sighup = 0;
+static volatile sig_atomic_t got_sigchld = 0;
 
 static void editorSuspend(int sig) {
 	(void)sig;
 	IGNORE_RETURN(tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.orig_termios));
+	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?2004l", 8));
 	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?1049l", 8));
 	signal(SIGTSTP, SIG_DFL);
 	raise(SIGTSTP);
@@ -123,6 +125,17 @@ static void handleSighup(int sig) {
 	got_sighup = 1;
 }
 
+/* A child exited.  Only the background save is reaped in response
+ * (see fileio.c); subprocess children are joined by their owners.
+ * Installed with SA_RESTART so that a shell or diff exiting does not
+ * fail blocking calls elsewhere.  The save does not rely on it to end
+ * the wait: a SIGCHLD landing just before select() would be missed,
+ * so waitForKey() waits on the save's result pipe instead. */
+static void handleSigchld(int sig) {
+	(void)sig;
+	got_sigchld = 1;
+}
+
 /* Recover from a signal that its handler could only flag.
  *
  * SIGCONT (resume) and SIGWINCH (resize) both leave the editor in a
@@ -157,6 +170,64 @@ void handlePendingSignals(void) {
 		got_sigwinch = 0;
 		resizeScreen();
 	}
+
+	if (got_sigchld) {
+		got_sigchld = 0;
+		pollBackgroundSave();
+	}
+}
+
+/* Sleep until the terminal has a key, acting on file-watch events,
+ * piped stdin and a background save's result that arrive first.
+ * Returns 0 when the loop should redraw and come back rather than
+ * read: a watched file changed, more stdin came in, a save finished,
+ * or a signal.  Watch events about files no buffer holds, or that
+ * changed nothing, go back to sleep. */
+static int waitForKey(void) {
+	int wfd = fileWatchFd();
+	int sfd = stdinStreamFd();
+	int bfd = backgroundSaveFd();
+	if ((wfd < 0 && sfd < 0 && bfd < 0) || E.playback || inputPending())
+		return 1;
+
+	for (;;) {
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(STDIN_FILENO, &fds);
+		int maxfd = STDIN_FILENO;
+		if (wfd >= 0) {
+			FD_SET(wfd, &fds);
+			if (wfd > maxfd)
+				maxfd = wfd;
+		}
+		if (sfd >= 0) {
+			FD_SET(sfd, &fds);
+			if (sfd > maxfd)
+				maxfd = sfd;
+		}
+		if (bfd >= 0) {
+			FD_SET(bfd, &fds);
+			if (bfd > maxfd)
+				maxfd = bfd;
+		}
+		if (select(maxfd + 1, &fds, NULL, NULL, NULL) == -1)
+			return 0;
+		int redraw = 0;
+		if (wfd >= 0 && FD_ISSET(wfd, &fds))
+			redraw = readFileWatch();
+		if (sfd >= 0 && FD_ISSET(sfd, &fds)) {
+			readStdinStream();
+			redraw = 1;
+		}
+		if (bfd >= 0 && FD_ISSET(bfd, &fds)) {
+			pollBackgroundSave();
+			redraw = 1;
+		}
+		if (FD_ISSET(STDIN_FILENO, &fds))
+			return 1;
+		if (redraw)
+			return 0;
+	}
 }
 
 /*** init ***/
@@ -169,6 +240,7 @@ void setupHandlers(void) {
 	installHandler(SIGTSTP, editorSuspend, SA_NODEFER);
 	installHandler(SIGTERM, handleSigterm, 0);
 	installHandler(SIGHUP, handleSighup, 0);
+	installHandler(SIGCHLD, handleSigchld, SA_NOCLDSTOP | SA_RESTART);
 
 	/* Installed here rather than once in main() so that the resume
 	 * path re-asserts them along with the rest; re-installing an
@@ -287,18 +359,15 @@ int main(int argc, char *argv[]) {
 	}
 
 	/*
-	 * Detect piped stdin: if stdin is not a terminal, slurp the
-	 * data before entering raw mode, then reopen /dev/tty.*/
-	char *stdin_data = NULL;
-	size_t stdin_len = 0;
+	 * Detect piped stdin: if stdin is not a terminal, keep the pipe
+	 * on another descriptor to be read as it arrives, then reopen
+	 * /dev/tty as stdin so the terminal works.*/
+	int stdin_fd = -1;
 	int stdin_buf_used = 0;
 	if (!isatty(STDIN_FILENO)) {
-		stdin_data = readAllFromFd(STDIN_FILENO, &stdin_len);
-
-		/* Reopen /dev/tty as stdin so the terminal works */
+		stdin_fd = dup(STDIN_FILENO);
 		int tty_fd = open("/dev/tty", O_RDWR);
-		if (tty_fd < 0) {
-			free(stdin_data);
+		if (stdin_fd < 0 || tty_fd < 0) {
 			fprintf(stderr, "emil: cannot open /dev/tty: %s\n",
 				strerror(errno));
 			exit(1);
@@ -320,35 +389,16 @@ int main(int argc, char *argv[]) {
 	E.headbuf = newBuffer();
 	E.buf = E.headbuf;
 
-	/* Load piped stdin data if present */
-	if (stdin_data != NULL) {
-		if (stdin_len > 0) {
-			/* Hard limit: no prompt for stdin */
-			if (stdin_len > EMIL_MAX_FILE_SIZE) {
-				free(stdin_data);
-				disableRawMode();
-				fprintf(stderr, "stdin: %s\n",
-					"Exceeds 1 GiB limit");
-				exit(1);
-			}
-			struct buffer *stdinBuf =
-				loadStdinBuffer(stdin_data, stdin_len);
-			if (stdinBuf == NULL) {
-				/* Binary or invalid UTF-8: bail out
-				 * cleanly */
-				free(stdin_data);
-				disableRawMode();
-				fprintf(stderr, "stdin: %s\n",
-					"Failed UTF-8 validation");
-				exit(1);
-			}
-			stdinBuf->next = E.headbuf;
-			E.headbuf = stdinBuf;
-			E.buf = stdinBuf;
-			stdin_buf_used = 1;
-		}
-		free(stdin_data);
-		stdin_data = NULL;
+	/* Stream piped stdin.  Whatever has already arrived is read
+	 * now, so a finished pipe opens complete; the rest comes in from
+	 * the main loop. */
+	if (stdin_fd >= 0) {
+		struct buffer *stdinBuf = openStdinStream(stdin_fd);
+		stdinBuf->next = E.headbuf;
+		E.headbuf = stdinBuf;
+		E.buf = stdinBuf;
+		stdin_buf_used = 1;
+		readStdinStream();
 	}
 
 	if (argc >= 2) {
@@ -358,6 +408,11 @@ int main(int argc, char *argv[]) {
 			linum = atoi(argv[1] + 1);
 			i++;
 		}
+		/* Only the file shown is read now: the others wait until
+		 * they are switched to, but for the next, prefetched. */
+		char **names = xmalloc(sizeof(*names) * (size_t)argc);
+		struct buffer **bufs = xmalloc(sizeof(*bufs) * (size_t)argc);
+		int nfiles = 0;
 		for (; i < argc; i++) {
 			/* POSIX: "-" means read from stdin */
 			if (strcmp(argv[i], "-") == 0) {
@@ -370,19 +425,27 @@ int main(int argc, char *argv[]) {
 				setStatusMessage("stdin: no piped input");
 				continue;
 			}
+			names[nfiles] = argv[i];
+			bufs[nfiles] = newBuffer();
+			nfiles++;
+		}
 
-			struct buffer *newBuf = newBuffer();
-			if (editorOpen(newBuf, argv[i]) < 0) {
-				disableRawMode();
+		int opened = editorOpenFiles(bufs, names, nfiles, 1);
+		if (opened < nfiles) {
+			disableRawMode();
 
-				fprintf(stderr, "%s: %s\n", argv[i],
-					E.statusmsg);
-				exit(1);
-			}
+			fprintf(stderr, "%s: %s\n", names[opened],
+				E.statusmsg);
+			exit(1);
+		}
 
+		for (int f = 0; f < nfiles; f++) {
+			struct buffer *newBuf = bufs[f];
 			newBuf->next = E.headbuf;
 			if (linum > 0) {
-				if (linum - 1 >= newBuf->numrows) {
+				/* A deferred buffer clamps it when read. */
+				if (linum - 1 >= newBuf->numrows &&
+				    !newBuf->deferred) {
 					newBuf->cy = newBuf->numrows - 1;
 				} else {
 					newBuf->cy = linum - 1;
@@ -392,8 +455,11 @@ int main(int argc, char *argv[]) {
 			E.headbuf = newBuf;
 			E.buf = newBuf;
 		}
+		free(bufs);
+		free(names);
 	}
 	E.windows[0]->buf = E.buf;
+	prefetchDeferred(E.buf);
 
 	/* Initialize minibuffer */
 	E.minibuf = newBuffer();
@@ -410,6 +476,9 @@ int main(int argc, char *argv[]) {
 		handlePendingSignals();
 		refreshScreen();
 
+		if (!waitForKey())
+			continue; /* a watched file changed, or a signal */
+
 		int key = readKey();
 		if (key == -1)
 			continue; /* signal interrupted: recheck flags */
@@ -427,14 +496,12 @@ int main(int argc, char *argv[]) {
 			if (cmd != CMD_NONE)
 				processKeypress(cmd);
 
-			/* Check for more keys already in the buffer */
-			fd_set fds;
-			struct timeval tv = { 0, 0 };
-			FD_ZERO(&fds);
-			FD_SET(STDIN_FILENO, &fds);
-			if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) <=
-			    0)
+			/* Run keys already typed before drawing, unless a
+			 * frame is overdue; the rest wait for the next
+			 * pass. */
+			if (!inputPending() || frameDue())
 				break;
+			skipFrame();
 
 			key = readKey();
 			if (key == -1)
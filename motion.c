@@ -8,6 +8,7 @@
 #include "region.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include "window.h"
 #include "wrap.h"
 #include <ctype.h>
@@ -25,7 +26,7 @@ int isParaBoundary(erow *row) {
 /* Move cursor up or down by one visual (screen) row when word wrap is
  * active.  direction: -1 = up, +1 = down. */
 static void moveVisualRow(int direction) {
-	erow *row = &E.buf->row[E.buf->cy];
+	erow *row = bufRow(E.buf, E.buf->cy);
 	int display_col = charsToDisplayColumn(row, E.buf->cx);
 
 	int current_subline, sub_col;
@@ -44,7 +45,7 @@ static void moveVisualRow(int direction) {
 		if (E.buf->cy == 0)
 			return;
 		E.buf->cy--;
-		erow *prev = &E.buf->row[E.buf->cy];
+		erow *prev = bufRow(E.buf, E.buf->cy);
 		int last_sub = countScreenLines(prev, E.screencols) - 1;
 		E.buf->cx = displayColumnToByteOffset(prev, E.screencols,
 						      last_sub, sub_col);
@@ -53,11 +54,11 @@ static void moveVisualRow(int direction) {
 		if (E.buf->cy >= E.buf->numrows - 1) {
 			/* Already on the last row; nowhere below it. */
 			E.buf->cy = E.buf->numrows - 1;
-			E.buf->cx = E.buf->row[E.buf->cy].size;
+			E.buf->cx = bufRow(E.buf, E.buf->cy)->size;
 			return;
 		}
 		E.buf->cy++;
-		erow *next = &E.buf->row[E.buf->cy];
+		erow *next = bufRow(E.buf, E.buf->cy);
 		E.buf->cx = displayColumnToByteOffset(next, E.screencols, 0,
 						      sub_col);
 	}
@@ -66,7 +67,7 @@ static void moveVisualRow(int direction) {
 void moveCursor(int key, int count) {
 	int times = UARG_COUNT(count);
 	for (int i = 0; i < times; i++) {
-		erow *row = &E.buf->row[E.buf->cy]; /* cy < numrows */
+		erow *row = bufRow(E.buf, E.buf->cy); /* cy < numrows */
 
 		switch (key) {
 		case KEY_ARROW_LEFT:
@@ -77,7 +78,7 @@ void moveCursor(int key, int count) {
 				       utf8_isCont(row->chars[E.buf->cx]));
 			} else if (E.buf->cy > 0) {
 				E.buf->cy--;
-				E.buf->cx = E.buf->row[E.buf->cy].size;
+				E.buf->cx = bufRow(E.buf, E.buf->cy)->size;
 			}
 			break;
 
@@ -98,8 +99,8 @@ void moveCursor(int key, int count) {
 			} else if (E.buf->cy > 0) {
 				E.buf->cy--;
 				E.buf->cx = utf8_snapToBoundary(
-					E.buf->row[E.buf->cy].chars,
-					E.buf->row[E.buf->cy].size, E.buf->cx,
+					bufRow(E.buf, E.buf->cy)->chars,
+					bufRow(E.buf, E.buf->cy)->size, E.buf->cx,
 					+1);
 			}
 			break;
@@ -111,13 +112,13 @@ void moveCursor(int key, int count) {
 				 * line below the last row to step onto. */
 				E.buf->cy++;
 				E.buf->cx = utf8_snapToBoundary(
-					E.buf->row[E.buf->cy].chars,
-					E.buf->row[E.buf->cy].size, E.buf->cx,
+					bufRow(E.buf, E.buf->cy)->chars,
+					bufRow(E.buf, E.buf->cy)->size, E.buf->cx,
 					+1);
 			}
 			break;
 		}
-		row = &E.buf->row[E.buf->cy];
+		row = bufRow(E.buf, E.buf->cy);
 		int rowlen = row->size;
 		if (E.buf->cx > rowlen) {
 			E.buf->cx = rowlen;
@@ -132,15 +133,15 @@ void forwardWordEnd(int *dx, int *dy) {
 	int icy = E.buf->cy;
 	int pre = 1;
 	for (int cy = icy; cy < E.buf->numrows; cy++) {
-		int l = E.buf->row[cy].size;
+		int l = bufRow(E.buf, cy)->size;
 		while (cx < l) {
-			uint8_t c = E.buf->row[cy].chars[cx];
+			uint8_t c = bufRow(E.buf, cy)->chars[cx];
 			int nb = utf8_nBytes(c);
 
 			/* Decode codepoint for CJK check */
 			if (c >= 0x80) {
 				uint32_t cp =
-					utf8Decode(E.buf->row[cy].chars, cx);
+					utf8Decode(bufRow(E.buf, cy)->chars, cx);
 				if (isCJKChar(cp)) {
 					if (!pre) {
 						/* Stop before this CJK char */
@@ -184,7 +185,7 @@ void forwardWordEnd(int *dx, int *dy) {
 		cx = 0;
 	}
 	*dy = E.buf->numrows - 1; /* numrows >= 1 (#105) */
-	*dx = E.buf->row[*dy].size;
+	*dx = bufRow(E.buf, *dy)->size;
 }
 
 void backwardWordEnd(int *dx, int *dy) {
@@ -195,21 +196,21 @@ void backwardWordEnd(int *dx, int *dy) {
 
 	for (int cy = icy; cy >= 0; cy--) {
 		if (cy != icy) {
-			cx = E.buf->row[cy].size;
+			cx = bufRow(E.buf, cy)->size;
 		}
 		while (cx > 0) {
 			/* Step back to start of previous character */
 			int prev = cx - 1;
 			while (prev > 0 &&
-			       utf8_isCont(E.buf->row[cy].chars[prev]))
+			       utf8_isCont(bufRow(E.buf, cy)->chars[prev]))
 				prev--;
 
-			uint8_t c = E.buf->row[cy].chars[prev];
+			uint8_t c = bufRow(E.buf, cy)->chars[prev];
 
 			/* Decode codepoint for CJK check */
 			if (c >= 0x80) {
 				uint32_t cp =
-					utf8Decode(E.buf->row[cy].chars, prev);
+					utf8Decode(bufRow(E.buf, cy)->chars, prev);
 				if (isCJKChar(cp)) {
 					if (!pre) {
 						/* Stop after this CJK char */
@@ -284,7 +285,7 @@ void backwardParaBoundary(int *cx, int *cy) {
 	int pre = 1;
 
 	for (int y = icy; y >= 0; y--) {
-		erow *row = &E.buf->row[y];
+		erow *row = bufRow(E.buf, y);
 		if (isParaBoundary(row) && !pre) {
 			*cy = y;
 			return;
@@ -311,7 +312,7 @@ void forwardParaBoundary(int *cx, int *cy) {
 	int pre = 1;
 
 	for (int y = icy; y < E.buf->numrows; y++) {
-		erow *row = &E.buf->row[y];
+		erow *row = bufRow(E.buf, y);
 		if (isParaBoundary(row) && !pre) {
 			*cy = y;
 			return;
@@ -373,7 +374,7 @@ static int isQuoteChar(uint8_t c) {
 static int stepForward(int *cx, int *cy) {
 	if (*cy >= E.buf->numrows)
 		return 0;
-	if (*cx < E.buf->row[*cy].size) {
+	if (*cx < bufRow(E.buf, *cy)->size) {
 		(*cx)++;
 		return 1;
 	}
@@ -393,7 +394,7 @@ static int stepBackward(int *cx, int *cy) {
 	}
 	if (*cy > 0) {
 		*cy -= 1;
-		*cx = E.buf->row[*cy].size;
+		*cx = bufRow(E.buf, *cy)->size;
 		return 1;
 	}
 	return 0;
@@ -404,7 +405,7 @@ static int stepBackward(int *cx, int *cy) {
 static uint8_t charAt(int cx, int cy) {
 	if (cy >= E.buf->numrows)
 		return 0;
-	erow *row = &E.buf->row[cy];
+	erow *row = bufRow(E.buf, cy);
 	if (cx >= row->size)
 		return '\n';
 	return row->chars[cx];
@@ -654,7 +655,7 @@ void scrollLineDown(int count) {
 
 void beginningOfLine(void) {
 	if (E.buf->word_wrap && E.buf->cy < E.buf->numrows) {
-		erow *row = &E.buf->row[E.buf->cy];
+		erow *row = bufRow(E.buf, E.buf->cy);
 		int display_col = charsToDisplayColumn(row, E.buf->cx);
 		int current_subline, sub_col;
 		cursorScreenLine(row, display_col, E.screencols,
@@ -670,7 +671,7 @@ void beginningOfLine(void) {
 
 void endOfLine(int count) {
 	(void)count;
-	erow *row = &E.buf->row[E.buf->cy];
+	erow *row = bufRow(E.buf, E.buf->cy);
 
 	if (E.buf->word_wrap) {
 		int display_col = charsToDisplayColumn(row, E.buf->cx);
@@ -704,20 +705,14 @@ void gotoLine(void) {
 	if (!nls)
 		return;
 
-	int nl = atoi((char *)nls);
+	long long nl = strtoll((char *)nls, NULL, 10);
 	free(nls);
 
 	if (nl == 0)
 		return;
 
 	E.buf->cx = 0;
-	if (nl < 0) {
-		E.buf->cy = 0;
-	} else if (nl > E.buf->numrows) {
-		E.buf->cy = E.buf->numrows - 1;
-	} else {
-		E.buf->cy = nl - 1;
-	}
+	E.buf->cy = viewShow(E.buf, nl < 0 ? 0 : nl - 1);
 }
 
 /* Sentence movement */
@@ -761,7 +756,7 @@ int forwardSentenceEnd(int *cx, int *cy) {
 	int start_x = *cx, start_y = *cy;
 
 	for (int y = start_y; y < E.buf->numrows; y++) {
-		erow *row = &E.buf->row[y];
+		erow *row = bufRow(E.buf, y);
 		int x = (y == start_y) ? start_x : 0;
 
 		while (x < row->size) {
@@ -816,7 +811,7 @@ int backwardSentenceStart(int *cx, int *cy) {
 	int start_x = *cx, start_y = *cy;
 
 	for (int y = start_y; y >= 0; y--) {
-		erow *row = &E.buf->row[y];
+		erow *row = bufRow(E.buf, y);
 
 		// Start from current x on the first line, otherwise from the end
 		int x = (y == start_y) ? start_x : row->size;
@@ -20,12 +20,12 @@ uint8_t *collectRegionText(struct buffer *buf, int startx, int starty, int endx,
 		/* Safety: stop if we've gone past the target row */
 		if (ly > endy || ly >= buf->numrows)
 			break;
-		if (lx >= buf->row[ly].size) {
+		if (lx >= bufRow(buf, ly)->size) {
 			dbuf_byte(&d, '\n');
 			ly++;
 			lx = 0;
 		} else {
-			dbuf_byte(&d, buf->row[ly].chars[lx]);
+			dbuf_byte(&d, bufRow(buf, ly)->chars[lx]);
 			lx++;
 		}
 	}
@@ -64,16 +64,16 @@ static int deletesOnlyFinalNewline(struct buffer *buf, int startx, int starty,
 		return 0;
 	if (buf->numrows < 2)
 		return 0;
-	if (buf->row[buf->numrows - 1].size != 0)
+	if (bufRow(buf, buf->numrows - 1)->size != 0)
 		return 0;
 	/* Only a no-op if the repair would fire, which needs the row
 	 * surviving the join to be non-empty.  An empty one leaves the
 	 * invariant holding: this is a real edit, deleting a blank
 	 * line. */
-	if (buf->row[buf->numrows - 2].size == 0)
+	if (bufRow(buf, buf->numrows - 2)->size == 0)
 		return 0;
 	return starty == buf->numrows - 2 &&
-	       startx == buf->row[buf->numrows - 2].size &&
+	       startx == bufRow(buf, buf->numrows - 2)->size &&
 	       endy == buf->numrows - 1 && endx == 0;
 }
 
@@ -87,10 +87,10 @@ static int deletesOnlyFinalNewline(struct buffer *buf, int startx, int starty,
 static void restoreFinalNewline(struct buffer *buf) {
 	if (!wantsFinalNewline(buf) || bufferIsEmpty(buf))
 		return;
-	if (buf->row[buf->numrows - 1].size == 0)
+	if (bufRow(buf, buf->numrows - 1)->size == 0)
 		return;
 
-	int atx = buf->row[buf->numrows - 1].size;
+	int atx = bufRow(buf, buf->numrows - 1)->size;
 	int aty = buf->numrows - 1;
 
 	struct undo *fix = newUndo();
@@ -283,7 +283,7 @@ void mutateExtendRows(struct buffer *buf, int from_row, int n_rows) {
 		n_newlines = n_rows - 1;
 	} else {
 		ext->starty = from_row - 1;
-		ext->startx = buf->row[ext->starty].size;
+		ext->startx = bufRow(buf, ext->starty)->size;
 		n_newlines = n_rows;
 	}
 	ext->endx = 0;
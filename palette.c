@@ -249,7 +249,7 @@ static int skipSpacesBackward(erow *row, int from) {
  * -1 after a backward movement, +1 after a forward movement, and
  * 0 for neutral (initial placement, vertical moves). */
 static void snapToSymbol(struct buffer *buf, int direction) {
-	erow *row = &buf->row[buf->cy];
+	erow *row = bufRow(buf, buf->cy);
 	if (row->size == 0)
 		return;
 
@@ -352,7 +352,7 @@ void expandPalette(void) {
 		/* Enter: read symbol at cursor and insert into origin */
 		if (key == '\r') {
 			if (pbuf->cy < pbuf->numrows) {
-				erow *row = &pbuf->row[pbuf->cy];
+				erow *row = bufRow(pbuf, pbuf->cy);
 				int cx = pbuf->cx;
 				if (cx < row->size && row->chars[cx] != ' ') {
 					int nbytes =
@@ -458,25 +458,14 @@ void diffBufferWithFile(void) {
 		return;
 	}
 
-	size_t buflen;
-	char *bufstr = rowsToString(bufr, &buflen);
-	size_t total = 0;
-	while (total < buflen) {
-		ssize_t n = write(fd, bufstr + total, buflen - total);
-		if (n < 0) {
-			if (errno == EINTR)
-				continue;
-			close(fd);
-			unlink(tmpname);
-			free(tmpname);
-			free(bufstr);
-			setStatusMessage("Diff failed: write error");
-			return;
-		}
-		total += n;
+	if (writeRows(fd, bufr) == -1) {
+		close(fd);
+		unlink(tmpname);
+		free(tmpname);
+		setStatusMessage("Diff failed: write error");
+		return;
 	}
 	close(fd);
-	free(bufstr);
 
 	/* Run diff directly, no shell. Avoids filename quoting issues.*/
 	char *iopath = expandTilde(bufr->filename);
@@ -36,16 +36,16 @@ char *minibufJoin(struct buffer *mb, const char *sep) {
 	size_t seplen = strlen(sep);
 	size_t total = 1;
 	for (int i = 0; i < mb->numrows; i++) {
-		total += mb->row[i].size;
+		total += bufRow(mb, i)->size;
 		if (i + 1 < mb->numrows)
 			total += seplen;
 	}
 	char *out = xmalloc(total);
 	size_t at = 0;
 	for (int i = 0; i < mb->numrows; i++) {
-		if (mb->row[i].chars && mb->row[i].size > 0) {
-			memcpy(out + at, mb->row[i].chars, mb->row[i].size);
-			at += mb->row[i].size;
+		if (bufRow(mb, i)->chars && bufRow(mb, i)->size > 0) {
+			memcpy(out + at, bufRow(mb, i)->chars, bufRow(mb, i)->size);
+			at += bufRow(mb, i)->size;
 		}
 		if (i + 1 < mb->numrows) {
 			memcpy(out + at, sep, seplen);
@@ -127,9 +127,9 @@ static struct history *histFor(enum promptType t) {
 static int minibufCursorCols(struct buffer *mb) {
 	int cols = 0;
 	for (int i = 0; i < mb->cy && i < mb->numrows; i++)
-		cols += stringWidth(mb->row[i].chars) + 2;
+		cols += stringWidth(bufRow(mb, i)->chars) + 2;
 	if (mb->cy >= 0 && mb->cy < mb->numrows)
-		cols += charsToDisplayColumn(&mb->row[mb->cy], mb->cx);
+		cols += charsToDisplayColumn(bufRow(mb, mb->cy), mb->cx);
 	return cols;
 }
 
@@ -269,7 +269,7 @@ uint8_t *editorPrompt(struct buffer *bufr, const char *prompt,
 
 					if (elen > 0 && !ends_slash) {
 						E.minibuf->cx =
-							E.minibuf->row[0].size;
+							bufRow(E.minibuf, 0)->size;
 						insertChar(E.minibuf, '/', 1);
 					}
 
@@ -321,7 +321,7 @@ uint8_t *editorPrompt(struct buffer *bufr, const char *prompt,
 			 * the last search string. */
 			/* numrows >= 1 (#105); replaceMinibufferText
 			 * always leaves at least one row. */
-			if (t == PROMPT_SEARCH && E.minibuf->row[0].size == 0) {
+			if (t == PROMPT_SEARCH && bufRow(E.minibuf, 0)->size == 0) {
 				char *last_search = NULL;
 				struct historyEntry *last_entry =
 					getLastHistory(&E.search_history);
@@ -439,7 +439,7 @@ uint8_t *editorPrompt(struct buffer *bufr, const char *prompt,
 		}
 
 		if (callback) {
-			char *text = (char *)E.minibuf->row[0].chars;
+			char *text = (char *)bufRow(E.minibuf, 0)->chars;
 			callback(bufr, (uint8_t *)text, callback_key);
 		}
 	}
@@ -13,6 +13,7 @@
 #include "undo.h"
 #include "unicode.h"
 #include "util.h"
+#include "view.h"
 #include <regex.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -51,9 +52,10 @@ static void restoreKill(struct text saved) {
 	E.kill = saved;
 }
 
-/* Push the current mark position onto the mark ring (if mark is valid). */
+/* Push the current mark position onto the mark ring (if mark is valid).
+ * A view's parked mark (row below -1, see view.c) goes on as it is. */
 static void markRingPush(void) {
-	if (E.buf->markx < 0 || E.buf->marky < 0)
+	if (E.buf->markx < 0 || E.buf->marky == -1)
 		return;
 	E.buf->mark_ring[E.buf->mark_ring_idx].cx = E.buf->markx;
 	E.buf->mark_ring[E.buf->mark_ring_idx].cy = E.buf->marky;
@@ -106,6 +108,7 @@ void popMark(void) {
 	 */
 
 	/* Step 1: goto mark */
+	viewFetchMark(buf);
 	if (E.buf->markx < 0 || E.buf->marky < 0) {
 		setStatusMessage("No mark set in this buffer.");
 		return;
@@ -121,8 +124,8 @@ void popMark(void) {
 	if (E.buf->cy >= E.buf->numrows)
 		buf->cy = E.buf->numrows - 1;
 	if (E.buf->cy < E.buf->numrows &&
-	    E.buf->cx > E.buf->row[E.buf->cy].size)
-		E.buf->cx = E.buf->row[E.buf->cy].size;
+	    E.buf->cx > bufRow(E.buf, E.buf->cy)->size)
+		E.buf->cx = bufRow(E.buf, E.buf->cy)->size;
 
 	/* Step 2: pop-mark — rotate ring into the mark.  */
 	if (E.buf->mark_ring_len > 0) {
@@ -158,17 +161,18 @@ void popMark(void) {
 		/* Backstop: adjustAllPoints() keeps ring entries live
 		 * across mutations, but an entry can also predate a
 		 * buffer reload, so snap what we restore rather than
-		 * trusting it.*/
+		 * trusting it.  A view's parked mark (row below -1) is
+		 * held by its line instead. */
 		if (buf->marky >= buf->numrows)
 			buf->marky = buf->numrows - 1;
-		if (buf->marky < buf->numrows) {
-			erow *mrow = &buf->row[buf->marky];
+		if (buf->marky >= 0 && buf->marky < buf->numrows) {
+			erow *mrow = bufRow(buf, buf->marky);
 			if (buf->markx > mrow->size)
 				buf->markx = mrow->size;
 			while (buf->markx > 0 &&
 			       utf8_isCont(mrow->chars[buf->markx]))
 				buf->markx--;
-		} else {
+		} else if (buf->marky == -1) {
 			buf->markx = 0;
 		}
 	}
@@ -191,7 +195,7 @@ void toggleRectangleMode(void) {
 void markBuffer(void) {
 	if (!bufferIsEmpty(E.buf)) {
 		E.buf->cy = E.buf->numrows - 1;
-		E.buf->cx = E.buf->row[E.buf->cy].size;
+		E.buf->cx = bufRow(E.buf, E.buf->cy)->size;
 		setMark();
 		E.buf->cy = 0;
 		E.buf->cx = 0;
@@ -204,7 +208,7 @@ void markBuffer(void) {
 int markInvalidBuf(const struct buffer *buf) {
 	return (buf->markx < 0 || buf->marky < 0 ||
 		buf->marky >= buf->numrows ||
-		buf->markx > (buf->row[buf->marky].size) ||
+		buf->markx > (bufRow(buf, buf->marky)->size) ||
 		(buf->markx == buf->cx && buf->cy == buf->marky));
 }
 
@@ -278,9 +282,9 @@ static int rectSnapBack(erow *row, int x) {
  * character boundary and clamped to the row. */
 static void rectPlaceCursor(struct buffer *buf, int x, int y) {
 	buf->cy = y;
-	buf->cx = rectSnapFwd(&buf->row[y], x);
-	if (buf->cx > buf->row[y].size)
-		buf->cx = buf->row[y].size;
+	buf->cx = rectSnapFwd(bufRow(buf, y), x);
+	if (buf->cx > bufRow(buf, y)->size)
+		buf->cx = bufRow(buf, y)->size;
 }
 
 /* Normalise rectangle columns so topx <= botx.  Also sets up
@@ -300,12 +304,12 @@ static void normalizeRectCols(int *topx, int *topy, int *botx, int *boty) {
 	 * (and likewise botx in row boty), so snap the repositioned
 	 * point and mark onto boundaries.  topx/botx themselves stay
 	 * nominal: per-row snapping happens where rows are sliced. */
-	E.buf->cx = rectSnapFwd(&E.buf->row[*topy], *topx);
-	if (E.buf->cx > E.buf->row[*topy].size)
-		E.buf->cx = E.buf->row[*topy].size;
+	E.buf->cx = rectSnapFwd(bufRow(E.buf, *topy), *topx);
+	if (E.buf->cx > bufRow(E.buf, *topy)->size)
+		E.buf->cx = bufRow(E.buf, *topy)->size;
 	E.buf->cy = *topy;
 	E.buf->marky = *boty;
-	E.buf->markx = rectSnapBack(&E.buf->row[*boty], *botx);
+	E.buf->markx = rectSnapBack(bufRow(E.buf, *boty), *botx);
 }
 
 void deleteRange(int startx, int starty, int endx, int endy,
@@ -322,7 +326,7 @@ void deleteRange(int startx, int starty, int endx, int endy,
 	/* Clamp end position within buffer */
 	if (endy >= E.buf->numrows) {
 		endy = E.buf->numrows - 1;
-		endx = E.buf->row[endy].size;
+		endx = bufRow(E.buf, endy)->size;
 	}
 
 	/* Nothing to delete if start == end */
@@ -727,7 +731,7 @@ void replaceRegex(void) {
 		endy = buf->marky;
 	} else {
 		endy = buf->numrows - 1;
-		endx = buf->row[endy].size;
+		endx = bufRow(buf, endy)->size;
 	}
 
 	if (starty > endy || (starty == endy && startx >= endx)) {
@@ -790,7 +794,7 @@ void replaceRegex(void) {
 	struct dbuf d = DBUF_INIT;
 	int first_off = 0, last_off = 0;
 	int made = regexSubstituteAll(&pattern, old_text, old_len, repl,
-				      startx > 0, endx < buf->row[endy].size,
+				      startx > 0, endx < bufRow(buf, endy)->size,
 				      &d, &first_off, &last_off);
 
 	if (made == 0) {
@@ -859,7 +863,7 @@ void stringRectangleWithText(uint8_t *string) {
 
 	/* Use full-row region so replacement text captures all content */
 	int old_len;
-	int region_endx = buf->row[boty].size;
+	int region_endx = bufRow(buf, boty)->size;
 	uint8_t *old_text =
 		collectRegionText(buf, 0, topy, region_endx, boty, &old_len);
 
@@ -868,7 +872,7 @@ void stringRectangleWithText(uint8_t *string) {
 	struct dbuf d = DBUF_INIT;
 
 	for (int i = topy; i <= boty; i++) {
-		erow *row = &buf->row[i];
+		erow *row = bufRow(buf, i);
 		if (i > topy)
 			dbuf_byte(&d, '\n');
 
@@ -922,7 +926,7 @@ static uint8_t *extractRectColumns(struct buffer *buf, int topx, int topy,
 	int botx = topx + rw;
 	uint8_t *out = xcalloc((size_t)rw * rh + 1, 1);
 	for (int idx = 0; idx < rh; idx++) {
-		erow *row = &buf->row[topy + idx];
+		erow *row = bufRow(buf, topy + idx);
 		memset(&out[idx * rw], ' ', rw);
 		/* Snap inward so no multi-byte character is split; the
 		 * slice can only shrink (s >= topx, e <= botx), so it
@@ -979,7 +983,7 @@ void killRectangle(void) {
 	/* Collect linear region text for undo */
 	int old_len;
 	/* Use full-row region so replacement text includes all content */
-	int region_endx = buf->row[boty].size;
+	int region_endx = bufRow(buf, boty)->size;
 	uint8_t *old_text =
 		collectRegionText(buf, 0, topy, region_endx, boty, &old_len);
 
@@ -991,7 +995,7 @@ void killRectangle(void) {
 	struct dbuf d = DBUF_INIT;
 
 	for (int i = topy; i <= boty; i++) {
-		erow *row = &buf->row[i];
+		erow *row = bufRow(buf, i);
 		if (i > topy)
 			dbuf_byte(&d, '\n');
 
@@ -1089,7 +1093,7 @@ void yankRectangle(void) {
 	}
 
 	/* Collect old text for the full-row region [0,topy]..[eol,boty] */
-	int region_endx = buf->row[boty].size;
+	int region_endx = bufRow(buf, boty)->size;
 	int old_len;
 	uint8_t *old_text =
 		collectRegionText(buf, 0, topy, region_endx, boty, &old_len);
@@ -1101,7 +1105,7 @@ void yankRectangle(void) {
 
 	for (int idx = 0; idx < rh; idx++) {
 		int cur = topy + idx;
-		erow *row = &buf->row[cur];
+		erow *row = bufRow(buf, cur);
 		if (idx > 0)
 			dbuf_byte(&d, '\n');
 
@@ -256,8 +256,8 @@ void jumpToRegister(void) {
 		{
 			if (buf->cy >= buf->numrows)
 				buf->cy = buf->numrows - 1;
-			if (buf->cx > buf->row[buf->cy].size)
-				buf->cx = buf->row[buf->cy].size;
+			if (buf->cx > bufRow(buf, buf->cy)->size)
+				buf->cx = bufRow(buf, buf->cy)->size;
 		}
 		break;
 	}
@@ -0,0 +1,420 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* screen.c: send the terminal only what changed since the last frame.
+ *
+ * refreshScreen() still draws every line of every window into one
+ * stream, as it always has.  Rather than write that stream out, it is
+ * laid out here on a grid of cells, compared with the grid the
+ * terminal was last sent, and only the spans that differ go out.
+ * Typing one character redraws that character and the status bar's
+ * line:col, not the screen.
+ *
+ * Laying out the stream instead of having the drawing code fill cells
+ * keeps the one description of what a window looks like: the parser
+ * needs only the handful of sequences display.c emits.
+ *
+ * A window that scrolled is first shifted on the terminal with a
+ * scrolling region and insert or delete line, so that only the lines
+ * it exposed are sent.
+ */
+
+#include "screen.h"
+#include "unicode.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Unchanged cells between two changes are rewritten rather than
+ * skipped with a cursor move when there are no more than this many:
+ * a move costs about as much. */
+#define SPAN_GAP 6
+
+#define SGR_PARAMS 8
+
+static void blank(struct cell *c) {
+	c->off = 0;
+	c->len = 0;
+	c->width = 1;
+	c->attr = 0;
+}
+
+static int isBlank(const struct cell *c) {
+	return c->len == 0 && c->width == 1 && c->attr == 0;
+}
+
+static void blankRange(struct screen *s, int from, int to) {
+	for (int i = from; i < to; i++)
+		blank(&s->cells[i]);
+}
+
+/* Put a character of width w (1 or 2) at (r, c).  Writing over half
+ * of a wide character blanks the other half, as a terminal does. */
+static struct cell *place(struct screen *s, int r, int c, int w,
+			  const char *p, int n, unsigned char attr) {
+	struct cell *row = s->cells + (size_t)r * s->cols;
+	if (row[c].width == 0 && c > 0)
+		blank(&row[c - 1]);
+	if (row[c].width == 2 && c + 1 < s->cols)
+		blank(&row[c + 1]);
+
+	/* A space is kept as a blank cell, so that padding drawn with
+	 * spaces and padding erased with CSI K compare equal. */
+	int space = n == 1 && p[0] == ' ';
+	struct cell *cell = &row[c];
+	cell->off = s->text.len;
+	cell->len = space ? 0 : (unsigned short)n;
+	cell->width = (unsigned char)w;
+	cell->attr = attr;
+	if (!space)
+		abAppend(&s->text, p, n);
+
+	if (w == 2 && c + 1 < s->cols) {
+		if (row[c + 1].width == 2 && c + 2 < s->cols)
+			blank(&row[c + 2]);
+		row[c + 1].off = 0;
+		row[c + 1].len = 0;
+		row[c + 1].width = 0;
+		row[c + 1].attr = attr;
+	}
+	return cell;
+}
+
+/* Move rows [top, bottom) up by k, or down by -k, as deleting or
+ * inserting k lines at top does; the rows left behind are blank. */
+static void shiftRows(struct screen *s, int top, int bottom, int k) {
+	int n = bottom - top;
+	if (k > n)
+		k = n;
+	if (k < -n)
+		k = -n;
+	struct cell *base = s->cells + (size_t)top * s->cols;
+	size_t row = sizeof(*base) * (size_t)s->cols;
+	if (k > 0) {
+		memmove(base, base + (size_t)k * s->cols, row * (n - k));
+		blankRange(s, (bottom - k) * s->cols, bottom * s->cols);
+	} else if (k < 0) {
+		memmove(base + (size_t)-k * s->cols, base, row * (n + k));
+		blankRange(s, top * s->cols, (top - k) * s->cols);
+	}
+}
+
+static void sgr(unsigned char *attr, const int *p, int np) {
+	if (np == 0) {
+		*attr = 0;
+		return;
+	}
+	for (int i = 0; i < np; i++) {
+		if (p[i] == 0)
+			*attr = 0;
+		else if (p[i] == 7)
+			*attr |= SCREEN_REVERSE;
+		else if (p[i] == 27)
+			*attr &= (unsigned char)~SCREEN_REVERSE;
+	}
+}
+
+void screenParse(struct screen *s, int rows, int cols, const char *frame,
+		 int len) {
+	if (rows < 1)
+		rows = 1;
+	if (cols < 1)
+		cols = 1;
+	if (s->cells == NULL || rows != s->rows || cols != s->cols) {
+		free(s->cells);
+		s->cells = xmalloc(sizeof(*s->cells) * (size_t)rows *
+				   (size_t)cols);
+		s->rows = rows;
+		s->cols = cols;
+	}
+	blankRange(s, 0, rows * cols);
+	s->text.len = 0;
+	s->valid = 1;
+
+	int r = 0, c = 0;
+	int mtop = 0, mbot = rows; /* scrolling margins, [mtop, mbot) */
+	unsigned char attr = 0;
+	struct cell *last = NULL; /* for a zero-width character to join */
+	int i = 0;
+	while (i < len) {
+		unsigned char b = (unsigned char)frame[i];
+
+		if (b == '\x1b' && i + 1 < len && frame[i + 1] == '[') {
+			i += 2;
+			int priv = i < len && frame[i] == '?';
+			if (priv)
+				i++;
+			int p[SGR_PARAMS] = { 0 };
+			int np = 0, digits = 0;
+			while (i < len && ((frame[i] >= '0' && frame[i] <= '9') ||
+					   frame[i] == ';')) {
+				if (frame[i] == ';') {
+					if (np < SGR_PARAMS)
+						np++;
+					digits = 0;
+				} else if (np < SGR_PARAMS && p[np] < 10000) {
+					p[np] = p[np] * 10 + (frame[i] - '0');
+					digits = 1;
+				}
+				i++;
+			}
+			if (digits && np < SGR_PARAMS)
+				np++;
+			if (i >= len)
+				break;
+			char final = frame[i++];
+			if (priv)
+				continue;
+			switch (final) {
+			case 'H':
+				r = p[0] > 0 ? p[0] - 1 : 0;
+				c = p[1] > 0 ? p[1] - 1 : 0;
+				if (r >= rows)
+					r = rows - 1;
+				if (c >= cols)
+					c = cols - 1;
+				break;
+			case 'K':
+				if (c < cols)
+					blankRange(s, r * cols + c, (r + 1) * cols);
+				break;
+			case 'J':
+				if (c < cols)
+					blankRange(s, r * cols + c, rows * cols);
+				else
+					blankRange(s, (r + 1) * cols, rows * cols);
+				break;
+			case 'm':
+				sgr(&attr, p, np);
+				break;
+			case 'r':
+				mtop = p[0] > 0 ? p[0] - 1 : 0;
+				mbot = np > 1 && p[1] > 0 && p[1] <= rows ? p[1] :
+									    rows;
+				if (mtop >= mbot) {
+					mtop = 0;
+					mbot = rows;
+				}
+				r = 0;
+				c = 0;
+				break;
+			case 'L':
+			case 'M':
+				if (r >= mtop && r < mbot) {
+					int k = p[0] > 0 ? p[0] : 1;
+					shiftRows(s, r, mbot,
+						  final == 'M' ? k : -k);
+				}
+				c = 0;
+				break;
+			default:
+				break;
+			}
+			last = NULL;
+			continue;
+		}
+		if (b == '\r') {
+			c = 0;
+			i++;
+			continue;
+		}
+		if (b == '\n') {
+			if (r < rows - 1)
+				r++;
+			i++;
+			continue;
+		}
+		if (b < 0x20 || b == 0x7f) {
+			i++;
+			continue;
+		}
+
+		int n = utf8_nBytes(b);
+		int w = 1;
+		if (i + n > len)
+			n = 1; /* a truncated sequence: one cell of junk */
+		else if (b >= 0x80)
+			w = charInStringWidth((const uint8_t *)frame, i);
+		if (w == 0) {
+			/* A combining mark belongs to the cell before, if
+			 * its bytes are the last laid out. */
+			if (last && last->len > 0 &&
+			    last->off + last->len == s->text.len &&
+			    last->len + n <= 0xffff) {
+				abAppend(&s->text, frame + i, n);
+				last->len = (unsigned short)(last->len + n);
+			}
+		} else if (c < cols) {
+			last = place(s, r, c, w > 2 ? 2 : w, frame + i, n,
+				     attr);
+			c += w;
+		}
+		i += n;
+	}
+}
+
+static int sameCell(const struct screen *a, const struct cell *x,
+		    const struct screen *b, const struct cell *y) {
+	return x->len == y->len && x->width == y->width &&
+	       x->attr == y->attr &&
+	       (x->len == 0 ||
+		memcmp(a->text.b + x->off, b->text.b + y->off, x->len) == 0);
+}
+
+/* A row's cells, hashed (FNV-1a); 0 for a blank row, which matches
+ * at any shift and so says nothing about one. */
+static unsigned long rowHash(const struct screen *s, int r) {
+	const struct cell *row = s->cells + (size_t)r * s->cols;
+	unsigned long h = 2166136261UL;
+	int blank_row = 1;
+	for (int c = 0; c < s->cols; c++) {
+		const struct cell *cell = &row[c];
+		if (!isBlank(cell))
+			blank_row = 0;
+		h = (h ^ cell->width) * 16777619UL;
+		h = (h ^ cell->attr) * 16777619UL;
+		for (int i = 0; i < cell->len; i++)
+			h = (h ^ (unsigned char)s->text.b[cell->off + i]) *
+			    16777619UL;
+		h = (h ^ 0xff) * 16777619UL;
+	}
+	return blank_row ? 0 : (h ? h : 1);
+}
+
+void screenScroll(struct abuf *out, struct screen *from,
+		  const struct screen *to, int top, int bottom) {
+	if (!from->valid || from->rows != to->rows || from->cols != to->cols)
+		return;
+	if (top < 0)
+		top = 0;
+	if (bottom > to->rows)
+		bottom = to->rows;
+	int n = bottom - top;
+	if (n < 2)
+		return;
+
+	unsigned long *hf = xmalloc(sizeof(*hf) * 2 * (size_t)n);
+	unsigned long *ht = hf + n;
+	for (int i = 0; i < n; i++) {
+		hf[i] = rowHash(from, top + i);
+		ht[i] = rowHash(to, top + i);
+	}
+
+	/* The shift that leaves the most rows of to already in place:
+	 * to's row i is from's row i + k. */
+	int best = 0, kept = 0;
+	for (int i = 0; i < n; i++)
+		kept += ht[i] && ht[i] == hf[i];
+	int best_kept = kept;
+	for (int k = 1 - n; k < n; k++) {
+		if (k == 0)
+			continue;
+		int m = 0;
+		for (int i = k > 0 ? 0 : -k; i < n && i + k < n; i++)
+			m += ht[i] && ht[i] == hf[i + k];
+		if (m > best_kept) {
+			best = k;
+			best_kept = m;
+		}
+	}
+	free(hf);
+	/* A scroll costs about as much as rewriting a short line. */
+	if (best == 0 || best_kept < kept + 2)
+		return;
+
+	char seq[64];
+	int len = snprintf(seq, sizeof(seq), "\x1b[%d;%dr\x1b[%d;1H\x1b[%d%c"
+					     "\x1b[r",
+			   top + 1, bottom, top + 1, best > 0 ? best : -best,
+			   best > 0 ? 'M' : 'L');
+	abAppend(out, seq, len);
+	shiftRows(from, top, bottom, best);
+}
+
+static void setAttr(struct abuf *out, int *cur, unsigned char attr) {
+	if (*cur == attr)
+		return;
+	if (attr & SCREEN_REVERSE)
+		abAppend(out, "\x1b[0;7m", 6);
+	else
+		abAppend(out, "\x1b[0m", 4);
+	*cur = attr;
+}
+
+void screenDiff(struct abuf *out, const struct screen *from,
+		const struct screen *to) {
+	int cols = to->cols;
+	int all = !from->valid || from->rows != to->rows || from->cols != cols;
+	int attr = -1; /* what the terminal has is not known */
+
+	for (int r = 0; r < to->rows; r++) {
+		const struct cell *nrow = to->cells + (size_t)r * cols;
+		const struct cell *orow =
+			all ? NULL : from->cells + (size_t)r * cols;
+#define CHANGED(k) (all || !sameCell(from, &orow[k], to, &nrow[k]))
+
+		int c = 0;
+		while (c < cols) {
+			if (!CHANGED(c)) {
+				c++;
+				continue;
+			}
+			/* Start on a character, not the right half of one,
+			 * old or new: writing over half a wide character
+			 * blanks the other. */
+			int start = c;
+			if (start > 0 && (nrow[start].width == 0 ||
+					  (orow && orow[start].width == 0)))
+				start--;
+			int end = c + 1, run = 0;
+			for (int k = end; k < cols && run <= SPAN_GAP; k++) {
+				if (CHANGED(k)) {
+					end = k + 1;
+					run = 0;
+				} else {
+					run++;
+				}
+			}
+
+			/* Blanks that run to the end of the line are erased,
+			 * not written. */
+			int text_end = end;
+			if (end == cols) {
+				while (text_end > start &&
+				       isBlank(&nrow[text_end - 1]))
+					text_end--;
+				if (cols - text_end <= 3)
+					text_end = end;
+			}
+
+			char move[32];
+			int n = snprintf(move, sizeof(move), "\x1b[%d;%dH",
+					 r + 1, start + 1);
+			abAppend(out, move, n);
+			for (int k = start; k < text_end; k++) {
+				const struct cell *cell = &nrow[k];
+				if (cell->width == 0 && k > start)
+					continue; /* drawn with its left half */
+				setAttr(out, &attr, cell->attr);
+				if (cell->len == 0)
+					abAppend(out, " ", 1);
+				else
+					abAppend(out, to->text.b + cell->off,
+						 cell->len);
+			}
+			if (text_end < end) {
+				setAttr(out, &attr, 0);
+				abAppend(out, "\x1b[K", 3);
+			}
+			c = end;
+		}
+#undef CHANGED
+	}
+	if (attr > 0)
+		setAttr(out, &attr, 0);
+}
+
+void screenFree(struct screen *s) {
+	free(s->cells);
+	abFree(&s->text);
+	memset(s, 0, sizeof(*s));
+}
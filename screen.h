@@ -0,0 +1,54 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+#ifndef EMIL_SCREEN_H
+#define EMIL_SCREEN_H
+
+#include "abuf.h"
+
+/* One character cell.  A space, written or erased, is a blank cell
+ * with no bytes; a wide character takes two cells, the second of
+ * width 0 and no bytes of its own. */
+struct cell {
+	int off; /* its bytes, in the screen's text */
+	unsigned short len;
+	unsigned char width;
+	unsigned char attr; /* SCREEN_REVERSE, or 0 */
+};
+
+#define SCREEN_REVERSE 1
+
+/* A terminal's worth of cells: what was last sent to the terminal, or
+ * what the next frame puts there. */
+struct screen {
+	int rows, cols;
+	int valid; /* 0: what the terminal shows is not known */
+	struct cell *cells;
+	struct abuf text;
+};
+
+/* Lay out frame, a stream of the kind refreshScreen() draws, on a
+ * blank rows x cols screen.  It understands what the drawing code
+ * emits: text, CR and LF, cursor moves (CSI H), erases (CSI K and
+ * CSI J) and SGR 0, 7 and 27; and, so that what screenScroll() and
+ * screenDiff() send can be laid out in turn, scrolling regions
+ * (CSI r) and inserted and deleted lines (CSI L and CSI M).  Other
+ * sequences are skipped. */
+void screenParse(struct screen *s, int rows, int cols, const char *frame,
+		 int len);
+
+/* If rows [top, bottom) of to are mostly those of from moved up or
+ * down, append to out the bytes that scroll them there on the
+ * terminal (a DECSTBM region and IL or DL), and shift from to match.
+ * screenDiff() then sends only what the scroll did not bring. */
+void screenScroll(struct abuf *out, struct screen *from,
+		  const struct screen *to, int top, int bottom);
+
+/* Append to out the bytes that turn from into to on the terminal: for
+ * each line, the spans that differ, each behind a cursor move.  All of
+ * to, when from is not valid or not the same size.  Leaves SGR 0 set
+ * and the cursor wherever the last span ended. */
+void screenDiff(struct abuf *out, const struct screen *from,
+		const struct screen *to);
+
+void screenFree(struct screen *s);
+
+#endif
@@ -15,6 +15,7 @@
 #include <sys/termios.h>
 #endif
 #include <sys/ioctl.h>
+#include <sys/select.h>
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
@@ -62,6 +63,7 @@ void die(const char *s) {
  * undefined on the crash path. */
 void disableRawMode(void) {
 	IGNORE_RETURN(tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.orig_termios));
+	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?2004l", 8));
 	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?1049l", 8));
 }
 
@@ -72,6 +74,7 @@ void disableRawMode(void) {
  * runs in the bottom portion.
  */
 void disableRawModeKeepScreen(void) {
+	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?2004l", 8));
 	if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &E.orig_termios) == -1)
 		die("disableRawModeKeepScreen tcsetattr");
 }
@@ -159,6 +162,9 @@ void applyRawMode(void) {
 	/* Switch to alternate screen */
 	if (write(STDOUT_FILENO, CSI "?1049h", 8) == -1)
 		die("applyRawMode write");
+	/* Bracketed paste: pasted text arrives between CSI 200~ and
+	 * CSI 201~, and readKey() hands it over whole. */
+	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?2004h", 8));
 
 	struct termios raw = E.orig_termios;
 	raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
@@ -177,6 +183,12 @@ void enableRawMode(void) {
 	atexit(disableRawMode);
 
 	applyRawMode();
+
+	/* Ask whether the terminal does synchronized output (DECRQM for
+	 * mode 2026).  Not waited for: the reply comes in with the keys,
+	 * and readKey() takes it from there.  A terminal that does not
+	 * know DECRQM ignores it and frames go out unwrapped. */
+	IGNORE_RETURN(write(STDOUT_FILENO, CSI "?2026$p", 9));
 }
 
 void getWindowSize(int *rows, int *cols) {
@@ -259,12 +271,53 @@ void deserializeUnicode(void) {
 	}
 }
 
+/* Counterpart of recordKey() for KEY_PASTE: the byte count, then one
+ * slot per byte.  A truncated macro pastes what it has. */
+void deserializePaste(void) {
+	E.paste.len = 0;
+	if (E.playback >= E.macro.nkeys)
+		return;
+	int n = E.macro.keys[E.playback++];
+	dbuf_ensure(&E.paste, n);
+	for (int i = 0; i < n && E.playback < E.macro.nkeys; i++)
+		E.paste.buf[E.paste.len++] = (uint8_t)E.macro.keys[E.playback++];
+}
+
 /*
  * Escape-sequence input: the grammar and key mapping live in the
  * pure state machine in decoder.c; this file supplies only the byte
  * source (the clock and signal policy) and the reporting of
  * unrecognized sequences.
  */
+/* Bytes read from the terminal and not yet decoded.  A paste or a
+ * held key arrives many bytes to a read(2); taking them one system
+ * call each was most of the cost of draining a burst. */
+static uint8_t inbuf[4096];
+static int inpos, inlen;
+
+/* read(2) of one byte, served from inbuf while it lasts. */
+static ssize_t readInput(uint8_t *out) {
+	if (inpos == inlen) {
+		ssize_t n = read(STDIN_FILENO, inbuf, sizeof(inbuf));
+		if (n <= 0)
+			return n;
+		inpos = 0;
+		inlen = (int)n;
+	}
+	*out = inbuf[inpos++];
+	return 1;
+}
+
+int inputPending(void) {
+	if (inpos < inlen)
+		return 1;
+	fd_set fds;
+	struct timeval tv = { 0, 0 };
+	FD_ZERO(&fds);
+	FD_SET(STDIN_FILENO, &fds);
+	return select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
 /* Byte source for the decoder (see decoder.h for the contract).
  *
  * Both wait classes block.  They differ only in what a signal means.
@@ -284,7 +337,7 @@ void deserializeUnicode(void) {
  * SIGCONT arrives mid-sequence. */
 static int terminalContByte(uint8_t *out) {
 	for (;;) {
-		ssize_t n = read(STDIN_FILENO, out, 1);
+		ssize_t n = readInput(out);
 		if (n == 1)
 			return 1;
 		if (n == -1 && errno == EINTR)
@@ -295,7 +348,7 @@ static int terminalContByte(uint8_t *out) {
 
 static int terminalEscByte(uint8_t *out, int wait_indefinitely) {
 	for (;;) {
-		ssize_t n = read(STDIN_FILENO, out, 1);
+		ssize_t n = readInput(out);
 		if (n == 1)
 			return 1;
 		if (n == -1 && errno == EINTR && !wait_indefinitely)
@@ -304,6 +357,41 @@ static int terminalEscByte(uint8_t *out, int wait_indefinitely) {
 	}
 }
 
+/* Add one pasted byte to E.paste.  Terminals send a line break in a
+ * paste as CR, or CR LF from some sources; both become one newline. */
+static void pasteByte(uint8_t c, int *after_cr) {
+	if (c == '\n' && *after_cr) {
+		*after_cr = 0;
+		return;
+	}
+	*after_cr = c == '\r';
+	dbuf_byte(&E.paste, *after_cr ? '\n' : c);
+}
+
+/* Read the text of a bracketed paste, everything after CSI 200~ up to
+ * CSI 201~, into E.paste.  Like a sequence in flight, a paste is not
+ * abandoned on a signal; only the end of input cuts it short. */
+static void readPaste(void) {
+	static const uint8_t end[] = "\033[201~";
+	int matched = 0, after_cr = 0;
+	uint8_t c;
+	E.paste.len = 0;
+	while (matched < (int)sizeof(end) - 1 && terminalEscByte(&c, 0)) {
+		if (c == end[matched]) {
+			matched++;
+			continue;
+		}
+		/* Not the end after all.  ESC occurs only first in
+		 * end[], so c can start a new match but not extend an
+		 * older one. */
+		for (int i = 0; i < matched; i++)
+			pasteByte(end[i], &after_cr);
+		matched = c == end[0];
+		if (!matched)
+			pasteByte(c, &after_cr);
+	}
+}
+
 /* Report an unrecognized escape sequence in the status line, then
  * decode it as a bare ESC token (which the keymap ignores).  Control
  * bytes render as C-<letter>, matching the keymap's own notation. */
@@ -340,12 +428,14 @@ int readKey(void) {
 		int ret = E.macro.keys[E.playback++];
 		if (ret == KEY_UNICODE) {
 			deserializeUnicode();
+		} else if (ret == KEY_PASTE) {
+			deserializePaste();
 		}
 		return ret;
 	}
 	int nread;
-	uint8_t c;
-	while ((nread = read(STDIN_FILENO, &c, 1)) != 1) {
+	uint8_t c = 0;
+	while ((nread = (int)readInput(&c)) != 1) {
 		if (nread == -1 && errno == EINTR) {
 			/* Repair before yielding to the caller: every
 			 * read loop treats -1 as "retry", and a retry
@@ -361,6 +451,19 @@ int readKey(void) {
 		uint8_t seen[ESC_SEEN_MAX];
 		int n_seen;
 		int key = decodeEscapeSequence(terminalEscByte, seen, &n_seen);
+		if (key == KEY_SYNC_SUPPORTED || key == KEY_SYNC_UNSUPPORTED) {
+			/* The answer to enableRawMode()'s query, not a
+			 * key.  It arrives at startup, in the main loop,
+			 * which reads again on -1. */
+			E.sync_output = key == KEY_SYNC_SUPPORTED;
+			return -1;
+		}
+		if (key == KEY_PASTE_START) {
+			readPaste();
+			return KEY_PASTE;
+		}
+		if (key == KEY_PASTE_END)
+			return -1; /* a closing marker without its start */
 		if (key == 033)
 			/* n_seen == 0 means the Meta-prefix wait was
 			 * abandoned by a signal, not that a sequence was
@@ -10,7 +10,11 @@ void enableRawMode(void);
 void applyRawMode(void);
 void getWindowSize(int *rows, int *cols);
 int readKey(void);
+/* Whether a key is waiting, read in already or still in the terminal;
+ * never blocks. */
+int inputPending(void);
 void deserializeUnicode(void);
+void deserializePaste(void);
 void copyToClipboard(const uint8_t *text);
 void disableRawModeKeepScreen(void);
 void openShellDrawer(void);
@@ -0,0 +1,172 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/*
+ * bench_load.c: file load throughput, editorOpen() against the loader
+ * it replaced.
+ *
+ * Writes two 100 MB files -- code-like ASCII with tabs, and prose with
+ * a share of multibyte UTF-8 -- and loads each with editorOpen() and
+ * with a reconstruction of the old pipeline: a fread() pass for NUL
+ * bytes, emil_getline() line by line, utf8_validate() over every row,
+ * and calculateLineWidth() over every row.  Both build the same rows
+ * through appendRowRaw(), so the difference is the scanning.
+ * Then both files are opened one after the other with editorOpen()
+ * and together with editorOpenFiles(), as the command line does.
+ *
+ * Build and run:  make bench
+ *
+ * Not part of `make test`: it takes seconds, needs 200 MB of /tmp,
+ * and its output is timings, not a verdict.
+ */
+
+#include "test_harness.h"
+#include "unicode.h"
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_BYTES (100u * 1024 * 1024)
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void writeSample(const char *path, const char *const *lines,
+			int nlines) {
+	FILE *fp = fopen(path, "w");
+	if (!fp) {
+		perror(path);
+		exit(1);
+	}
+	size_t written = 0;
+	for (int i = 0; written < BENCH_BYTES; i++) {
+		const char *l = lines[i % nlines];
+		written += fprintf(fp, "%s %d\n", l, i);
+	}
+	fclose(fp);
+}
+
+/* The pre-scan loader, minus its status messages. */
+static void oldLoad(struct buffer *buf, const char *path) {
+	FILE *fp = fopen(path, "r");
+	unsigned char chunk[8192];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+		if (memchr(chunk, '\0', n) != NULL)
+			exit(1);
+	rewind(fp);
+
+	bufferResetRows(buf);
+	char *line = NULL;
+	size_t linecap = 0;
+	ssize_t linelen;
+	while ((linelen = emil_getline(&line, &linecap, fp)) != -1) {
+		while (linelen > 0 && (line[linelen - 1] == '\n' ||
+				       line[linelen - 1] == '\r'))
+			linelen--;
+		appendRowRaw(buf, (const uint8_t *)line, linelen);
+	}
+	appendRowRaw(buf, (const uint8_t *)"", 0);
+	free(line);
+	fclose(fp);
+
+	for (int i = 0; i < buf->numrows; i++)
+		if (!utf8_validate(bufRow(buf, i)->chars, bufRow(buf, i)->size))
+			exit(1);
+	int max_width = 0;
+	for (int i = 0; i < buf->numrows; i++) {
+		int w = calculateLineWidth(bufRow(buf, i));
+		if (w > max_width)
+			max_width = w;
+	}
+}
+
+static void run(const char *label, const char *path) {
+	struct buffer *a = newBuffer();
+	double t0 = now();
+	oldLoad(a, path);
+	double t_old = now() - t0;
+
+	struct buffer *b = newBuffer();
+	t0 = now();
+	if (editorOpen(b, path) != 0) {
+		fprintf(stderr, "editorOpen failed: %s\n", E.statusmsg);
+		exit(1);
+	}
+	double t_new = now() - t0;
+
+	if (a->numrows != b->numrows) {
+		fprintf(stderr, "row count differs: %d vs %d\n", a->numrows,
+			b->numrows);
+		exit(1);
+	}
+	double mb = BENCH_BYTES / (1024.0 * 1024.0);
+	printf("%-6s %9d rows  old %6.3fs (%5.0f MB/s)  new %6.3fs "
+	       "(%5.0f MB/s)  %.2fx\n",
+	       label, b->numrows, t_old, mb / t_old, t_new, mb / t_new,
+	       t_old / t_new);
+	destroyBuffer(a);
+	destroyBuffer(b);
+}
+
+static void runTogether(char **paths, int n) {
+	struct buffer *bufs[2];
+	double t0 = now();
+	for (int i = 0; i < n; i++) {
+		bufs[i] = newBuffer();
+		editorOpen(bufs[i], paths[i]);
+	}
+	double t_serial = now() - t0;
+	for (int i = 0; i < n; i++)
+		destroyBuffer(bufs[i]);
+
+	for (int i = 0; i < n; i++)
+		bufs[i] = newBuffer();
+	t0 = now();
+	if (editorOpenFiles(bufs, paths, n, 0) != n) {
+		fprintf(stderr, "editorOpenFiles failed: %s\n", E.statusmsg);
+		exit(1);
+	}
+	double t_together = now() - t0;
+	for (int i = 0; i < n; i++)
+		destroyBuffer(bufs[i]);
+
+	printf("both   one by one %6.3fs  together %6.3fs  %.2fx\n",
+	       t_serial, t_together, t_serial / t_together);
+}
+
+int main(void) {
+	static const char *const code[] = {
+		"\tif (row->size > 0 && row->chars[row->size - 1] == ' ')",
+		"\t\treturn bufOffset(buf, row->size, at);",
+		"/* Fill the first gap slot, which becomes logical row */",
+		"static int walkLineWidth(erow *row) {",
+		"}",
+		"",
+	};
+	static const char *const prose[] = {
+		"The caf\xc3\xa9 on the corner opens at seven, na\xc3\xafvely",
+		"\xe6\xbc\xa2\xe5\xad\x97\xe3\x81\xa8\xe4\xbb\xae\xe5\x90\x8d "
+		"mixed with ASCII words",
+		"Plain English sentences make up most of a typical log file.",
+		"\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+		"\xce\xba\xcf\x8c\xcf\x83\xce\xbc\xce\xb5",
+	};
+	char code_path[] = "/tmp/emil_bench_code_XXXXXX";
+	char prose_path[] = "/tmp/emil_bench_prose_XXXXXX";
+	close(mkstemp(code_path));
+	close(mkstemp(prose_path));
+	writeSample(code_path, code, sizeof(code) / sizeof(code[0]));
+	writeSample(prose_path, prose, sizeof(prose) / sizeof(prose[0]));
+
+	initTestEditor();
+	run("code", code_path);
+	run("prose", prose_path);
+	char *both[] = { code_path, prose_path };
+	runTogether(both, 2);
+	cleanupTestEditor();
+
+	unlink(code_path);
+	unlink(prose_path);
+	return 0;
+}
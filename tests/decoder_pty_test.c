@@ -55,6 +55,14 @@ static const char *emil_path;
 static char cap[CAP_MAX];
 static size_t cap_len;
 
+/* Everything the editor has written since it was spawned.  The editor
+ * sends only the cells that changed since the last frame, so what a
+ * keypress did is seen on the screen all of it builds, not in the
+ * bytes that keypress drew. */
+static char hist[CAP_MAX];
+static size_t hist_len;
+static int term_rows, term_cols;
+
 static void capReset(void) {
 	cap_len = 0;
 }
@@ -100,40 +108,127 @@ static void pump(int fd, int duration_ms) {
 			continue;
 		ssize_t n = read(fd, cap + cap_len,
 				 sizeof(cap) - cap_len - 1);
-		if (n > 0)
+		if (n > 0) {
+			size_t room = sizeof(hist) - hist_len;
+			size_t keep = (size_t)n < room ? (size_t)n : room;
+			memcpy(hist + hist_len, cap + cap_len, keep);
+			hist_len += keep;
 			cap_len += (size_t)n;
+		}
 	}
 	cap[cap_len] = 0;
 }
 
-/* Copy of the capture with CSI escape sequences removed: what was
- * actually printed as text.  (ESC '[' params/intermediates then one
- * final byte in 0x40..0x7E; a lone ESC pair is skipped as two
- * bytes.) */
-static char stripbuf[CAP_MAX];
-static const char *stripped(void) {
-	size_t o = 0;
-	for (size_t i = 0; i < cap_len;) {
-		unsigned char c = (unsigned char)cap[i];
-		if (c != 033) {
-			stripbuf[o++] = cap[i++];
+/* The screen as the terminal now shows it, one line per row: hist
+ * replayed on a grid, understanding what the editor draws with (text,
+ * CR, LF, CSI H, CSI K, CSI J) and scrolls with (CSI r, CSI L,
+ * CSI M), and skipping other sequences.  A
+ * character takes one cell whatever its width; no scenario that looks
+ * here types a wide one. */
+#define TERM_MAX 200
+static char cell[TERM_MAX][TERM_MAX][5];
+static char shownbuf[TERM_MAX * (TERM_MAX * 4 + 1) + 1];
+static const char *shown(void) {
+	int rows = term_rows < TERM_MAX ? term_rows : TERM_MAX;
+	int cols = term_cols < TERM_MAX ? term_cols : TERM_MAX;
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+			strcpy(cell[r][c], " ");
+
+	int r = 0, c = 0;
+	int mtop = 0, mbot = rows; /* scrolling margins, [mtop, mbot) */
+	for (size_t i = 0; i < hist_len;) {
+		unsigned char ch = (unsigned char)hist[i];
+		if (ch == 033) {
+			i++;
+			if (i < hist_len && hist[i] == '[') {
+				int p[2] = { 0, 0 }, np = 0;
+				i++;
+				while (i < hist_len &&
+				       ((unsigned char)hist[i] < 0x40 ||
+					(unsigned char)hist[i] > 0x7E)) {
+					if (hist[i] == ';' && np < 1)
+						np++;
+					else if (hist[i] >= '0' &&
+						 hist[i] <= '9' && p[np] < 1000)
+						p[np] = p[np] * 10 +
+							(hist[i] - '0');
+					i++;
+				}
+				char final = i < hist_len ? hist[i++] : 0;
+				if (final == 'H') {
+					r = p[0] > 0 ? p[0] - 1 : 0;
+					c = p[1] > 0 ? p[1] - 1 : 0;
+				} else if (final == 'K' || final == 'J') {
+					for (int k = c; k < cols && r < rows; k++)
+						strcpy(cell[r][k], " ");
+					for (int y = r + 1;
+					     final == 'J' && y < rows; y++)
+						for (int k = 0; k < cols; k++)
+							strcpy(cell[y][k], " ");
+				} else if (final == 'r') {
+					mtop = p[0] > 0 ? p[0] - 1 : 0;
+					mbot = p[1] > 0 && p[1] <= rows ? p[1] :
+									  rows;
+					r = c = 0;
+				} else if ((final == 'L' || final == 'M') &&
+					   r >= mtop && r < mbot) {
+					int k = p[0] > 0 ? p[0] : 1;
+					if (k > mbot - r)
+						k = mbot - r;
+					int span = mbot - r - k;
+					if (final == 'M')
+						memmove(cell[r], cell[r + k],
+							sizeof(cell[0]) * span);
+					else
+						memmove(cell[r + k], cell[r],
+							sizeof(cell[0]) * span);
+					int blank = final == 'M' ? mbot - k : r;
+					for (int y = blank; y < blank + k; y++)
+						for (int x = 0; x < cols; x++)
+							strcpy(cell[y][x], " ");
+					c = 0;
+				}
+			} else if (i < hist_len) {
+				i++; /* ESC x pair */
+			}
 			continue;
 		}
-		i++;
-		if (i < cap_len && cap[i] == '[') {
+		if (ch == '\r') {
+			c = 0;
 			i++;
-			while (i < cap_len &&
-			       ((unsigned char)cap[i] < 0x40 ||
-				(unsigned char)cap[i] > 0x7E))
-				i++;
-			if (i < cap_len)
-				i++; /* final byte */
-		} else if (i < cap_len) {
-			i++; /* ESC x pair */
+			continue;
+		}
+		if (ch == '\n') {
+			r++;
+			i++;
+			continue;
 		}
+		size_t n = 1;
+		if (ch >= 0xC0)
+			while (i + n < hist_len && n < 4 &&
+			       ((unsigned char)hist[i + n] & 0xC0) == 0x80)
+				n++;
+		if (ch >= 0x20 && r < rows && c < cols) {
+			memcpy(cell[r][c], hist + i, n);
+			cell[r][c][n] = 0;
+		}
+		if (ch >= 0x20)
+			c++;
+		i += n;
+	}
+
+	size_t o = 0;
+	for (int y = 0; y < rows; y++) {
+		for (int k = 0; k < cols; k++) {
+			size_t n = strlen(cell[y][k]);
+			memcpy(shownbuf + o, cell[y][k], n);
+			o += n;
+		}
+		shownbuf[o++] = '\n';
 	}
-	stripbuf[o] = 0;
-	return stripbuf;
+	shownbuf[o] = 0;
+	return shownbuf;
 }
 
 static int contains(const char *haystack, const char *needle) {
@@ -221,6 +316,9 @@ static int spawnEmilOpts(struct child *c, const char *file, int cols,
 
 	c->pid = pid;
 	c->mfd = mfd;
+	term_rows = rows;
+	term_cols = cols;
+	hist_len = 0;
 	capReset();
 	pump(mfd, 700); /* first paint */
 	return 0;
@@ -329,9 +427,9 @@ static void scenarioLoneEscThenArrow(void) {
 		sendStr(&c, "\033[A", 150);
 		capReset();
 		sendStr(&c, "X", 400);
-		expect(contains(stripped(), "line1X"),
+		expect(contains(shown(), "line1X"),
 		       "arrow did not act as Up");
-		expect(!contains(stripped(), "[A"),
+		expect(!contains(shown(), "[A"),
 		       "sequence body leaked as text");
 		reap(&c);
 	}
@@ -349,7 +447,7 @@ static void scenarioMetaPrefixHumanSpeed(void) {
 		sendStr(&c, "f", 150);
 		capReset();
 		sendStr(&c, "X", 400);
-		expect(contains(stripped(), "alphaX beta"),
+		expect(contains(shown(), "alphaX beta"),
 		       "M-f did not move by word");
 		reap(&c);
 	}
@@ -370,7 +468,7 @@ static void scenarioUnknownReported(const char *label,
 		expect(contains(cap, message), "status message missing");
 		capReset();
 		sendStr(&c, "x", 400);
-		expect(contains(stripped(), "##x"),
+		expect(contains(shown(), "##x"),
 		       "following keypress swallowed");
 		reap(&c);
 	}
@@ -395,11 +493,11 @@ static void scenarioAltBracketConsumesNext(void) {
 		sendStr(&c, "x", 400); /* final byte: completes the CSI */
 		expect(contains(cap, "M-[ x"),
 		       "completed sequence not reported");
-		expect(!contains(stripped(), "##x"),
+		expect(!contains(shown(), "##x"),
 		       "final byte leaked into the buffer as text");
 		capReset();
 		sendStr(&c, "y", 400);
-		expect(contains(stripped(), "##y"),
+		expect(contains(shown(), "##y"),
 		       "keypress after the sequence swallowed");
 		reap(&c);
 	}
@@ -428,9 +526,9 @@ static void scenarioSlowSplitSequence(void) {
 		pump(c.mfd, 300);
 		capReset();
 		sendStr(&c, "X", 400);
-		expect(contains(stripped(), "line1X"),
+		expect(contains(shown(), "line1X"),
 		       "split arrow did not act as Up");
-		expect(!contains(stripped(), "line2A"),
+		expect(!contains(shown(), "line2A"),
 		       "sequence tail leaked into the buffer as text");
 		reap(&c);
 	}
@@ -449,7 +547,7 @@ static void scenarioMappedKeys(void) {
 		sendStr(&c, "\033[4~", 150);
 		capReset();
 		sendStr(&c, "2", 400);
-		expect(contains(stripped(), "1abc2"),
+		expect(contains(shown(), "1abc2"),
 		       "Home/End variants misdecoded");
 		reap(&c);
 	}
@@ -461,7 +559,7 @@ static void scenarioMappedKeys(void) {
 		sendStr(&c, "\033OH", 150);
 		capReset();
 		sendStr(&c, "Y", 400);
-		expect(contains(stripped(), "Yone two"),
+		expect(contains(shown(), "Yone two"),
 		       "SS3 Home misdecoded");
 		reap(&c);
 	}
@@ -473,7 +571,7 @@ static void scenarioMappedKeys(void) {
 		sendStr(&c, "\033b", 150);
 		capReset();
 		sendStr(&c, "Z", 400);
-		expect(contains(stripped(), "word Zword"),
+		expect(contains(shown(), "word Zword"),
 		       "M-b misdecoded");
 		reap(&c);
 	}
@@ -494,6 +592,100 @@ static void scenarioUtf8Typing(void) {
 	finish();
 }
 
+/* Bracketed paste is turned on, and a paste goes into the buffer
+ * whole: its line breaks as newlines, in one frame, and out again
+ * with one undo. */
+static void scenarioBracketedPaste(void) {
+	struct child c;
+	begin("bracketed paste inserted whole");
+	if (spawnEmil(&c) == 0) {
+		expect(contains(cap, "\033[?2004h"), "bracketed paste not on");
+		capReset();
+		sendStr(&c, "\033[200~first\r  second\r\nthird\033[201~",
+			500);
+		expect(contains(shown(), "first") &&
+			       contains(shown(), "  second") &&
+			       contains(shown(), "third"),
+		       "pasted text not shown");
+		int frames = 0;
+		for (const char *p = cap; (p = strstr(p, "\033[?25l")); p++)
+			frames++;
+		expect(frames == 1, "paste drawn more than once");
+		expect(!contains(cap, "Unknown"), "marker reported as a key");
+		sendStr(&c, "\037", 400);
+		expect(!contains(shown(), "first") &&
+			       !contains(shown(), "third"),
+		       "one undo left some of the paste");
+		reap(&c);
+	}
+	finish();
+}
+
+/* C-v and M-v shift what the terminal shows with a scrolling region
+ * and send only the lines that came into view: the screen ends up
+ * right, and the page of text already there is not sent again. */
+static void scenarioPageScrollShifts(void) {
+	struct child c;
+	char path[] = "/tmp/emil_pty_scroll_XXXXXX";
+	begin("C-v and M-v scroll by shifting lines");
+	int fd = mkstemp(path);
+	if (fd == -1) {
+		skip("no temporary file");
+		finish();
+		return;
+	}
+	FILE *fp = fdopen(fd, "w");
+	for (int i = 0; i < 200; i++)
+		fprintf(fp, "row %03d\n", i);
+	fclose(fp);
+	if (spawnEmilOpts(&c, path, 80, 24) == 0) {
+		sendStr(&c, "\026", 400); /* C-v */
+		capReset();
+		sendStr(&c, "\026", 400);
+		expect(contains(cap, "\033[1;22r"),
+		       "no scrolling region for C-v");
+		expect(!contains(cap, "row 041"),
+		       "line already on screen sent again");
+		expect(contains(shown(), "row 040"),
+		       "screen wrong after C-v");
+		capReset();
+		sendStr(&c, "\033v", 400); /* M-v */
+		expect(contains(cap, "\033[1;22r") &&
+			       !contains(cap, "row 040"),
+		       "M-v did not shift the lines kept");
+		expect(contains(shown(), "row 030") &&
+			       !contains(shown(), "row 045"),
+		       "screen wrong after M-v");
+		reap(&c);
+	}
+	unlink(path);
+	finish();
+}
+
+/* The editor asks whether the terminal does synchronized output, and
+ * once told it does, wraps each frame in CSI ?2026h ... CSI ?2026l.
+ * The answer is not a key: nothing is reported or typed. */
+static void scenarioSyncOutput(void) {
+	struct child c;
+	begin("synchronized output after DECRQM reply");
+	if (spawnEmil(&c) == 0) {
+		expect(contains(cap, "\033[?2026$p"), "no DECRQM query");
+		expect(!contains(cap, "\033[?2026h"),
+		       "frame wrapped before the terminal answered");
+		sendStr(&c, "\033[?2026;2$y", 300);
+		capReset();
+		sendStr(&c, "x", 400);
+		expect(contains(cap, "\033[?2026h") &&
+			       contains(cap, "\033[?2026l"),
+		       "frame not wrapped");
+		expect(!contains(cap, "Unknown"), "reply reported as a key");
+		expect(contains(shown(), "x") && !contains(shown(), "2026"),
+		       "reply typed into the buffer");
+		reap(&c);
+	}
+	finish();
+}
+
 /* ---- terminal ownership (invariant 4.5) ------------------------ */
 
 /* While the editor is running it owns the terminal in raw mode.  The
@@ -882,6 +1074,9 @@ int main(int argc, char **argv) {
 	scenarioSlowSplitSequence();
 	scenarioMappedKeys();
 	scenarioUtf8Typing();
+	scenarioPageScrollShifts();
+	scenarioSyncOutput();
+	scenarioBracketedPaste();
 	scenarioTerminalOwnedAfterSuspend("terminal owned after C-z", "\032");
 	scenarioTerminalOwnedAfterSuspend("terminal owned after C-x z",
 					  "\030z");
@@ -269,7 +269,7 @@ static int checkInvariants(struct buffer *buf) {
 	if (!checkFlatInvariants(buf))
 		return 0;
 	for (int i = 0; i < buf->numrows; i++) {
-		if (!utf8_validate(buf->row[i].chars, buf->row[i].size)) {
+		if (!utf8_validate(bufRow(buf, i)->chars, bufRow(buf, i)->size)) {
 			snprintf(fail_reason, sizeof(fail_reason),
 				 "row %d is not valid UTF-8", i);
 			return 0;
@@ -289,14 +289,14 @@ static int checkInvariants(struct buffer *buf) {
 			 buf->numrows);
 		return 0;
 	}
-	if (buf->cx < 0 || buf->cx > buf->row[buf->cy].size) {
+	if (buf->cx < 0 || buf->cx > bufRow(buf, buf->cy)->size) {
 		snprintf(fail_reason, sizeof(fail_reason),
 			 "cx %d out of bounds (row size %d)", buf->cx,
-			 buf->row[buf->cy].size);
+			 bufRow(buf, buf->cy)->size);
 		return 0;
 	}
-	if (buf->cx < buf->row[buf->cy].size &&
-	    utf8_isCont(buf->row[buf->cy].chars[buf->cx])) {
+	if (buf->cx < bufRow(buf, buf->cy)->size &&
+	    utf8_isCont(bufRow(buf, buf->cy)->chars[buf->cx])) {
 		snprintf(fail_reason, sizeof(fail_reason),
 			 "cursor at (%d,%d) is mid-character", buf->cx,
 			 buf->cy);
@@ -308,11 +308,11 @@ static int checkInvariants(struct buffer *buf) {
 	 * operation, not merely at save.  This is the check that keeps
 	 * a future edit path from quietly dropping the terminator: the
 	 * consequence would otherwise show up only as a file on disk. */
-	if (!bufferIsEmpty(buf) && buf->row[buf->numrows - 1].size != 0) {
+	if (!bufferIsEmpty(buf) && bufRow(buf, buf->numrows - 1)->size != 0) {
 		snprintf(fail_reason, sizeof(fail_reason),
 			 "last row \"%.20s\" is not empty: buffer does not "
 			 "end in a newline",
-			 (const char *)buf->row[buf->numrows - 1].chars);
+			 (const char *)bufRow(buf, buf->numrows - 1)->chars);
 		return 0;
 	}
 	return 1;
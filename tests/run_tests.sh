@@ -193,7 +193,7 @@ TEST_OBJECTS="decoder.o unicode.o buffer.o region.o undo.o transform.o \
     find.o pipe.o register.o fileio.o display.o  keymap.o \
     edit.o prompt.o util.o completion.o history.o base64.o abuf.o \
     window.o ctags.o adjust.o mutate.o wrap.o motion.o dbuf.o \
-    emil_subprocess.o palette.o tests/stubs.o"
+    emil_subprocess.o palette.o view.o linediff.o screen.o tests/stubs.o"
 
 echo "Unit tests:"
 
@@ -204,7 +204,8 @@ echo "Unit tests:"
 SUITES="decoder unicode wcwidth buffer undo coalesce edit fileio relpath offset
     visual_line utf8_validate rect replace transform subprocess shell adjust
     history abuf tilde keymap kill_ring insert_file status_bar cjk_indic
-    warnings ctags find display prompt regex_semantics writeall"
+    warnings ctags find display prompt regex_semantics writeall view linediff
+    screen"
 
 listed=$(echo $SUITES | wc -w)
 present=$(ls tests/test_*.c 2>/dev/null | wc -l)
@@ -46,6 +46,14 @@ int readKey(void) {
 	return 0;
 }
 
+/* Whether a key is waiting, for code that stops long work when one
+ * is.  Set by a test to simulate the user typing ahead. */
+int test_input_pending = 0;
+
+int inputPending(void) {
+	return test_input_pending;
+}
+
 void getWindowSize(int *rows, int *cols) {
 	*rows = 24;
 	*cols = 80;
@@ -58,5 +66,8 @@ void copyToClipboard(const uint8_t *text) {
 void deserializeUnicode(void) {
 }
 
+void deserializePaste(void) {
+}
+
 void openShellDrawer(void) {
 }
@@ -250,14 +250,14 @@ void test_markring_pop_jumps_to_right_line(void) {
 	for (int i = 0; i < 4; i++)
 		killLine(1);
 
-	TEST_ASSERT_EQUAL_STRING("TARGET", (char *)buf->row[2].chars);
+	TEST_ASSERT_EQUAL_STRING("TARGET", (char *)bufRow(buf, 2)->chars);
 
 	popMark();
 
 	/* popMark moves point to the old live mark and rotates the
 	 * ring entry into the mark; the entry must now name TARGET. */
 	TEST_ASSERT_EQUAL_INT(2, buf->marky);
-	TEST_ASSERT_EQUAL_STRING("TARGET", (char *)buf->row[buf->marky].chars);
+	TEST_ASSERT_EQUAL_STRING("TARGET", (char *)bufRow(buf, buf->marky)->chars);
 }
 
 void test_markring_pop_stays_on_char_boundary(void) {
@@ -274,7 +274,7 @@ void test_markring_pop_stays_on_char_boundary(void) {
 	buf->cx = 0;
 	buf->cy = 0;
 	delChar(1); /* delete 'x' */
-	TEST_ASSERT_EQUAL_STRING("caf\xC3\xA9", (char *)buf->row[0].chars);
+	TEST_ASSERT_EQUAL_STRING("caf\xC3\xA9", (char *)bufRow(buf, 0)->chars);
 
 	popMark();
 
@@ -282,15 +282,15 @@ void test_markring_pop_stays_on_char_boundary(void) {
 	TEST_ASSERT_EQUAL_INT(3, buf->markx);
 	TEST_ASSERT_EQUAL_INT(0, buf->marky);
 	TEST_ASSERT(buf->markx == 0 ||
-		    !utf8_isCont(buf->row[buf->marky].chars[buf->markx]));
+		    !utf8_isCont(bufRow(buf, buf->marky)->chars[buf->markx]));
 
 	/* Typing at the mark (as C-x C-x then self-insert does) must
 	 * leave the row valid: this is the corruption endpoint. */
 	buf->cx = buf->markx;
 	buf->cy = buf->marky;
 	selfInsert(buf, 'Z', 1);
-	TEST_ASSERT(utf8_validate(buf->row[0].chars, buf->row[0].size));
-	TEST_ASSERT_EQUAL_STRING("cafZ\xC3\xA9", (char *)buf->row[0].chars);
+	TEST_ASSERT(utf8_validate(bufRow(buf, 0)->chars, bufRow(buf, 0)->size));
+	TEST_ASSERT_EQUAL_STRING("cafZ\xC3\xA9", (char *)bufRow(buf, 0)->chars);
 }
 
 void test_markring_pop_clamps_out_of_range_entry(void) {
@@ -310,7 +310,7 @@ void test_markring_pop_clamps_out_of_range_entry(void) {
 
 	TEST_ASSERT(buf->marky >= 0 && buf->marky < buf->numrows);
 	TEST_ASSERT(buf->markx >= 0 &&
-		    buf->markx <= buf->row[buf->marky].size);
+		    buf->markx <= bufRow(buf, buf->marky)->size);
 }
 
 void test_markring_multiple_entries_all_adjusted(void) {
@@ -332,7 +332,7 @@ void test_markring_multiple_entries_all_adjusted(void) {
 	buf->cy = 0;
 	killLine(1);
 	killLine(1);
-	TEST_ASSERT_EQUAL_STRING("BBB", (char *)buf->row[0].chars);
+	TEST_ASSERT_EQUAL_STRING("BBB", (char *)bufRow(buf, 0)->chars);
 
 	TEST_ASSERT_EQUAL_INT(0, buf->mark_ring[0].cy); /* was 1 */
 	TEST_ASSERT_EQUAL_INT(1, buf->mark_ring[1].cy); /* was 2 */
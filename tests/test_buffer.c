@@ -7,6 +7,8 @@
 #include "completion.h"
 #include "buffer.h"
 #include "util.h"
+#include "dbuf.h"
+#include "fileio.h"
 #include <stdint.h>
 
 /* ---- Kill-buffer confirmation ----
@@ -65,8 +67,8 @@ void test_insert_row_beginning(void) {
 	insertRow(buf, 0, (const uint8_t *)"second", 6);
 	insertRow(buf, 0, (const uint8_t *)"first", 5);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("first", (char *)buf->row[0].chars);
-	TEST_ASSERT_EQUAL_STRING("second", (char *)buf->row[1].chars);
+	TEST_ASSERT_EQUAL_STRING("first", (char *)bufRow(buf, 0)->chars);
+	TEST_ASSERT_EQUAL_STRING("second", (char *)bufRow(buf, 1)->chars);
 }
 
 void test_insert_row_end(void) {
@@ -75,7 +77,7 @@ void test_insert_row_end(void) {
 	insertRow(buf, 1, (const uint8_t *)"second", 6);
 	insertRow(buf, 2, (const uint8_t *)"third", 5);
 	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("third", (char *)buf->row[2].chars);
+	TEST_ASSERT_EQUAL_STRING("third", (char *)bufRow(buf, 2)->chars);
 }
 
 void test_del_row_beginning(void) {
@@ -85,7 +87,7 @@ void test_del_row_beginning(void) {
 	insertRow(buf, 2, (const uint8_t *)"third", 5);
 	delRow(buf, 0);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("second", (char *)buf->row[0].chars);
+	TEST_ASSERT_EQUAL_STRING("second", (char *)bufRow(buf, 0)->chars);
 }
 
 void test_del_row_end(void) {
@@ -95,69 +97,197 @@ void test_del_row_end(void) {
 	insertRow(buf, 2, (const uint8_t *)"third", 5);
 	delRow(buf, 2);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("second", (char *)buf->row[1].chars);
+	TEST_ASSERT_EQUAL_STRING("second", (char *)bufRow(buf, 1)->chars);
+}
+
+/* The row array is a gap buffer, so rows that are adjacent logically
+ * need not be adjacent in memory.  Edit at scattered rows, forcing the
+ * gap back and forth and the array through several regrowths, and
+ * check every row against a flat model after each step. */
+void test_row_gap_scattered_edits(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	delRow(buf, 0);
+	int model[256];
+	int n = 0;
+	unsigned seed = 7;
+	for (int step = 0; step < 600; step++) {
+		seed = seed * 1103515245u + 12345u;
+		int del = n > 0 && (seed >> 16) % 3 == 0;
+		int at = n > 0 ? (int)((seed >> 8) % (unsigned)(n + !del)) : 0;
+		if (del) {
+			delRow(buf, at);
+			memmove(&model[at], &model[at + 1],
+				sizeof(int) * (n - at - 1));
+			n--;
+		} else if (n < 256) {
+			char s[16];
+			int len = snprintf(s, sizeof(s), "%d", step);
+			insertRow(buf, at, (const uint8_t *)s, len);
+			memmove(&model[at + 1], &model[at],
+				sizeof(int) * (n - at));
+			model[at] = step;
+			n++;
+		}
+		TEST_ASSERT_EQUAL_INT(n, buf->numrows);
+		for (int i = 0; i < n; i++) {
+			char s[16];
+			snprintf(s, sizeof(s), "%d", model[i]);
+			TEST_ASSERT_EQUAL_STRING(s, row_str(buf, i));
+		}
+	}
+	bufferEnsureRow(buf);
+}
+
+void test_insert_rows_splits_at_newlines(void) {
+	struct buffer *buf = make_test_buffer("top");
+	int n = insertRows(buf, 1, (const uint8_t *)"a\n\nbc\n", 6);
+	TEST_ASSERT_EQUAL_INT(4, n);
+	TEST_ASSERT_EQUAL_INT(6, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("top", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("a", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 2));
+	TEST_ASSERT_EQUAL_STRING("bc", row_str(buf, 3));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 4));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 5));
+	TEST_ASSERT_EQUAL_INT(0, insertRows(buf, 7, (const uint8_t *)"x", 1));
+}
+
+/* A range delete takes the rows out in one piece and leaves its
+ * neighbours in order, including when the range runs to the end. */
+void test_del_rows_range(void) {
+	const char *lines[] = { "a", "b", "c", "d", "e" };
+	struct buffer *buf = make_test_buffer_lines(lines, 5);
+	delRows(buf, 1, 3);
+	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("a", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("e", row_str(buf, 1));
+	delRows(buf, 1, 5); /* past the end: refused */
+	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
+	delRows(buf, 1, 2);
+	TEST_ASSERT_EQUAL_INT(1, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("a", row_str(buf, 0));
+}
+
+/* A paste far larger than the spare capacity grows the array once and
+ * lands in order between the rows either side of it. */
+void test_insert_rows_grows_past_capacity(void) {
+	const char *lines[] = { "first", "last" };
+	struct buffer *buf = make_test_buffer_lines(lines, 2);
+	struct dbuf d = DBUF_INIT;
+	for (int i = 0; i < 1000; i++) {
+		char s[16];
+		int len = snprintf(s, sizeof(s), "%d\n", i);
+		dbuf_append(&d, (const uint8_t *)s, len);
+	}
+	int len;
+	uint8_t *text = dbuf_detach(&d, &len);
+	insertRows(buf, 1, text, (size_t)len - 1); /* drop the last '\n' */
+	free(text);
+	TEST_ASSERT_EQUAL_INT(1003, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("first", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("0", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("999", row_str(buf, 1000));
+	TEST_ASSERT_EQUAL_STRING("last", row_str(buf, 1001));
+}
+
+/* Rows start out in the buffer's arena and leave it only to grow; the
+ * rows packed around them must not notice. */
+void test_arena_row_moves_out_on_growth(void) {
+	const char *lines[] = { "one", "two", "three" };
+	struct buffer *buf = make_test_buffer_lines(lines, 3);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, 1)->charcap);
+	rowInsertChar(buf, bufRow(buf, 1), 3, 's');
+	TEST_ASSERT_TRUE(bufRow(buf, 1)->charcap >= 5);
+	TEST_ASSERT_EQUAL_STRING("one", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("twos", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("three", row_str(buf, 2));
+}
+
+void test_compact_rows_after_edits(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	for (int i = 0; i < 2000; i++) {
+		char s[32];
+		int len = snprintf(s, sizeof(s), "line number %d", i);
+		insertRow(buf, i, (const uint8_t *)s, len);
+	}
+	delRows(buf, 0, 1500);
+	for (int i = 0; i < 100; i++)
+		rowInsertChar(buf, bufRow(buf, i), 0, '>');
+	size_t before;
+	char *text = rowsToString(buf, &before);
+
+	bufCompactRows(buf);
+	size_t after;
+	char *again = rowsToString(buf, &after);
+	TEST_ASSERT_EQUAL_UINT(before, after);
+	TEST_ASSERT_TRUE(memcmp(text, again, before) == 0);
+	for (int i = 0; i < buf->numrows; i++)
+		TEST_ASSERT_EQUAL_INT(0, bufRow(buf, i)->charcap);
+	TEST_ASSERT_EQUAL_STRING(">line number 1500", row_str(buf, 0));
+	free(text);
+	free(again);
 }
 
 void test_row_insert_char(void) {
 	struct buffer *buf = make_test_buffer("AC");
-	rowInsertChar(buf, &buf->row[0], 1, 'B');
-	TEST_ASSERT_EQUAL_INT(3, buf->row[0].size);
-	TEST_ASSERT_EQUAL_STRING("ABC", (char *)buf->row[0].chars);
+	rowInsertChar(buf, bufRow(buf, 0), 1, 'B');
+	TEST_ASSERT_EQUAL_INT(3, bufRow(buf, 0)->size);
+	TEST_ASSERT_EQUAL_STRING("ABC", (char *)bufRow(buf, 0)->chars);
 }
 
 /* ---- Coordinate mapping ---- */
 
 void test_chars_to_display_ascii(void) {
 	struct buffer *buf = make_test_buffer("Hello");
-	TEST_ASSERT_EQUAL_INT(0, charsToDisplayColumn(&buf->row[0], 0));
-	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(&buf->row[0], 3));
-	TEST_ASSERT_EQUAL_INT(5, charsToDisplayColumn(&buf->row[0], 5));
+	TEST_ASSERT_EQUAL_INT(0, charsToDisplayColumn(bufRow(buf, 0), 0));
+	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(bufRow(buf, 0), 3));
+	TEST_ASSERT_EQUAL_INT(5, charsToDisplayColumn(bufRow(buf, 0), 5));
 }
 
 void test_chars_to_display_tab(void) {
 	struct buffer *buf = make_test_buffer("\tA");
-	TEST_ASSERT_EQUAL_INT(0, charsToDisplayColumn(&buf->row[0], 0));
-	TEST_ASSERT_EQUAL_INT(8, charsToDisplayColumn(&buf->row[0], 1));
-	TEST_ASSERT_EQUAL_INT(9, charsToDisplayColumn(&buf->row[0], 2));
+	TEST_ASSERT_EQUAL_INT(0, charsToDisplayColumn(bufRow(buf, 0), 0));
+	TEST_ASSERT_EQUAL_INT(8, charsToDisplayColumn(bufRow(buf, 0), 1));
+	TEST_ASSERT_EQUAL_INT(9, charsToDisplayColumn(bufRow(buf, 0), 2));
 }
 
 void test_chars_to_display_control(void) {
 	struct buffer *buf = make_test_buffer("\x01"
 					      "A");
-	TEST_ASSERT_EQUAL_INT(2, charsToDisplayColumn(&buf->row[0], 1));
-	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(&buf->row[0], 2));
+	TEST_ASSERT_EQUAL_INT(2, charsToDisplayColumn(bufRow(buf, 0), 1));
+	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(bufRow(buf, 0), 2));
 }
 
 void test_chars_to_display_multibyte(void) {
 	/* "A¢B" — ¢ is 2 bytes, 1 column */
 	struct buffer *buf = make_test_buffer("A\xC2\xA2"
 					      "B");
-	TEST_ASSERT_EQUAL_INT(1, charsToDisplayColumn(&buf->row[0], 1));
-	TEST_ASSERT_EQUAL_INT(2, charsToDisplayColumn(&buf->row[0], 3));
-	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(&buf->row[0], 4));
+	TEST_ASSERT_EQUAL_INT(1, charsToDisplayColumn(bufRow(buf, 0), 1));
+	TEST_ASSERT_EQUAL_INT(2, charsToDisplayColumn(bufRow(buf, 0), 3));
+	TEST_ASSERT_EQUAL_INT(3, charsToDisplayColumn(bufRow(buf, 0), 4));
 }
 
 void test_calculate_line_width(void) {
 	struct buffer *buf = make_test_buffer("ABCDE");
-	TEST_ASSERT_EQUAL_INT(5, calculateLineWidth(&buf->row[0]));
+	TEST_ASSERT_EQUAL_INT(5, calculateLineWidth(bufRow(buf, 0)));
 	/* Destroy before creating a new buffer to avoid orphaning this one */
 	destroyBuffer(buf);
 	E.headbuf = NULL;
 
 	buf = make_test_buffer("\tX");
-	TEST_ASSERT_EQUAL_INT(9, calculateLineWidth(&buf->row[1 - 1]));
+	TEST_ASSERT_EQUAL_INT(9, calculateLineWidth(bufRow(buf, 1 - 1)));
 }
 
 /* ---- Screen line counting ---- */
 
 void test_count_screen_lines_exact(void) {
 	struct buffer *buf = make_test_buffer("1234567890");
-	TEST_ASSERT_EQUAL_INT(1, countScreenLines(&buf->row[0], 10));
+	TEST_ASSERT_EQUAL_INT(1, countScreenLines(bufRow(buf, 0), 10));
 }
 
 void test_count_screen_lines_long(void) {
 	struct buffer *buf = make_test_buffer("abcdefghijklmnopqrstuvwxy");
-	int lines = countScreenLines(&buf->row[0], 10);
+	int lines = countScreenLines(bufRow(buf, 0), 10);
 	TEST_ASSERT(lines >= 2);
 }
 
@@ -165,7 +295,7 @@ void test_word_wrap_break(void) {
 	struct buffer *buf = make_test_buffer("hello world");
 	int break_col, break_byte;
 	int more =
-		wordWrapBreak(&buf->row[0], 7, 0, 0, &break_col, &break_byte);
+		wordWrapBreak(bufRow(buf, 0), 7, 0, 0, &break_col, &break_byte);
 	TEST_ASSERT_EQUAL_INT(1, more);
 	TEST_ASSERT_EQUAL_INT(6, break_col);
 	TEST_ASSERT_EQUAL_INT(6, break_byte);
@@ -282,6 +412,12 @@ int main(void) {
 	RUN_TEST(test_del_row_beginning);
 	RUN_TEST(test_del_row_end);
 	RUN_TEST(test_row_insert_char);
+	RUN_TEST(test_row_gap_scattered_edits);
+	RUN_TEST(test_insert_rows_splits_at_newlines);
+	RUN_TEST(test_del_rows_range);
+	RUN_TEST(test_insert_rows_grows_past_capacity);
+	RUN_TEST(test_arena_row_moves_out_on_growth);
+	RUN_TEST(test_compact_rows_after_edits);
 
 	RUN_TEST(test_chars_to_display_ascii);
 	RUN_TEST(test_chars_to_display_tab);
@@ -162,14 +162,14 @@ void test_forward_word_cjk_mixed_with_ascii(void) {
 	TEST_ASSERT_EQUAL(11, E.buf->cx); /* past 文 */
 
 	forwardWord(1);
-	int row_size = E.buf->row[0].size;
+	int row_size = bufRow(E.buf, 0)->size;
 	TEST_ASSERT_EQUAL(row_size, E.buf->cx); /* end of "world" */
 }
 
 void test_backward_word_cjk_mixed_with_ascii(void) {
 	/* "hello中文world" */
 	struct buffer *buf = make_test_buffer("hello\xE4\xB8\xAD\xE6\x96\x87world");
-	buf->cx = buf->row[0].size; /* end */
+	buf->cx = bufRow(buf, 0)->size; /* end */
 
 	backWord(1);
 	TEST_ASSERT_EQUAL(11, E.buf->cx); /* start of "world" */
@@ -165,7 +165,7 @@ void test_long_run_is_capped(void) {
 	for (int i = 0; i < 500; i++)
 		selfInsert(buf, 'x', 1);
 
-	TEST_ASSERT_EQUAL_INT(500, buf->row[0].size);
+	TEST_ASSERT_EQUAL_INT(500, bufRow(buf, 0)->size);
 	TEST_ASSERT(nrecords(buf) >= 500 / 21);
 	TEST_ASSERT(nrecords(buf) <= 500 / 20 + 2);
 
@@ -217,7 +217,7 @@ void test_run_does_not_fold_across_bulk_edit(void) {
 
 	selfInsert(buf, 'X', 1);
 	mutateInsert(buf, 3, 0, (const uint8_t *)"ZZ", 2, NULL, NULL);
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	selfInsert(buf, 'Y', 1);
 
 	TEST_ASSERT_EQUAL_INT(3, nrecords(buf));
@@ -517,7 +517,7 @@ void test_prefix_argument_repeat_is_one_record(void) {
 
 	selfInsert(buf, 'x', 100);
 
-	TEST_ASSERT_EQUAL_INT(101, buf->row[0].size);
+	TEST_ASSERT_EQUAL_INT(101, bufRow(buf, 0)->size);
 	TEST_ASSERT_EQUAL_INT(1, nrecords(buf));
 
 	doUndo(buf, 1);
@@ -169,6 +169,37 @@ void test_recognized_keys_report_nothing(void) {
 	TEST_ASSERT_EQUAL_INT(0, n);
 }
 
+/* The terminal's answer to the synchronized-output query is taken,
+ * never reported as an unknown key. */
+void test_sync_output_reports(void) {
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_SUPPORTED, decodeStr("[?2026;1$y"));
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_SUPPORTED, decodeStr("[?2026;2$y"));
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_SUPPORTED, decodeStr("[?2026;3$y"));
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_UNSUPPORTED, decodeStr("[?2026;0$y"));
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_UNSUPPORTED, decodeStr("[?2026;4$y"));
+
+	uint8_t seen[ESC_SEEN_MAX];
+	int n = 99;
+	TEST_ASSERT_EQUAL_INT(KEY_SYNC_SUPPORTED,
+			      decodeBytes((const uint8_t *)"[?2026;2$y", 10,
+					  seen, &n));
+	TEST_ASSERT_EQUAL_INT(0, n);
+
+	/* Other modes' reports stay unknown. */
+	TEST_ASSERT_EQUAL_INT(033, decodeStr("[?2004;1$y"));
+	TEST_ASSERT_EQUAL_INT(033, decodeStr("[?2026;9$y"));
+}
+
+/* The bracketed-paste markers decode to their own tokens; nearby
+ * numbers stay unknown. */
+void test_paste_markers(void) {
+	TEST_ASSERT_EQUAL_INT(KEY_PASTE_START, decodeStr("[200~"));
+	TEST_ASSERT_EQUAL_INT(KEY_PASTE_END, decodeStr("[201~"));
+	TEST_ASSERT_EQUAL_INT(033, decodeStr("[202~"));
+	TEST_ASSERT_EQUAL_INT(033, decodeStr("[210~"));
+	TEST_ASSERT_EQUAL_INT(033, decodeStr("[200$"));
+}
+
 /* ---- The lone-ESC rule ---- */
 
 void test_lone_esc_before_sequence_is_discarded(void) {
@@ -247,6 +278,8 @@ int main(void) {
 	RUN_TEST(test_unknown_sequences_report_and_consume);
 	RUN_TEST(test_malformed_csi_stops_at_bad_byte);
 	RUN_TEST(test_recognized_keys_report_nothing);
+	RUN_TEST(test_sync_output_reports);
+	RUN_TEST(test_paste_markers);
 	RUN_TEST(test_lone_esc_before_sequence_is_discarded);
 	RUN_TEST(test_long_csi_consumed_report_truncated);
 	RUN_TEST(test_random_stream_soak);
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /* Portable substring search over a byte range (the haystack contains
  * escape sequences, not a NUL-terminated string, and memmem is a GNU
@@ -170,8 +171,8 @@ void test_scroll_leaves_cursor_on_char_boundary(void) {
 	processKeypress(CMD_SCROLL_UP);
 
 	TEST_ASSERT_EQUAL_INT(0, buf->cy);
-	TEST_ASSERT(buf->cx == buf->row[0].size ||
-		    !utf8_isCont(buf->row[0].chars[buf->cx]));
+	TEST_ASSERT(buf->cx == bufRow(buf, 0)->size ||
+		    !utf8_isCont(bufRow(buf, 0)->chars[buf->cx]));
 	cleanupTestEditor();
 }
 
@@ -275,7 +276,7 @@ void test_clamp_cursor_zero_height_window_stays_in_bounds(void) {
 
 	TEST_ASSERT(buf->cy >= 0);
 	TEST_ASSERT(buf->cy < buf->numrows);
-	TEST_ASSERT(buf->cx <= buf->row[buf->cy].size);
+	TEST_ASSERT(buf->cx <= bufRow(buf, buf->cy)->size);
 	cleanupTestEditor();
 }
 
@@ -303,7 +304,7 @@ void test_page_down_zero_height_window_stays_in_bounds(void) {
 
 	TEST_ASSERT(buf->cy >= 0);
 	TEST_ASSERT(buf->cy < buf->numrows);
-	TEST_ASSERT(buf->cx <= buf->row[buf->cy].size);
+	TEST_ASSERT(buf->cx <= bufRow(buf, buf->cy)->size);
 	cleanupTestEditor();
 }
 
@@ -330,7 +331,7 @@ static struct buffer *wide_row_buffer(void) {
 	E.windows[0]->buf = buf;
 	E.windows[0]->height = 4;
 	buf->word_wrap = 0;
-	buf->row[0].cached_width = -1;
+	bufRow(buf, 0)->cached_width = -1;
 	return buf;
 }
 
@@ -341,7 +342,7 @@ void test_drawrows_wide_row_does_not_compute_full_width(void) {
 
 	free(render_rows(E.windows[0], NULL));
 
-	TEST_ASSERT_EQUAL_INT(-1, buf->row[0].cached_width);
+	TEST_ASSERT_EQUAL_INT(-1, bufRow(buf, 0)->cached_width);
 	cleanupTestEditor();
 }
 
@@ -377,7 +378,7 @@ void test_drawrows_pads_short_row_to_full_width(void) {
  * recomputed -- and the row is left uncached, so nothing walked it. */
 void test_statusbar_uses_the_frames_cursor_column(void) {
 	struct buffer *buf = wide_row_buffer();
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 
 	struct abuf ab = ABUF_INIT;
@@ -386,7 +387,7 @@ void test_statusbar_uses_the_frames_cursor_column(void) {
 	abFree(&ab);
 
 	TEST_ASSERT(found);
-	TEST_ASSERT_EQUAL_INT(-1, buf->row[0].cached_width);
+	TEST_ASSERT_EQUAL_INT(-1, bufRow(buf, 0)->cached_width);
 	cleanupTestEditor();
 }
 
@@ -404,11 +405,11 @@ void test_scroll_returns_the_cursor_display_column(void) {
 	buf->word_wrap = 0;
 	buf->cy = 0;
 
-	for (int cx = 0; cx <= buf->row[0].size; cx++) {
-		if (cx < buf->row[0].size && utf8_isCont(buf->row[0].chars[cx]))
+	for (int cx = 0; cx <= bufRow(buf, 0)->size; cx++) {
+		if (cx < bufRow(buf, 0)->size && utf8_isCont(bufRow(buf, 0)->chars[cx]))
 			continue;
 		buf->cx = cx;
-		int expected = charsToDisplayColumn(&buf->row[0], cx);
+		int expected = charsToDisplayColumn(bufRow(buf, 0), cx);
 		TEST_ASSERT_EQUAL_INT(expected, scroll());
 	}
 	cleanupTestEditor();
@@ -591,6 +592,106 @@ void test_viewport_stable_across_an_edit_above_a_non_focused_window(void) {
 	cleanupTestEditor();
 }
 
+/* Typing one character in the middle of a full screen sends that
+ * character and the status bar's changes: tens of bytes, where the
+ * first frame is kilobytes. */
+void test_typing_one_character_sends_tens_of_bytes(void) {
+	initTestEditor();
+	static char text[40][72];
+	const char *lines[40];
+	for (int i = 0; i < 40; i++) {
+		memset(text[i], 'a' + i % 26, 70);
+		text[i][70] = '\0';
+		lines[i] = text[i];
+	}
+	struct buffer *buf = make_test_buffer_lines(lines, 40);
+
+	muteStdout();
+	invalidateScreen();
+	refreshScreen();
+	size_t first = lastFrameBytes();
+	refreshScreen();
+	size_t again = lastFrameBytes();
+	buf->cy = 10;
+	buf->cx = 35;
+	insertChar(buf, 'X', 1);
+	refreshScreen();
+	size_t typed = lastFrameBytes();
+	unmuteStdout();
+
+	TEST_ASSERT_TRUE(first > 1500);
+	TEST_ASSERT_TRUE(again < 40);
+	TEST_ASSERT_TRUE(typed < 100);
+	cleanupTestEditor();
+}
+
+/* Scrolling the window a few lines shifts what the terminal shows and
+ * sends only the lines that came into view. */
+void test_scrolling_sends_only_the_exposed_lines(void) {
+	initTestEditor();
+	static char text[60][72];
+	const char *lines[60];
+	for (int i = 0; i < 60; i++) {
+		snprintf(text[i], sizeof(text[i]), "%02d ", i);
+		memset(text[i] + 3, 'a' + i % 26, 67);
+		text[i][70] = '\0';
+		lines[i] = text[i];
+	}
+	struct buffer *buf = make_test_buffer_lines(lines, 60);
+	struct window *win = E.windows[0];
+
+	muteStdout();
+	invalidateScreen();
+	refreshScreen();
+	size_t first = lastFrameBytes();
+	scrollViewport(win, buf, 3);
+	clampCursorToViewport(win, buf);
+	refreshScreen();
+	size_t down = lastFrameBytes();
+	scrollViewport(win, buf, -2);
+	clampCursorToViewport(win, buf);
+	refreshScreen();
+	size_t up = lastFrameBytes();
+	unmuteStdout();
+
+	TEST_ASSERT_TRUE(first > 1500);
+	TEST_ASSERT_TRUE(down < 400);
+	TEST_ASSERT_TRUE(up < 300);
+	cleanupTestEditor();
+}
+
+/* Frames put off for waiting keys are owed once the deadline passes,
+ * counted, and paid by the next refresh. */
+void test_skipped_frames_fall_due(void) {
+	initTestEditor();
+	make_test_buffer("text");
+
+	muteStdout();
+	refreshScreen();
+	unmuteStdout();
+	TEST_ASSERT_TRUE(lastFrameTime() > 0);
+	TEST_ASSERT_FALSE(frameDue());
+
+	unsigned long skipped = skippedFrames();
+	skipFrame();
+	skipFrame();
+	TEST_ASSERT_EQUAL_INT(2, (int)(skippedFrames() - skipped));
+
+	/* Past the deadline, or four times a slow frame's cost. */
+	long wait = 20 * 1000000L;
+	if (lastFrameTime() * 5 > wait)
+		wait = lastFrameTime() * 5;
+	struct timespec nap = { wait / 1000000000L, wait % 1000000000L };
+	nanosleep(&nap, NULL);
+	TEST_ASSERT_TRUE(frameDue());
+
+	muteStdout();
+	refreshScreen();
+	unmuteStdout();
+	TEST_ASSERT_FALSE(frameDue());
+	cleanupTestEditor();
+}
+
 /* These tests manage the editor themselves. */
 void setUp(void) {
 }
@@ -626,5 +727,9 @@ int main(void) {
 	RUN_TEST(
 		test_viewport_stable_across_an_edit_above_a_non_focused_window);
 
+	RUN_TEST(test_typing_one_character_sends_tens_of_bytes);
+	RUN_TEST(test_scrolling_sends_only_the_exposed_lines);
+	RUN_TEST(test_skipped_frames_fall_due);
+
 	return TEST_END();
 }
@@ -76,6 +76,53 @@ void test_insert_unicode_readonly_records_no_undo(void) {
 	TEST_ASSERT_EQUAL_STRING("h\xC3\xA9llo", row_str(buf, 0));
 }
 
+/* A paste goes in as it came, indentation and all, and one undo takes
+ * it out again. */
+void test_paste_inserts_in_one_undo(void) {
+	struct buffer *buf = make_test_buffer("ab");
+	buf->cx = 1;
+	static const char text[] = "x\n    y\n\tz";
+	dbuf_append(&E.paste, (const uint8_t *)text, (int)sizeof(text) - 1);
+	processKeypress(CMD_PASTE);
+
+	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("ax", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("    y", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("\tzb", row_str(buf, 2));
+	TEST_ASSERT_EQUAL_INT(2, buf->cx);
+	TEST_ASSERT_EQUAL_INT(2, buf->cy);
+
+	doUndo(buf, 1);
+	TEST_ASSERT_EQUAL_INT(2, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("ab", row_str(buf, 0));
+}
+
+/* A stray Latin-1 byte, a truncated sequence or a NUL would break the
+ * rows' UTF-8 invariant, so a paste holding one is refused whole. */
+void test_paste_rejects_invalid_utf8(void) {
+	static const char *bad[] = { "caf\xe9", "x\xe2\x82", "a\0b" };
+	static const int lens[] = { 4, 3, 3 };
+	for (int i = 0; i < 3; i++) {
+		struct buffer *buf = make_test_buffer("ab");
+		buf->cx = 1;
+		E.paste.len = 0;
+		dbuf_append(&E.paste, (const uint8_t *)bad[i], lens[i]);
+		E.statusmsg[0] = '\0';
+		processKeypress(CMD_PASTE);
+
+		TEST_ASSERT_EQUAL_INT(2, buf->numrows);
+		TEST_ASSERT_EQUAL_STRING("ab", row_str(buf, 0));
+		TEST_ASSERT_EQUAL_INT(1, buf->cx);
+		TEST_ASSERT_EQUAL_INT(0, buf->dirty);
+		TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "invalid UTF-8"));
+
+		/* Destroyed here, not by the harness: the next pass
+		 * replaces it in E.headbuf. */
+		destroyBuffer(buf);
+		E.headbuf = NULL;
+	}
+}
+
 void test_self_insert_readonly_does_not_move_mark(void) {
 	struct buffer *buf = make_test_buffer("Hello");
 	buf->read_only = 1;
@@ -132,9 +179,9 @@ void test_insert_newline_and_indent(void) {
 	insertNewlineAndIndent(1);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
 	TEST_ASSERT_EQUAL_STRING("    Hello", row_str(buf, 0));
-	TEST_ASSERT(buf->row[1].size >= 4);
-	TEST_ASSERT(buf->row[1].chars[0] == ' ');
-	TEST_ASSERT(buf->row[1].chars[3] == ' ');
+	TEST_ASSERT(bufRow(buf, 1)->size >= 4);
+	TEST_ASSERT(bufRow(buf, 1)->chars[0] == ' ');
+	TEST_ASSERT(bufRow(buf, 1)->chars[3] == ' ');
 }
 
 /* Regression: C-j at line 0 of a read-only buffer read row[-1]
@@ -471,12 +518,12 @@ void test_backspace_stray_continuation_byte(void) {
 	struct buffer *buf = make_test_buffer("x");
 	E.buf = buf;
 	/* Replace row content with a lone continuation byte. */
-	buf->row[0].chars[0] = 0x80;
+	bufRow(buf, 0)->chars[0] = 0x80;
 	buf->cx = 1;
 	buf->cy = 0;
 	backSpace(1);
 	TEST_ASSERT_EQUAL_INT(0, buf->cx);
-	TEST_ASSERT_EQUAL_INT(0, buf->row[0].size);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, 0)->size);
 }
 
 void test_del_char_at_end_of_last_line(void) {
@@ -556,7 +603,7 @@ void test_kill_line_on_virtual_eof_line(void) {
 	buf->dirty = 0;
 	clearUndosAndRedos(buf);
 	buf->cy = buf->numrows - 1;
-	buf->cx = buf->row[buf->cy].size;
+	buf->cx = bufRow(buf, buf->cy)->size;
 	killLine(1);
 	TEST_ASSERT_EQUAL_INT(filled, buf->numrows); /* no-op */
 	transposeChars(0);
@@ -756,6 +803,8 @@ int main(void) {
 	RUN_TEST(test_insert_char_with_count);
 	RUN_TEST(test_self_insert_readonly_records_no_undo);
 	RUN_TEST(test_insert_unicode_readonly_records_no_undo);
+	RUN_TEST(test_paste_inserts_in_one_undo);
+	RUN_TEST(test_paste_rejects_invalid_utf8);
 	RUN_TEST(test_self_insert_readonly_does_not_move_mark);
 
 	RUN_TEST(test_insert_newline_splits);
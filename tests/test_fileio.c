@@ -4,11 +4,16 @@
 #include "test.h"
 #include "test_harness.h"
 #include "fileio.h"
+#include "keymap.h"
 #include "util.h"
 #include "buffer.h"
+#include "mutate.h"
+#include "undo.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -140,6 +145,38 @@ void test_rows_to_string(void) {
 	free(str);
 }
 
+/* writeRows() is what save and diff write with, so it must produce
+ * rowsToString()'s bytes exactly.  Enough rows, some empty, to span
+ * several writev() batches. */
+void test_write_rows_matches_rows_to_string(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	for (int i = 0; i < 3000; i++) {
+		char s[32];
+		int len = (i % 7 == 0) ? 0 : snprintf(s, sizeof(s), "row %d", i);
+		insertRow(buf, i, (const uint8_t *)s, len);
+	}
+
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	int fd = mkstemp(tmpname);
+	TEST_ASSERT(fd >= 0);
+	TEST_ASSERT_EQUAL_INT(0, writeRows(fd, buf));
+	close(fd);
+
+	size_t want_len;
+	char *want = rowsToString(buf, &want_len);
+	FILE *fp = fopen(tmpname, "r");
+	TEST_ASSERT_NOT_NULL(fp);
+	char *got = malloc(want_len + 1);
+	size_t got_len = fread(got, 1, want_len + 1, fp);
+	fclose(fp);
+	TEST_ASSERT_EQUAL_UINT(want_len, got_len);
+	TEST_ASSERT(memcmp(want, got, want_len) == 0);
+
+	free(want);
+	free(got);
+	unlink(tmpname);
+}
+
 void test_open_temp_file(void) {
 	char tmpname[] = "/tmp/emil_test_XXXXXX";
 	int fd = mkstemp(tmpname);
@@ -151,9 +188,9 @@ void test_open_temp_file(void) {
 	int rc = editorOpen(buf, tmpname);
 	TEST_ASSERT_EQUAL_INT(0, rc);
 	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("Line one", (char *)buf->row[0].chars);
-	TEST_ASSERT_EQUAL_STRING("Line two", (char *)buf->row[1].chars);
-	TEST_ASSERT_EQUAL_STRING("Line three", (char *)buf->row[2].chars);
+	TEST_ASSERT_EQUAL_STRING("Line one", (char *)bufRow(buf, 0)->chars);
+	TEST_ASSERT_EQUAL_STRING("Line two", (char *)bufRow(buf, 1)->chars);
+	TEST_ASSERT_EQUAL_STRING("Line three", (char *)bufRow(buf, 2)->chars);
 
 	unlink(tmpname);
 }
@@ -198,6 +235,215 @@ void test_open_trailing_slash_fails(void) {
 	TEST_ASSERT_EQUAL_INT(1, buf->numrows);
 }
 
+/* Several files at once come back each in its own buffer, as
+ * editorOpen() would have left it. */
+#define OPEN_FILES_N 6
+
+void test_open_files_loads_each(void) {
+	char names[OPEN_FILES_N][32];
+	char *paths[OPEN_FILES_N];
+	struct buffer *bufs[OPEN_FILES_N];
+	for (int i = 0; i < OPEN_FILES_N; i++) {
+		emil_strlcpy(names[i], "/tmp/emil_test_XXXXXX", sizeof(names[i]));
+		int fd = mkstemp(names[i]);
+		TEST_ASSERT(fd >= 0);
+		FILE *fp = fdopen(fd, "w");
+		for (int j = 0; j <= i; j++)
+			fprintf(fp, "file %d line %d\n", i, j);
+		fclose(fp);
+		paths[i] = names[i];
+		bufs[i] = newBuffer();
+	}
+
+	TEST_ASSERT_EQUAL_INT(OPEN_FILES_N,
+			      editorOpenFiles(bufs, paths, OPEN_FILES_N, 0));
+	for (int i = 0; i < OPEN_FILES_N; i++) {
+		TEST_ASSERT_EQUAL_STRING(names[i], bufs[i]->filename);
+		TEST_ASSERT_EQUAL_INT(i + 2, bufs[i]->numrows);
+		char want[sizeof("file -2147483648 line -2147483648")];
+		snprintf(want, sizeof(want), "file %d line %d", i, i);
+		TEST_ASSERT_EQUAL_STRING(want, row_str(bufs[i], i));
+		TEST_ASSERT_EQUAL_INT(0, bufs[i]->dirty);
+		destroyBuffer(bufs[i]);
+		unlink(names[i]);
+	}
+}
+
+/* A file that cannot be opened stops the run there, with its message
+ * left for the caller to report. */
+void test_open_files_stops_at_failure(void) {
+	char file[] = "/tmp/emil_test_XXXXXX";
+	int fd = mkstemp(file);
+	TEST_ASSERT(fd >= 0);
+	TEST_ASSERT(write(fd, "text\n", 5) == 5);
+	close(fd);
+	char dir[] = "/tmp/emil_test_dir_XXXXXX";
+	TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+
+	char *paths[] = { file, dir, file };
+	struct buffer *bufs[3];
+	for (int i = 0; i < 3; i++)
+		bufs[i] = newBuffer();
+
+	TEST_ASSERT_EQUAL_INT(1, editorOpenFiles(bufs, paths, 3, 0));
+	TEST_ASSERT_EQUAL_STRING("text", row_str(bufs[0], 0));
+	TEST_ASSERT_NULL(bufs[1]->filename);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "directory"));
+
+	for (int i = 0; i < 3; i++)
+		destroyBuffer(bufs[i]);
+	rmdir(dir);
+	unlink(file);
+}
+
+/* Write text to a new temporary file named into path[32]. */
+static void writeTemp(char *path, const char *text) {
+	emil_strlcpy(path, "/tmp/emil_test_XXXXXX", 32);
+	int fd = mkstemp(path);
+	TEST_ASSERT(fd >= 0);
+	TEST_ASSERT(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+	close(fd);
+}
+
+/* Opened with defer, only the last file is read; the others are read
+ * when asked for, and come out as editorOpen() would have left them. */
+void test_open_files_defers_all_but_last(void) {
+	char names[3][32];
+	char *paths[3];
+	struct buffer *bufs[3];
+	writeTemp(names[0], "first\n");
+	writeTemp(names[1], "second\n");
+	writeTemp(names[2], "third\n");
+	for (int i = 0; i < 3; i++) {
+		paths[i] = names[i];
+		bufs[i] = newBuffer();
+	}
+
+	TEST_ASSERT_EQUAL_INT(3, editorOpenFiles(bufs, paths, 3, 1));
+	TEST_ASSERT_TRUE(bufs[0]->deferred);
+	TEST_ASSERT_TRUE(bufs[1]->deferred);
+	TEST_ASSERT_EQUAL_INT(1, bufs[0]->numrows);
+	TEST_ASSERT_EQUAL_STRING(names[0], bufs[0]->filename);
+	TEST_ASSERT_FALSE(bufs[2]->deferred);
+	TEST_ASSERT_EQUAL_STRING("third", row_str(bufs[2], 0));
+
+	bufs[0]->cy = 5; /* +LINE past the end */
+	loadDeferred(bufs[0]);
+	TEST_ASSERT_FALSE(bufs[0]->deferred);
+	TEST_ASSERT_EQUAL_INT(2, bufs[0]->numrows);
+	TEST_ASSERT_EQUAL_STRING("first", row_str(bufs[0], 0));
+	TEST_ASSERT_EQUAL_INT(1, bufs[0]->cy);
+	TEST_ASSERT_EQUAL_INT(0, bufs[0]->dirty);
+	TEST_ASSERT_TRUE(bufs[0]->open_mtime != 0);
+
+	for (int i = 0; i < 3; i++) {
+		destroyBuffer(bufs[i]);
+		unlink(names[i]);
+	}
+}
+
+/* Switching to a deferred buffer reads it, taking the prefetch when
+ * there is one; a file changed after its prefetch is read again. */
+void test_deferred_buffer_reads_on_switch(void) {
+	char a[32], b[32], c[32];
+	writeTemp(a, "alpha\n");
+	writeTemp(b, "beta\n");
+	writeTemp(c, "gamma\n");
+	struct buffer *shown = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(shown, c));
+	struct buffer *ba = newBuffer();
+	struct buffer *bb = newBuffer();
+	TEST_ASSERT_EQUAL_INT(0, editorOpenDeferred(ba, a));
+	TEST_ASSERT_EQUAL_INT(0, editorOpenDeferred(bb, b));
+	shown->next = ba;
+	ba->next = bb;
+
+	prefetchDeferred(shown);
+	previousBuffer();
+	TEST_ASSERT_TRUE(E.buf == ba);
+	TEST_ASSERT_FALSE(ba->deferred);
+	TEST_ASSERT_EQUAL_STRING("alpha", row_str(ba, 0));
+
+	/* bb's prefetch is now under way, or done. */
+	FILE *fp = fopen(b, "w");
+	fputs("beta, longer\n", fp);
+	fclose(fp);
+	previousBuffer();
+	TEST_ASSERT_TRUE(E.buf == bb);
+	TEST_ASSERT_EQUAL_STRING("beta, longer", row_str(bb, 0));
+
+	unlink(a);
+	unlink(b);
+	unlink(c);
+}
+
+/* A file deleted after its prefetch is a new file, not the text the
+ * prefetch read. */
+void test_deferred_prefetch_of_deleted_file_is_dropped(void) {
+	char a[32], c[32];
+	writeTemp(a, "alpha\n");
+	writeTemp(c, "gamma\n");
+	struct buffer *shown = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(shown, c));
+	struct buffer *ba = newBuffer();
+	TEST_ASSERT_EQUAL_INT(0, editorOpenDeferred(ba, a));
+	shown->next = ba;
+
+	/* The prefetch reads into ba's rows; wait until it has. */
+	prefetchDeferred(shown);
+	for (int i = 0; i < 200 && ba->numrows < 2; i++)
+		usleep(10000);
+	unlink(a);
+	loadDeferred(ba);
+	TEST_ASSERT_FALSE(ba->deferred);
+	TEST_ASSERT_TRUE(bufferIsEmpty(ba));
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "(New file)"));
+
+	unlink(c);
+}
+
+/* A deferred file found to be binary only when shown takes its buffer
+ * with it, and the message names the file. */
+void test_deferred_binary_file_drops_its_buffer(void) {
+	char a[32], c[32];
+	writeTemp(a, "bin\n");
+	writeTemp(c, "gamma\n");
+	FILE *fp = fopen(a, "w");
+	fputs("bin", fp);
+	fputc('\0', fp);
+	fclose(fp);
+	struct buffer *shown = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(shown, c));
+	struct buffer *ba = newBuffer();
+	TEST_ASSERT_EQUAL_INT(0, editorOpenDeferred(ba, a));
+	shown->next = ba;
+
+	previousBuffer();
+	TEST_ASSERT_TRUE(E.buf == shown);
+	TEST_ASSERT_TRUE(E.headbuf == shown);
+	TEST_ASSERT_NULL(shown->next);
+	TEST_ASSERT_TRUE(E.windows[0]->buf == shown);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, a));
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "null bytes"));
+
+	unlink(a);
+	unlink(c);
+}
+
+/* A file that cannot be deferred is opened at once, so its failure is
+ * still reported where it was named. */
+void test_open_deferred_directory_fails_at_once(void) {
+	char dir[] = "/tmp/emil_test_dir_XXXXXX";
+	TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+	struct buffer *buf = make_test_buffer(NULL);
+
+	TEST_ASSERT_EQUAL_INT(-1, editorOpenDeferred(buf, dir));
+	TEST_ASSERT_FALSE(buf->deferred);
+	TEST_ASSERT_NULL(buf->filename);
+
+	rmdir(dir);
+}
+
 /* ---- UTF-8 validation ---- */
 
 void test_utf8_valid_file(void) {
@@ -273,6 +519,65 @@ void test_utf8_truncated_multibyte(void) {
 	unlink(tmpname);
 }
 
+/* Validation happens during the one pass that builds the rows, which
+ * stops at the first bad line.  A NUL later in the file must still be
+ * what the user is told about, as when NUL had a pre-scan of its own,
+ * and the half-built rows must not survive. */
+void test_null_byte_after_bad_utf8_reported_as_binary(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	int fd = mkstemp(tmpname);
+	TEST_ASSERT(fd >= 0);
+	const char data[] = "ok\n"
+			    "bad \xC2\x41\n"
+			    "nul \x00\n";
+	TEST_ASSERT(write(fd, data, sizeof(data) - 1) ==
+		    (ssize_t)(sizeof(data) - 1));
+	close(fd);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(-1, editorOpen(buf, tmpname));
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "null bytes"));
+	TEST_ASSERT_EQUAL_INT(1, buf->numrows);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, 0)->size);
+
+	unlink(tmpname);
+}
+
+/* The file is read a chunk at a time, so lines straddle reads and
+ * one line is longer than a whole chunk.  Each must come out whole. */
+void test_load_lines_across_read_chunks(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	int fd = mkstemp(tmpname);
+	TEST_ASSERT(fd >= 0);
+	FILE *fp = fdopen(fd, "w");
+	TEST_ASSERT_NOT_NULL(fp);
+	for (int i = 0; i < 100000; i++)
+		fprintf(fp, "line %d\n", i);
+	for (int i = 0; i < 3 * 1024 * 1024; i++)
+		fputc('a' + i % 26, fp);
+	fputs("\nlast", fp);
+	fclose(fp);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, tmpname));
+	TEST_ASSERT_EQUAL_INT(100003, buf->numrows);
+	char want[32];
+	for (int i = 0; i < 100000; i += 997) {
+		snprintf(want, sizeof(want), "line %d", i);
+		TEST_ASSERT_EQUAL_INT((int)strlen(want), bufRow(buf, i)->size);
+		TEST_ASSERT(memcmp(bufRow(buf, i)->chars, want, strlen(want)) ==
+			    0);
+	}
+	erow *lng = bufRow(buf, 100000);
+	TEST_ASSERT_EQUAL_INT(3 * 1024 * 1024, lng->size);
+	TEST_ASSERT_EQUAL_INT('a' + (3 * 1024 * 1024 - 1) % 26,
+			      lng->chars[lng->size - 1]);
+	TEST_ASSERT_EQUAL_INT(4, bufRow(buf, 100001)->size);
+	TEST_ASSERT(memcmp(bufRow(buf, 100001)->chars, "last", 4) == 0);
+
+	unlink(tmpname);
+}
+
 /* ---- save() UTF-8 guard ----
  *
  * Every load path refuses files that fail UTF-8 validation, so
@@ -307,6 +612,174 @@ void test_save_valid_utf8_succeeds(void) {
 	unlink(tmpname);
 }
 
+/* Saving over an existing file copies it to name~ first -- in the
+ * kernel where it can -- and removes the copy once the write is safe.
+ * The original is large enough to need several copy calls. */
+void test_save_over_existing_file_removes_backup(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	int fd = mkstemp(tmpname);
+	TEST_ASSERT(fd >= 0);
+	char block[4096];
+	memset(block, 'x', sizeof(block));
+	for (int i = 0; i < 1024; i++)
+		TEST_ASSERT(write(fd, block, sizeof(block)) == sizeof(block));
+	close(fd);
+
+	struct buffer *buf = make_test_buffer("replaced");
+	buf->filename = xstrdup(tmpname);
+	buf->dirty = 1;
+
+	save(0);
+
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+	struct stat st;
+	TEST_ASSERT_EQUAL_INT(0, stat(tmpname, &st));
+	TEST_ASSERT_EQUAL_INT(9, (int)st.st_size);
+	char backup[64];
+	snprintf(backup, sizeof(backup), "%s~", tmpname);
+	TEST_ASSERT_EQUAL_INT(-1, stat(backup, &st));
+	unlink(tmpname);
+}
+
+static char *readWholeFile(const char *path) {
+	FILE *fp = fopen(path, "r");
+	if (!fp)
+		return NULL;
+	char *s = xmalloc(4096);
+	size_t n = fread(s, 1, 4095, fp);
+	s[n] = '\0';
+	fclose(fp);
+	return s;
+}
+
+/* The child writes the snapshot taken at the fork; with no edit since,
+ * the buffer comes back clean exactly as a foreground save leaves it. */
+void test_background_save_writes_and_cleans(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	close(mkstemp(tmpname));
+
+	const char *lines[] = { "alpha", "beta" };
+	struct buffer *buf = make_test_buffer_lines(lines, 2);
+	buf->filename = xstrdup(tmpname);
+	rowInsertChar(buf, bufRow(buf, 0), 0, '>');
+
+	saveInBackground();
+	TEST_ASSERT(backgroundSaveRunning());
+	finishBackgroundSave();
+
+	TEST_ASSERT(!backgroundSaveRunning());
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING(">alpha\nbeta\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* The result pipe is what the main loop waits on: once it is readable
+ * the save is reaped, with no SIGCHLD needed to notice. */
+void test_background_save_reaped_when_pipe_readable(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	close(mkstemp(tmpname));
+
+	struct buffer *buf = make_test_buffer("alpha");
+	buf->filename = xstrdup(tmpname);
+	rowInsertChar(buf, bufRow(buf, 0), 5, '!');
+
+	saveInBackground();
+	int fd = backgroundSaveFd();
+	TEST_ASSERT(fd >= 0);
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	TEST_ASSERT_EQUAL_INT(1, select(fd + 1, &fds, NULL, NULL, NULL));
+	pollBackgroundSave();
+
+	TEST_ASSERT(!backgroundSaveRunning());
+	TEST_ASSERT_EQUAL_INT(-1, backgroundSaveFd());
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
+	unlink(tmpname);
+}
+
+/* A save of some size reports how far it has got before its result,
+ * and the result still comes through after the reports. */
+void test_background_save_reports_progress(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	close(mkstemp(tmpname));
+
+	static char line[8192];
+	memset(line, 'x', sizeof(line));
+	struct buffer *buf = make_test_buffer(NULL);
+	for (int i = 0; i < 3000; i++)
+		insertRow(buf, i, (const uint8_t *)line, sizeof(line));
+	buf->filename = xstrdup(tmpname);
+	rowInsertChar(buf, bufRow(buf, 0), 0, '!');
+
+	saveInBackground();
+	int fd = backgroundSaveFd();
+	TEST_ASSERT(fd >= 0);
+	long long at = -1;
+	TEST_ASSERT_EQUAL_INT((int)sizeof(at), (int)read(fd, &at, sizeof(at)));
+	TEST_ASSERT(at > 0);
+	TEST_ASSERT(at < 3000LL * (long long)sizeof(line));
+	finishBackgroundSave();
+
+	TEST_ASSERT(!backgroundSaveRunning());
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
+	unlink(tmpname);
+}
+
+/* An edit made while the child writes is not in the file, so the
+ * buffer must stay dirty when the save completes. */
+void test_background_save_keeps_later_edits_dirty(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	close(mkstemp(tmpname));
+
+	struct buffer *buf = make_test_buffer("alpha");
+	buf->filename = xstrdup(tmpname);
+	rowInsertChar(buf, bufRow(buf, 0), 5, '!');
+
+	saveInBackground();
+	rowInsertChar(buf, bufRow(buf, 0), 0, '#');
+	finishBackgroundSave();
+
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "edited since"));
+	TEST_ASSERT(buf->dirty != 0);
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("alpha!\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* C-x C-s while the child is still writing waits for it, so the older
+ * snapshot cannot land over the newer save and leave a clean buffer
+ * above a stale file. */
+void test_foreground_save_during_background_save(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	close(mkstemp(tmpname));
+
+	struct buffer *buf = make_test_buffer("alpha");
+	buf->filename = xstrdup(tmpname);
+	rowInsertChar(buf, bufRow(buf, 0), 5, '!');
+
+	saveInBackground();
+	TEST_ASSERT(backgroundSaveRunning());
+	rowInsertChar(buf, bufRow(buf, 0), 0, '#');
+	save(0);
+
+	TEST_ASSERT(!backgroundSaveRunning());
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+	TEST_ASSERT_NULL(strstr(E.statusmsg, "edited since"));
+	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
+	TEST_ASSERT_EQUAL_INT(0, buf->external_mod);
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("#alpha!\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
 void test_save_invalid_utf8_refused(void) {
 	char tmpname[] = "/tmp/emil_test_XXXXXX";
 	int fd = mkstemp(tmpname);
@@ -319,7 +792,7 @@ void test_save_invalid_utf8_refused(void) {
 	buf->filename = xstrdup(tmpname);
 	buf->dirty = 1;
 	/* Corrupt the row in place: 0xC2 with no continuation byte */
-	buf->row[0].chars[1] = 0xC2;
+	bufRow(buf, 0)->chars[1] = 0xC2;
 
 	save(0);
 
@@ -385,7 +858,7 @@ void test_load_keeps_existing_final_newline(void) {
 	struct buffer *buf = openBytes("a\nb\n", 4, tmpname);
 
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("", (char *)buf->row[2].chars);
+	TEST_ASSERT_EQUAL_STRING("", (char *)bufRow(buf, 2)->chars);
 	assertSerialises(buf, "a\nb\n");
 
 	unlink(tmpname);
@@ -397,8 +870,8 @@ void test_load_adds_missing_final_newline(void) {
 	struct buffer *buf = openBytes("a\nb", 3, tmpname);
 
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("b", (char *)buf->row[1].chars);
-	TEST_ASSERT_EQUAL_STRING("", (char *)buf->row[2].chars);
+	TEST_ASSERT_EQUAL_STRING("b", (char *)bufRow(buf, 1)->chars);
+	TEST_ASSERT_EQUAL_STRING("", (char *)bufRow(buf, 2)->chars);
 	assertSerialises(buf, "a\nb\n");
 
 	unlink(tmpname);
@@ -431,13 +904,40 @@ void test_load_empty_file_serialises_to_nothing(void) {
 	unlink(tmpname);
 }
 
+/* The load scan measures each row as it splits it and seeds
+ * cached_width; every seeded width must be what the walk would have
+ * computed, or the cache serves a wrong answer until the row is
+ * edited.  The CRLF row checks that a stripped CR's ^M columns are
+ * taken back out. */
+void test_load_seeds_cached_width(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	const char data[] = "plain ascii line that is longer than sixteen\n"
+			    "\ttab\tstops\n"
+			    "ctl \x01\x7f end\r\n"
+			    "\xe6\xbc\xa2\xe5\xad\x97 and caf\xc3\xa9\n"
+			    "lone\rcr";
+	struct buffer *buf = openBytes(data, sizeof(data) - 1, tmpname);
+
+	/* Five scanned rows; the sixth is the appended final newline. */
+	TEST_ASSERT_EQUAL_INT(6, buf->numrows);
+	for (int i = 0; i < 5; i++) {
+		erow *row = bufRow(buf, i);
+		int seeded = row->cached_width;
+		row->cached_width = -1;
+		TEST_ASSERT_EQUAL_INT(calculateLineWidth(row), seeded);
+	}
+
+	unlink(tmpname);
+}
+
 /* --- Load-time normalisation is reported, not silent ---------------
  *
  * Emil edits UTF-8 text files, and a text file is a sequence of lines
- * each terminated by '\n'.  Input departing from that -- a missing
- * final terminator, or DOS line endings -- is normalised on the way
- * in.  The buffer stays clean, so an unedited file is never rewritten;
- * the status line says what will happen if the user does save. */
+ * each terminated by '\n', or by "\r\n" throughout.  Input departing
+ * from that -- a missing final terminator, or mixed line endings -- is
+ * normalised on the way in.  The buffer stays clean, so an unedited
+ * file is never rewritten; the status line says what will happen if
+ * the user does save. */
 
 static int openTempWith(struct buffer *buf, const char *content) {
 	char tmpname[] = "/tmp/emil_norm_XXXXXX";
@@ -461,7 +961,7 @@ void test_open_reports_missing_final_newline(void) {
 	/* Normalised in the buffer, but not yet on disk: an untouched
 	 * file must not be rewritten, so the buffer stays clean. */
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_INT(0, buf->row[buf->numrows - 1].size);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, buf->numrows - 1)->size);
 	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
 }
 
@@ -472,8 +972,8 @@ void test_open_reports_dos_line_endings(void) {
 	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "DOS line endings"));
 	TEST_ASSERT_NULL(strstr(E.statusmsg, "no final newline"));
 
-	TEST_ASSERT_EQUAL_STRING("alpha", (char *)buf->row[0].chars);
-	TEST_ASSERT_EQUAL_STRING("beta", (char *)buf->row[1].chars);
+	TEST_ASSERT_EQUAL_STRING("alpha", (char *)bufRow(buf, 0)->chars);
+	TEST_ASSERT_EQUAL_STRING("beta", (char *)bufRow(buf, 1)->chars);
 	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
 }
 
@@ -488,6 +988,226 @@ void test_open_reports_both_normalisations(void) {
 	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
 }
 
+/* A DOS file keeps its line endings through an edit and a save, so
+ * the save changes only the line that was edited. */
+void test_save_keeps_dos_line_endings(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("alpha\r\nbeta\r\n", 13, tmpname);
+	TEST_ASSERT_TRUE(buf->crlf);
+	TEST_ASSERT_EQUAL_STRING("alpha", (char *)bufRow(buf, 0)->chars);
+
+	rowInsertChar(buf, bufRow(buf, 0), 0, '>');
+	save(0);
+
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote 14 bytes"));
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING(">alpha\r\nbeta\r\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* Only the CR ending a line is a line ending; one before it is text,
+ * and comes back. */
+void test_dos_file_round_trips_inner_cr(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("a\r\r\nb\r\n", 7, tmpname);
+	TEST_ASSERT_EQUAL_STRING("a\r", (char *)bufRow(buf, 0)->chars);
+
+	buf->dirty = 1;
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("a\r\r\nb\r\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* st's mtime to the nanosecond, where the struct has it, as
+ * mtimeNsec() in fileio.c reads it. */
+static struct timespec mtimeOf(const struct stat *st) {
+#if defined(__APPLE__)
+	return st->st_mtimespec;
+#else
+	return st->st_mtim;
+#endif
+}
+
+/* Set path's mtime to 'mtime', leaving its atime alone. */
+static void setMtime(const char *path, struct timespec mtime) {
+	struct timespec ts[2] = { { 0, UTIME_OMIT }, mtime };
+	TEST_ASSERT_EQUAL_INT(0, utimensat(AT_FDCWD, path, ts, 0));
+}
+
+/* Overwrite one byte of the file behind the editor's back, keeping its
+ * size and mtime, so only a save that rewrites that byte can undo it. */
+static void scribble(const char *path, off_t off, char c) {
+	struct stat st;
+	TEST_ASSERT_EQUAL_INT(0, stat(path, &st));
+	int fd = open(path, O_WRONLY);
+	TEST_ASSERT_EQUAL_INT(1, (int)pwrite(fd, &c, 1, off));
+	close(fd);
+	setMtime(path, mtimeOf(&st));
+}
+
+/* An edit to the last line writes from that line on: the scribbled
+ * first line survives the save.  The scribble stays clear of the row
+ * just before the edit, which the save reads back to check. */
+void test_save_writes_only_changed_tail(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("aaa\nbbb\nccc\nddd\n", 16, tmpname);
+	scribble(tmpname, 0, 'A');
+
+	rowInsertChar(buf, bufRow(buf, 3), 3, '!');
+	save(0);
+
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote 17 bytes"));
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("Aaa\nbbb\nccc\nddd!\n", disk);
+	free(disk);
+
+	/* Saved, the rows are the file again: a second edit further up
+	 * writes from there. */
+	scribble(tmpname, 16, '?');
+	rowInsertChar(buf, bufRow(buf, 2), 0, '>');
+	save(0);
+	disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("Aaa\nbbb\n>ccc\nddd!\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* Deleting lines leaves the file cut to its new length. */
+void test_save_tail_truncates_file(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("aaa\nbbb\nccc\nddd\n", 16, tmpname);
+	scribble(tmpname, 0, 'A');
+
+	delRow(buf, 2);
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("Aaa\nbbb\nddd\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* A DOS file's offsets count its CRs. */
+void test_save_tail_of_dos_file(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("a\r\nb\r\nc\r\n", 9, tmpname);
+	scribble(tmpname, 0, 'A');
+
+	rowInsertChar(buf, bufRow(buf, 2), 1, '!');
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("A\r\nb\r\nc!\r\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* A same-size rewrite that kept the mtime still changed the row before
+ * the edit, which the save reads back: the file is written whole
+ * rather than left half theirs, half ours. */
+void test_save_rewrites_whole_when_kept_row_differs(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("aaa\nbbb\nccc\n", 12, tmpname);
+	scribble(tmpname, 4, 'B');
+
+	rowInsertChar(buf, bufRow(buf, 2), 3, '!');
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("aaa\nbbb\nccc!\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* So is one in the same second, which only the nanoseconds show. */
+void test_save_rewrites_whole_when_mtime_nsec_differs(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("aaa\nbbb\nccc\n", 12, tmpname);
+	scribble(tmpname, 0, 'A');
+	struct stat st;
+	TEST_ASSERT_EQUAL_INT(0, stat(tmpname, &st));
+	struct timespec mtime = mtimeOf(&st);
+	mtime.tv_nsec = (mtime.tv_nsec + 1) % 1000000000L;
+	setMtime(tmpname, mtime);
+	TEST_ASSERT_EQUAL_INT(0, stat(tmpname, &st));
+	if (mtimeOf(&st).tv_nsec != mtime.tv_nsec) {
+		unlink(tmpname); /* the filesystem keeps whole seconds */
+		return;
+	}
+
+	rowInsertChar(buf, bufRow(buf, 2), 3, '!');
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("aaa\nbbb\nccc!\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* What the load normalised is not the file's.  A last line that
+ * lacked its newline is rewritten to gain one... */
+void test_save_rewrites_unterminated_last_line(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("aaa\nbbb\nccc", 11, tmpname);
+	scribble(tmpname, 0, 'A');
+
+	rowInsertChar(buf, bufRow(buf, 3), 0, 'd');
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("Aaa\nbbb\nccc\nd", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* ...and a file with mixed line endings is written whole. */
+void test_save_rewrites_mixed_file_whole(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("a\r\nb\r\nc\n", 8, tmpname);
+	scribble(tmpname, 0, 'A');
+
+	rowInsertChar(buf, bufRow(buf, 2), 1, '!');
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("a\r\nb\r\nc!\r\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
+/* A file mixing the two takes the more common, and says so. */
+void test_open_mixed_line_endings_take_the_majority(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, openTempWith(buf, "a\r\nb\r\nc\n"));
+	TEST_ASSERT_TRUE(buf->crlf);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "mixed line endings, all DOS"));
+
+	TEST_ASSERT_EQUAL_INT(0, openTempWith(buf, "a\r\nb\nc\n"));
+	TEST_ASSERT_FALSE(buf->crlf);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "mixed line endings, all Unix"));
+}
+
+/* toggle-line-endings is how a DOS file is converted now that saving
+ * no longer does it. */
+void test_toggle_line_endings_converts_on_save(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("a\r\nb\r\n", 6, tmpname);
+
+	toggleLineEndings();
+	TEST_ASSERT_FALSE(buf->crlf);
+	TEST_ASSERT_EQUAL_INT(1, buf->dirty);
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("a\nb\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
 void test_open_well_formed_file_reports_nothing_extra(void) {
 	struct buffer *buf = make_test_buffer(NULL);
 	TEST_ASSERT_EQUAL_INT(0, openTempWith(buf, "alpha\nbeta\n"));
@@ -515,8 +1235,8 @@ void test_stdin_without_final_newline_keeps_invariant(void) {
 	struct buffer *buf = loadStdinBuffer("alpha\nbeta", 10);
 	TEST_ASSERT_NOT_NULL(buf);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("beta", (char *)buf->row[1].chars);
-	TEST_ASSERT_EQUAL_INT(0, buf->row[buf->numrows - 1].size);
+	TEST_ASSERT_EQUAL_STRING("beta", (char *)bufRow(buf, 1)->chars);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, buf->numrows - 1)->size);
 	destroyBuffer(buf);
 }
 
@@ -524,8 +1244,128 @@ void test_stdin_with_final_newline_unchanged(void) {
 	struct buffer *buf = loadStdinBuffer("alpha\nbeta\n", 11);
 	TEST_ASSERT_NOT_NULL(buf);
 	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
-	TEST_ASSERT_EQUAL_INT(0, buf->row[buf->numrows - 1].size);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, buf->numrows - 1)->size);
+	destroyBuffer(buf);
+}
+
+/* Streamed stdin shows each line once it is complete, and the
+ * unfinished one when the pipe closes. */
+void test_stdin_stream_appends_lines_as_they_arrive(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
+
+	TEST_ASSERT_TRUE(write(fds[1], "one\ntw", 6) == 6);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(2, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("one", (char *)bufRow(buf, 0)->chars);
+	TEST_ASSERT_EQUAL_INT(fds[0], stdinStreamFd());
+
+	TEST_ASSERT_TRUE(write(fds[1], "o\nthree", 7) == 7);
+	close(fds[1]);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("two", (char *)bufRow(buf, 1)->chars);
+	TEST_ASSERT_EQUAL_STRING("three", (char *)bufRow(buf, 2)->chars);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, 3)->size);
+	TEST_ASSERT_EQUAL_INT(-1, stdinStreamFd());
+	TEST_ASSERT_TRUE(buf->read_only);
+	destroyBuffer(buf);
+}
+
+/* A UTF-8 sequence split across two reads is held back, not taken
+ * for invalid input. */
+void test_stdin_stream_keeps_split_utf8_whole(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
+
+	TEST_ASSERT_TRUE(write(fds[1], "caf\xc3", 4) == 4);
+	readStdinStream();
+	TEST_ASSERT_TRUE(write(fds[1], "\xa9\n", 2) == 2);
+	close(fds[1]);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(2, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("caf\xc3\xa9", (char *)bufRow(buf, 0)->chars);
+	destroyBuffer(buf);
+}
+
+/* Binary input stops the stream; the lines before it stay. */
+void test_stdin_stream_stops_at_binary_data(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
+
+	TEST_ASSERT_TRUE(write(fds[1], "text\nbin\0ary\nmore\n", 18) == 18);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(-1, stdinStreamFd());
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "UTF-8"));
+	TEST_ASSERT_EQUAL_STRING("text", (char *)bufRow(buf, 0)->chars);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, buf->numrows - 1)->size);
+	close(fds[1]);
+	destroyBuffer(buf);
+}
+
+/* The stream appends rows outside undo, so the buffer cannot be made
+ * writable while it is open.  A window left on the last row follows
+ * the input, focused or not. */
+void test_stdin_stream_stays_read_only_and_pins_windows(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
+	E.headbuf = buf;
+	E.buf = buf;
+	E.windows[0]->buf = buf;
+	E.windows = xrealloc(E.windows, 2 * sizeof(struct window *));
+	E.windows[1] = xcalloc(1, sizeof(struct window));
+	E.nwindows = 2;
+	E.windows[1]->buf = buf;
+
+	TEST_ASSERT_TRUE(write(fds[1], "one\n", 4) == 4);
+	readStdinStream();
+	processKeypress(CMD_TOGGLE_READ_ONLY);
+	TEST_ASSERT_TRUE(buf->read_only);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "stdin"));
+
+	E.windows[1]->cy = 1;
+	TEST_ASSERT_TRUE(write(fds[1], "two\n", 4) == 4);
+	close(fds[1]);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(2, E.windows[1]->cy);
+	processKeypress(CMD_TOGGLE_READ_ONLY);
+	TEST_ASSERT_FALSE(buf->read_only);
+}
+
+/* Closing the buffer mid-stream closes the pipe with it. */
+void test_stdin_stream_ends_with_its_buffer(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
 	destroyBuffer(buf);
+	TEST_ASSERT_EQUAL_INT(-1, stdinStreamFd());
+	close(fds[1]);
+}
+
+/* A pipe that closes empty leaves no *stdin* buffer behind: the
+ * window showing it moves to the next buffer. */
+void test_stdin_stream_drops_buffer_of_empty_pipe(void) {
+	struct buffer *other = make_test_buffer(NULL);
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	struct buffer *buf = openStdinStream(fds[0]);
+	buf->next = E.headbuf;
+	E.headbuf = buf;
+	E.buf = buf;
+	E.windows[0]->buf = buf;
+
+	close(fds[1]);
+	readStdinStream();
+	TEST_ASSERT_EQUAL_INT(-1, stdinStreamFd());
+	TEST_ASSERT_TRUE(E.headbuf == other);
+	TEST_ASSERT_NULL(other->next);
+	TEST_ASSERT_TRUE(E.buf == other);
+	TEST_ASSERT_TRUE(E.windows[0]->buf == other);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "no input"));
 }
 
 /* A CR-only file has no '\n', so it arrives as one row with the CRs
@@ -538,12 +1378,30 @@ void test_open_cr_only_file_is_not_reported_as_dos(void) {
 	TEST_ASSERT_NULL(strstr(E.statusmsg, "DOS"));
 	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "no final newline"));
 
-	/* One row of text, CR retained, plus the terminator row. */
+	/* One row of text, both CRs retained -- the last ends no line --
+	 * plus the terminator row. */
 	TEST_ASSERT_EQUAL_INT(2, buf->numrows);
-	TEST_ASSERT_EQUAL_STRING("alpha\rbeta", (char *)buf->row[0].chars);
+	TEST_ASSERT_EQUAL_STRING("alpha\rbeta\r", (char *)bufRow(buf, 0)->chars);
 	TEST_ASSERT_EQUAL_INT(0, buf->dirty);
 }
 
+/* An LF file whose last line ends in a CR but no newline keeps the CR
+ * through a save, which adds only the newline. */
+void test_final_cr_without_newline_survives_save(void) {
+	char tmpname[] = "/tmp/emil_test_XXXXXX";
+	struct buffer *buf = openBytes("a\nb\r", 4, tmpname);
+	TEST_ASSERT_FALSE(buf->crlf);
+	TEST_ASSERT_EQUAL_STRING("b\r", (char *)bufRow(buf, 1)->chars);
+
+	buf->dirty = 1;
+	save(0);
+
+	char *disk = readWholeFile(tmpname);
+	TEST_ASSERT_EQUAL_STRING("a\nb\r\n", disk);
+	free(disk);
+	unlink(tmpname);
+}
+
 
 /* Write a scratch file and return a malloc'd path. */
 static char *writeTempFile(const char *name, const char *contents) {
@@ -623,6 +1481,99 @@ void test_revert_existing_file_still_reloads(void) {
 	free(path);
 }
 
+/* The fine-grained revert edits only the lines that differ: the buffer
+ * survives, the cursor stays on its line, and the revert undoes as
+ * one step. */
+void test_fine_grain_revert_edits_in_place(void) {
+	char *path = writeTempFile("finegrain", "a\nb\nc\nd\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	buf->cy = 3;
+	buf->cx = 1;
+
+	FILE *fp = fopen(path, "w");
+	fputs("a\nB\nc\nd\nE\n", fp);
+	fclose(fp);
+	revertFineGrain();
+
+	TEST_ASSERT(E.buf == buf);
+	TEST_ASSERT_EQUAL_INT(6, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("B", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("E", row_str(buf, 4));
+	TEST_ASSERT_EQUAL_INT(3, buf->cy);
+	TEST_ASSERT_EQUAL_INT(1, buf->cx);
+	TEST_ASSERT_FALSE(buf->dirty);
+
+	doUndo(buf, 1);
+	TEST_ASSERT_EQUAL_INT(5, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("b", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 4));
+	TEST_ASSERT(buf->dirty);
+
+	unlink(path);
+	free(path);
+}
+
+/* The revert records the file as it read it, nanoseconds included,
+ * so a later save still writes only the changed tail. */
+void test_fine_grain_revert_keeps_tail_save(void) {
+	char *path = writeTempFile("finegrain", "a\nb\nc\nd\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+
+	FILE *fp = fopen(path, "w");
+	fputs("a\nB\nc\nd\n", fp);
+	fclose(fp);
+	revertFineGrain();
+	scribble(path, 0, 'A');
+
+	rowInsertChar(buf, bufRow(buf, 3), 1, '!');
+	save(0);
+	char *disk = readWholeFile(path);
+	TEST_ASSERT_EQUAL_STRING("A\nB\nc\nd!\n", disk);
+	free(disk);
+
+	unlink(path);
+	free(path);
+}
+
+/* Unsaved edits go, as with a full revert, and the buffer is clean. */
+void test_fine_grain_revert_discards_edits(void) {
+	char *path = writeTempFile("finegrain", "keep\nline\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	mutateInsert(buf, 0, 1, (const uint8_t *)"new\n", 4, NULL, NULL);
+	mutateDelete(buf, 0, 0, 0, 1, (const uint8_t *)"keep\n", 5);
+	TEST_ASSERT(buf->dirty);
+
+	revertFineGrain();
+
+	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("keep", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("line", row_str(buf, 1));
+	TEST_ASSERT_FALSE(buf->dirty);
+
+	unlink(path);
+	free(path);
+}
+
+/* Every line going, down to the empty file. */
+void test_fine_grain_revert_to_empty_file(void) {
+	char *path = writeTempFile("finegrain", "x\ny\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	TEST_ASSERT_EQUAL_INT(0, truncate(path, 0));
+
+	revertFineGrain();
+
+	TEST_ASSERT_EQUAL_INT(1, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_INT(0, buf->cy);
+
+	unlink(path);
+	free(path);
+}
+
 
 
 int main(void) {
@@ -636,19 +1587,36 @@ int main(void) {
 	RUN_TEST(test_getline_multiple_reallocs);
 
 	RUN_TEST(test_rows_to_string);
+	RUN_TEST(test_write_rows_matches_rows_to_string);
 	RUN_TEST(test_open_temp_file);
 	RUN_TEST(test_open_empty_file);
 	RUN_TEST(test_open_directory_fails);
 	RUN_TEST(test_open_trailing_slash_fails);
+	RUN_TEST(test_open_files_loads_each);
+	RUN_TEST(test_open_files_stops_at_failure);
+	RUN_TEST(test_open_files_defers_all_but_last);
+	RUN_TEST(test_deferred_buffer_reads_on_switch);
+	RUN_TEST(test_deferred_prefetch_of_deleted_file_is_dropped);
+	RUN_TEST(test_deferred_binary_file_drops_its_buffer);
+	RUN_TEST(test_open_deferred_directory_fails_at_once);
 
 	RUN_TEST(test_utf8_valid_file);
 	RUN_TEST(test_utf8_invalid_continuation);
 	RUN_TEST(test_utf8_overlong_rejected);
 	RUN_TEST(test_utf8_null_byte_rejected);
 	RUN_TEST(test_utf8_truncated_multibyte);
+	RUN_TEST(test_null_byte_after_bad_utf8_reported_as_binary);
+	RUN_TEST(test_load_lines_across_read_chunks);
+	RUN_TEST(test_load_seeds_cached_width);
 
 	RUN_TEST(test_save_valid_utf8_succeeds);
 	RUN_TEST(test_save_invalid_utf8_refused);
+	RUN_TEST(test_save_over_existing_file_removes_backup);
+	RUN_TEST(test_background_save_writes_and_cleans);
+	RUN_TEST(test_background_save_reaped_when_pipe_readable);
+	RUN_TEST(test_background_save_reports_progress);
+	RUN_TEST(test_background_save_keeps_later_edits_dirty);
+	RUN_TEST(test_foreground_save_during_background_save);
 
 	RUN_TEST(test_load_keeps_existing_final_newline);
 	RUN_TEST(test_load_adds_missing_final_newline);
@@ -658,16 +1626,38 @@ int main(void) {
 	RUN_TEST(test_open_reports_missing_final_newline);
 	RUN_TEST(test_open_reports_dos_line_endings);
 	RUN_TEST(test_open_reports_both_normalisations);
+	RUN_TEST(test_save_keeps_dos_line_endings);
+	RUN_TEST(test_dos_file_round_trips_inner_cr);
+	RUN_TEST(test_save_writes_only_changed_tail);
+	RUN_TEST(test_save_tail_truncates_file);
+	RUN_TEST(test_save_tail_of_dos_file);
+	RUN_TEST(test_save_rewrites_whole_when_kept_row_differs);
+	RUN_TEST(test_save_rewrites_whole_when_mtime_nsec_differs);
+	RUN_TEST(test_save_rewrites_unterminated_last_line);
+	RUN_TEST(test_save_rewrites_mixed_file_whole);
+	RUN_TEST(test_open_mixed_line_endings_take_the_majority);
+	RUN_TEST(test_toggle_line_endings_converts_on_save);
 	RUN_TEST(test_open_cr_only_file_is_not_reported_as_dos);
+	RUN_TEST(test_final_cr_without_newline_survives_save);
 	RUN_TEST(test_open_well_formed_file_reports_nothing_extra);
 	RUN_TEST(test_open_empty_file_reports_nothing_extra);
 	RUN_TEST(test_stdin_without_final_newline_keeps_invariant);
 	RUN_TEST(test_stdin_with_final_newline_unchanged);
+	RUN_TEST(test_stdin_stream_appends_lines_as_they_arrive);
+	RUN_TEST(test_stdin_stream_keeps_split_utf8_whole);
+	RUN_TEST(test_stdin_stream_stops_at_binary_data);
+	RUN_TEST(test_stdin_stream_stays_read_only_and_pins_windows);
+	RUN_TEST(test_stdin_stream_ends_with_its_buffer);
+	RUN_TEST(test_stdin_stream_drops_buffer_of_empty_pipe);
 
 
 	RUN_TEST(test_revert_null_filename_survives);
 	RUN_TEST(test_revert_missing_file_refuses);
 	RUN_TEST(test_revert_existing_file_still_reloads);
+	RUN_TEST(test_fine_grain_revert_edits_in_place);
+	RUN_TEST(test_fine_grain_revert_keeps_tail_save);
+	RUN_TEST(test_fine_grain_revert_discards_edits);
+	RUN_TEST(test_fine_grain_revert_to_empty_file);
 
 	return TEST_END();
 }
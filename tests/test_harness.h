@@ -66,6 +66,9 @@ static inline void cleanupTestEditor(void) {
 	E.macro.nkeys = 0;
 	E.macro.skeys = 0;
 
+	/* Free the last paste */
+	dbuf_free(&E.paste);
+
 	/* Free render buffer */
 	abFree(&E.render_buf);
 	E.render_buf = (struct abuf)ABUF_INIT;
@@ -169,7 +172,7 @@ static inline struct buffer *make_test_buffer_lines(const char **lines, int n) {
 static inline const char *row_str(struct buffer *buf, int row) {
 	if (row >= buf->numrows)
 		return "";
-	return (const char *)buf->row[row].chars;
+	return (const char *)bufRow(buf, row)->chars;
 }
 
 /* ---- Scripted keys, muted output, minibuffer ----
@@ -180,6 +183,8 @@ static inline const char *row_str(struct buffer *buf, int row) {
 extern int test_key_script[64];
 extern int test_key_count;
 extern int test_key_pos;
+/* What the stub inputPending() answers. */
+extern int test_input_pending;
 
 static inline void scriptKeys(const int *keys, int n) {
 	for (int i = 0; i < n; i++)
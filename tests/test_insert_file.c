@@ -194,7 +194,7 @@ void test_insert_file_does_not_join_a_typing_run(void) {
 	buf->cx = 0;
 	insertFileAtPath(buf, path, NULL);
 	buf->cy = 1;
-	buf->cx = buf->row[1].size;
+	buf->cx = bufRow(buf, 1)->size;
 	selfInsert(buf, 'Y', 1);
 
 	while (buf->undo)
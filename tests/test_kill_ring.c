@@ -55,7 +55,7 @@ void test_yank_returns_most_recent_kill(void) {
 	TEST_ASSERT_EQUAL_INT(1, E.kill_history.count);
 
 	/* Yank it back at end of line. */
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 	yank(0);
 	TEST_ASSERT_EQUAL_STRING("hello world", row_str(buf, 0));
@@ -76,7 +76,7 @@ void test_yank_pop_returns_previous_kill(void) {
 	TEST_ASSERT_EQUAL_INT(2, E.kill_history.count);
 
 	/* Yank at end: most recent kill = "def". */
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 	yank(0);
 	TEST_ASSERT_EQUAL_STRING("abc  def", row_str(buf, 0));
@@ -200,7 +200,7 @@ void test_reverse_yank_leaves_point_before_text(void) {
 	/* C-u C-y at end of line, driven through the real dispatch so
 	 * the uarg hand-off is exercised.  Any positive uarg means
 	 * reverse; bare C-u arrives as 4. */
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 	E.uarg = 4;
 	processKeypress(CMD_YANK);
@@ -227,7 +227,7 @@ void test_reverse_yank_pop_cycles_forward(void) {
 	TEST_ASSERT_EQUAL_STRING("abc  ", row_str(buf, 0));
 
 	/* Yank ("def"), M-y (→ "ghi"), then M-- M-y returns to "def". */
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 	yank(0);
 	TEST_ASSERT_EQUAL_STRING("abc  def", row_str(buf, 0));
@@ -246,7 +246,7 @@ void test_reverse_modifier_noop_combinations(void) {
 	TEST_ASSERT_EQUAL_STRING(" ", row_str(buf, 0));
 
 	/* M-- C-y: nothing happens. */
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 	yank(UARG_REVERSE);
 	TEST_ASSERT_EQUAL_STRING(" ", row_str(buf, 0));
@@ -266,7 +266,7 @@ void test_negative_arg_preserves_kill_ring_pos(void) {
 	kill_range(buf, 8, 0, 11, 0);
 	kill_range(buf, 4, 0, 7, 0);
 
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 
 	/* C-y, then M-- as a keypress, then M-y: the M-- keystroke must
@@ -301,7 +301,7 @@ void test_yank_pop_after_final_newline_repair(void) {
 
 	/* Yank at the very end of the buffer. */
 	buf->cy = buf->numrows - 1;
-	buf->cx = buf->row[buf->cy].size;
+	buf->cx = bufRow(buf, buf->cy)->size;
 	processKeypress(CMD_YANK);
 	TEST_ASSERT(E.kill_ring_pos >= 0);
 
@@ -330,7 +330,7 @@ void test_intervening_command_breaks_yank_chain(void) {
 
 	kill_range(buf, 0, 0, 3, 0);
 	kill_range(buf, 0, 0, 4, 0);
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 
 	processKeypress(CMD_YANK);
@@ -356,7 +356,7 @@ void test_yank_pop_refused_when_undo_cleared(void) {
 
 	kill_range(buf, 0, 0, 3, 0);
 	kill_range(buf, 0, 0, 4, 0);
-	buf->cx = buf->row[0].size;
+	buf->cx = bufRow(buf, 0)->size;
 	buf->cy = 0;
 
 	processKeypress(CMD_YANK);
@@ -0,0 +1,102 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* test_linediff.c: line-level diff hunks. */
+
+#include "test.h"
+#include "linediff.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct lines {
+	const char **a;
+	const char **b;
+};
+
+static int same(void *ctx, int a, int b) {
+	struct lines *l = ctx;
+	return strcmp(l->a[a], l->b[b]) == 0;
+}
+
+static int diff(const char **a, int n, const char **b, int m,
+		struct lineHunk **h) {
+	struct lines l = { a, b };
+	return diffLines(n, m, same, &l, h);
+}
+
+void test_equal_sequences_have_no_hunks(void) {
+	const char *a[] = { "x", "y", "" };
+	struct lineHunk *h;
+	TEST_ASSERT_EQUAL_INT(0, diff(a, 3, a, 3, &h));
+	TEST_ASSERT_NULL(h);
+}
+
+void test_changed_line_is_one_hunk(void) {
+	const char *a[] = { "a", "b", "c", "" };
+	const char *b[] = { "a", "B", "c", "" };
+	struct lineHunk *h;
+	TEST_ASSERT_EQUAL_INT(1, diff(a, 4, b, 4, &h));
+	TEST_ASSERT_EQUAL_INT(1, h[0].a);
+	TEST_ASSERT_EQUAL_INT(1, h[0].alen);
+	TEST_ASSERT_EQUAL_INT(1, h[0].b);
+	TEST_ASSERT_EQUAL_INT(1, h[0].blen);
+	free(h);
+}
+
+/* Separate changes stay separate, with the lines between untouched. */
+void test_insert_and_delete_apart(void) {
+	const char *a[] = { "1", "2", "3", "4", "5", "6", "" };
+	const char *b[] = { "1", "new", "2", "3", "4", "6", "" };
+	struct lineHunk *h;
+	TEST_ASSERT_EQUAL_INT(2, diff(a, 7, b, 7, &h));
+	TEST_ASSERT_EQUAL_INT(1, h[0].a);
+	TEST_ASSERT_EQUAL_INT(0, h[0].alen);
+	TEST_ASSERT_EQUAL_INT(1, h[0].b);
+	TEST_ASSERT_EQUAL_INT(1, h[0].blen);
+	TEST_ASSERT_EQUAL_INT(4, h[1].a);
+	TEST_ASSERT_EQUAL_INT(1, h[1].alen);
+	TEST_ASSERT_EQUAL_INT(5, h[1].b);
+	TEST_ASSERT_EQUAL_INT(0, h[1].blen);
+	free(h);
+}
+
+/* Applying the hunks to the old lines gives the new ones, however the
+ * lines are shuffled. */
+void test_hunks_rebuild_new_sequence(void) {
+	const char *a[] = { "a", "b", "c", "a", "b", "b", "a", "" };
+	const char *b[] = { "c", "b", "a", "b", "a", "c", "" };
+	struct lineHunk *h;
+	int nh = diff(a, 8, b, 7, &h);
+	TEST_ASSERT(nh > 0);
+
+	const char *out[16];
+	int n = 0, at = 0;
+	for (int i = 0; i < nh; i++) {
+		while (at < h[i].a)
+			out[n++] = a[at++];
+		for (int j = 0; j < h[i].blen; j++)
+			out[n++] = b[h[i].b + j];
+		at += h[i].alen;
+	}
+	while (at < 8)
+		out[n++] = a[at++];
+	TEST_ASSERT_EQUAL_INT(7, n);
+	for (int i = 0; i < 7; i++)
+		TEST_ASSERT_EQUAL_STRING(b[i], out[i]);
+	free(h);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(void) {
+	TEST_BEGIN();
+
+	RUN_TEST(test_equal_sequences_have_no_hunks);
+	RUN_TEST(test_changed_line_is_one_hunk);
+	RUN_TEST(test_insert_and_delete_apart);
+	RUN_TEST(test_hunks_rebuild_new_sequence);
+
+	return TEST_END();
+}
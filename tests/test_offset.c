@@ -20,6 +20,7 @@
 #include "test_harness.h"
 #include "buffer.h"
 #include "fileio.h"
+#include "mutate.h"
 #include "util.h"
 #include <stdint.h>
 #include <string.h>
@@ -88,7 +89,7 @@ void test_len_multibyte(void) {
  * failure this guards against is at a boundary, not in the middle. */
 static void assertRoundTripAll(struct buffer *buf) {
 	for (int y = 0; y < buf->numrows; y++) {
-		for (int x = 0; x <= buf->row[y].size; x++) {
+		for (int x = 0; x <= bufRow(buf, y)->size; x++) {
 			size_t off = bufOffset(buf, x, y);
 			int bx, by;
 			bufPos(buf, off, &bx, &by);
@@ -126,6 +127,42 @@ void test_roundtrip_multibyte(void) {
 	assertRoundTripAll(make_test_buffer_lines(lines, 3));
 }
 
+/* The index behind these is kept per row-array slot and updated
+ * incrementally, so the properties must survive edits that move the
+ * row gap a short way (per-row update), a long way (rebuild), grow
+ * the array, and resize rows in place. */
+void test_properties_survive_edits(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	for (int i = 0; i < 300; i++) {
+		char s[16];
+		int len = snprintf(s, sizeof(s), "row %d", i);
+		insertRow(buf, i, (const uint8_t *)s, len);
+	}
+	assertLenMatchesFlat(buf);
+
+	insertRows(buf, 250, (const uint8_t *)"x\nyy\n", 6);
+	assertLenMatchesFlat(buf);
+	assertRoundTripAll(buf);
+
+	insertRows(buf, 3, (const uint8_t *)"far\naway", 8);
+	rowInsertChar(buf, bufRow(buf, 2), 0, 'Q');
+	assertLenMatchesFlat(buf);
+	assertRoundTripAll(buf);
+
+	delRows(buf, 100, 150);
+	delRow(buf, 0);
+	assertLenMatchesFlat(buf);
+	assertRoundTripAll(buf);
+
+	mutateInsert(buf, 2, 40, (const uint8_t *)"a\nb\nc", 5, NULL, NULL);
+	int oldlen;
+	uint8_t *old = collectRegionText(buf, 1, 10, 3, 12, &oldlen);
+	mutateDelete(buf, 1, 10, 3, 12, old, oldlen);
+	free(old);
+	assertLenMatchesFlat(buf);
+	assertRoundTripAll(buf);
+}
+
 /* ---- Property 3: the offset space indexes the flattened text ---- */
 
 /* For every offset, the byte bufPos() names must be the byte
@@ -142,7 +179,7 @@ void test_offset_indexes_flat_text(void) {
 		int x, y;
 		bufPos(buf, off, &x, &y);
 		char expect = flat[off];
-		char got = (x < buf->row[y].size) ? (char)buf->row[y].chars[x]
+		char got = (x < bufRow(buf, y)->size) ? (char)bufRow(buf, y)->chars[x]
 						  : '\n';
 		if (got != expect) {
 			printf("    offset %zu: flat '%c' but (%d,%d) gives '%c'\n",
@@ -167,7 +204,7 @@ void test_offset_end_is_textlen(void) {
 	struct buffer *buf = make_test_buffer_lines(lines, 2);
 	int last = buf->numrows - 1;
 	TEST_ASSERT_EQUAL_UINT(bufTextLen(buf),
-				 bufOffset(buf, buf->row[last].size, last));
+				 bufOffset(buf, bufRow(buf, last)->size, last));
 }
 
 /* Row starts sit one past the previous row's end: the separator
@@ -195,7 +232,7 @@ void test_pos_clamps_past_end(void) {
 	int x, y;
 	bufPos(buf, bufTextLen(buf) + 100, &x, &y);
 	TEST_ASSERT_EQUAL_INT(buf->numrows - 1, y);
-	TEST_ASSERT_EQUAL_INT(buf->row[buf->numrows - 1].size, x);
+	TEST_ASSERT_EQUAL_INT(bufRow(buf, buf->numrows - 1)->size, x);
 }
 
 int main(void) {
@@ -216,6 +253,8 @@ int main(void) {
 	RUN_TEST(test_roundtrip_empty_buffer);
 	RUN_TEST(test_roundtrip_multibyte);
 
+	RUN_TEST(test_properties_survive_edits);
+
 	/* Property 3: indexes the flattened text */
 	RUN_TEST(test_offset_indexes_flat_text);
 
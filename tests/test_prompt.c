@@ -87,8 +87,8 @@ void test_zap_arrow_key_does_not_corrupt_utf8(void) {
 	buf->cx = 0;
 	buf->cy = 0;
 
-	TEST_ASSERT_EQUAL_INT(1, utf8_validate(buf->row[0].chars,
-					       buf->row[0].size));
+	TEST_ASSERT_EQUAL_INT(1, utf8_validate(bufRow(buf, 0)->chars,
+					       bufRow(buf, 0)->size));
 
 	int keys[] = { KEY_ARROW_LEFT };
 	scriptKeys(keys, 1);
@@ -97,8 +97,8 @@ void test_zap_arrow_key_does_not_corrupt_utf8(void) {
 	unmuteStdout();
 	clearKeys();
 
-	TEST_ASSERT_EQUAL_INT(1, utf8_validate(E.buf->row[0].chars,
-					       E.buf->row[0].size));
+	TEST_ASSERT_EQUAL_INT(1, utf8_validate(bufRow(E.buf, 0)->chars,
+					       bufRow(E.buf, 0)->size));
 	/* An arrow key is not a zap target, so nothing should be killed. */
 	TEST_ASSERT_EQUAL_STRING("ab\xE8\xAF\xAD"
 				 "cd",
@@ -124,8 +124,8 @@ void test_zap_meta_key_does_not_corrupt_utf8(void) {
 	unmuteStdout();
 	clearKeys();
 
-	TEST_ASSERT_EQUAL_INT(1, utf8_validate(E.buf->row[0].chars,
-					       E.buf->row[0].size));
+	TEST_ASSERT_EQUAL_INT(1, utf8_validate(bufRow(E.buf, 0)->chars,
+					       bufRow(E.buf, 0)->size));
 	TEST_ASSERT_EQUAL_STRING("ab\xD0\x96"
 				 "cd",
 				 row_str(E.buf, 0));
@@ -33,7 +33,7 @@ static char **snapshot_buffer(struct buffer *buf, int *nrows) {
 	*nrows = buf->numrows;
 	char **snap = calloc(buf->numrows, sizeof(char *));
 	for (int i = 0; i < buf->numrows; i++)
-		snap[i] = xstrdup((char *)buf->row[i].chars);
+		snap[i] = xstrdup((char *)bufRow(buf, i)->chars);
 	return snap;
 }
 
@@ -46,9 +46,9 @@ static void assert_buffer_matches(struct buffer *buf, char **snap, int nrows,
 		return;
 	}
 	for (int i = 0; i < nrows; i++) {
-		if (strcmp((char *)buf->row[i].chars, snap[i]) != 0) {
+		if (strcmp((char *)bufRow(buf, i)->chars, snap[i]) != 0) {
 			printf("  FAIL (%s): row %d: \"%s\" vs expected \"%s\"\n",
-			       label, i, (char *)buf->row[i].chars, snap[i]);
+			       label, i, (char *)bufRow(buf, i)->chars, snap[i]);
 			_current_test_failed = 1;
 		}
 	}
@@ -574,7 +574,7 @@ void test_replace_regex_readonly(void) {
 
 static void assert_all_rows_valid(struct buffer *buf, const char *label) {
 	for (int i = 0; i < buf->numrows; i++) {
-		if (!utf8_validate(buf->row[i].chars, buf->row[i].size)) {
+		if (!utf8_validate(bufRow(buf, i)->chars, bufRow(buf, i)->size)) {
 			printf("  FAIL (%s): row %d contains invalid UTF-8\n",
 			       label, i);
 			_current_test_failed = 1;
@@ -614,7 +614,7 @@ void test_kill_rect_utf8_interior_row(void) {
 	TEST_ASSERT_EQUAL_STRING("ad", row_str(buf, 2));
 
 	/* Cursor and mark must land on character boundaries */
-	TEST_ASSERT(buf->cx == 0 || !utf8_isCont(buf->row[buf->cy].chars[buf->cx]));
+	TEST_ASSERT(buf->cx == 0 || !utf8_isCont(bufRow(buf, buf->cy)->chars[buf->cx]));
 
 	doUndo(buf, 1);
 	assert_buffer_matches(buf, snap, snap_n, "kill_rect_utf8_undo");
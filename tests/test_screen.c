@@ -0,0 +1,268 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* test_screen.c: laying frames out on cells, and the spans that differ. */
+
+#include "test.h"
+#include "screen.h"
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROWS 4
+#define COLS 20
+
+static struct screen a, b;
+
+static void parse(struct screen *s, const char *frame) {
+	screenParse(s, ROWS, COLS, frame, (int)strlen(frame));
+}
+
+/* Row r as the terminal would show it: its characters, a space for a
+ * blank, and a '*' after each reversed cell so attributes count. */
+static const char *shown(const struct screen *s, int r) {
+	static char line[COLS * 8 + 1];
+	int n = 0;
+	for (int c = 0; c < s->cols; c++) {
+		const struct cell *cell = &s->cells[r * s->cols + c];
+		if (cell->width == 0)
+			continue;
+		if (cell->len == 0)
+			line[n++] = ' ';
+		memcpy(line + n, s->text.b + cell->off, cell->len);
+		n += cell->len;
+		if (cell->attr & SCREEN_REVERSE)
+			line[n++] = '*';
+	}
+	line[n] = '\0';
+	return line;
+}
+
+/* Whether the bytes screenScroll() of rows [top, bottom) and
+ * screenDiff() give for from -> to, sent to a terminal showing from,
+ * leave it showing to.  The terminal is a screen laid out from a full
+ * repaint of from followed by those bytes.  Shifts from. */
+static void assertScrollReaches(struct screen *from, struct screen *to,
+				int top, int bottom) {
+	struct screen blank = { 0 };
+	struct abuf stream = ABUF_INIT;
+	screenDiff(&stream, &blank, from);
+	screenScroll(&stream, from, to, top, bottom);
+	screenDiff(&stream, from, to);
+
+	struct screen term = { 0 };
+	screenParse(&term, to->rows, to->cols, stream.b, stream.len);
+	for (int r = 0; r < to->rows; r++) {
+		char want[COLS * 8 + 1];
+		snprintf(want, sizeof(want), "%s", shown(to, r));
+		TEST_ASSERT_EQUAL_STRING(want, shown(&term, r));
+	}
+	screenFree(&term);
+	abFree(&stream);
+}
+
+static void assertDiffReaches(struct screen *from, struct screen *to) {
+	assertScrollReaches(from, to, 0, 0);
+}
+
+static int diffBytes(struct screen *from, struct screen *to) {
+	struct abuf out = ABUF_INIT;
+	screenDiff(&out, from, to);
+	int n = out.len;
+	abFree(&out);
+	return n;
+}
+
+void test_parse_places_text_moves_and_erases(void) {
+	parse(&a, "\x1b[Hhello\r\nworld\x1b[K\r\n"
+		  "\x1b[7mbar\x1b[0m\x1b[4;3Hxy\x1b[J");
+	TEST_ASSERT_EQUAL_STRING("hello               ", shown(&a, 0));
+	TEST_ASSERT_EQUAL_STRING("world               ", shown(&a, 1));
+	TEST_ASSERT_EQUAL_STRING("b*a*r*                 ", shown(&a, 2));
+	TEST_ASSERT_EQUAL_STRING("  xy                ", shown(&a, 3));
+}
+
+/* Text past the right edge is dropped, as with auto-wrap off. */
+void test_parse_drops_text_past_the_edge(void) {
+	parse(&a, "0123456789abcdefghijKLM\r\nnext");
+	TEST_ASSERT_EQUAL_STRING("0123456789abcdefghij", shown(&a, 0));
+	TEST_ASSERT_EQUAL_STRING("next                ", shown(&a, 1));
+}
+
+void test_parse_wide_characters_take_two_cells(void) {
+	parse(&a, "a\xe4\xb8\xad" "b");
+	TEST_ASSERT_EQUAL_STRING("a\xe4\xb8\xad" "b                ",
+				 shown(&a, 0));
+	TEST_ASSERT_EQUAL_INT(2, a.cells[1].width);
+	TEST_ASSERT_EQUAL_INT(0, a.cells[2].width);
+	TEST_ASSERT_EQUAL_INT('b', a.text.b[a.cells[3].off]);
+
+	/* Writing over the right half blanks the left. */
+	parse(&a, "a\xe4\xb8\xad\x1b[1;3Hx");
+	TEST_ASSERT_EQUAL_STRING("a x                 ", shown(&a, 0));
+}
+
+void test_parse_joins_combining_mark_to_its_base(void) {
+	parse(&a, "e\xcc\x81x");
+	TEST_ASSERT_EQUAL_INT(3, a.cells[0].len);
+	TEST_ASSERT_EQUAL_STRING("e\xcc\x81x                  ",
+				 shown(&a, 0));
+}
+
+void test_equal_screens_diff_to_nothing(void) {
+	parse(&a, "same\r\ntext");
+	parse(&b, "same\r\ntext");
+	TEST_ASSERT_EQUAL_INT(0, diffBytes(&a, &b));
+}
+
+void test_one_changed_character_is_one_short_span(void) {
+	parse(&a, "the quick brown fox\r\njumps");
+	parse(&b, "the quick crown fox\r\njumps");
+	struct abuf out = ABUF_INIT;
+	screenDiff(&out, &a, &b);
+	static const char want[] = "\x1b[1;11H\x1b[0mc";
+	TEST_ASSERT_EQUAL_INT((int)sizeof(want) - 1, out.len);
+	TEST_ASSERT_EQUAL_INT(0, memcmp(out.b, want, out.len));
+	abFree(&out);
+	assertDiffReaches(&a, &b);
+}
+
+/* An invalid or differently sized screen is repainted whole. */
+void test_invalid_or_resized_screen_repaints_everything(void) {
+	parse(&a, "x");
+	parse(&b, "x");
+	int same = diffBytes(&a, &b);
+	a.valid = 0;
+	TEST_ASSERT_TRUE(diffBytes(&a, &b) > same);
+
+	screenParse(&a, ROWS + 1, COLS, "x", 1);
+	TEST_ASSERT_TRUE(diffBytes(&a, &b) > same);
+}
+
+void test_diffs_reach_the_new_screen(void) {
+	parse(&a, "alpha beta gamma\r\n\x1b[7mstatus  1:1\x1b[0m\r\n"
+		  "long line of text\r\nend");
+	parse(&b, "alpha beta\r\n\x1b[7mstatus  1:12\x1b[0m\r\n"
+		  "long lime of text!!\r\n");
+	assertDiffReaches(&a, &b);
+	assertDiffReaches(&b, &a);
+
+	/* Wide characters, old and new, over each other's halves. */
+	parse(&a, "a\xe4\xb8\xad\xe6\x96\x87z");
+	parse(&b, "ab\xe4\xb8\xad" "cz");
+	assertDiffReaches(&a, &b);
+	assertDiffReaches(&b, &a);
+}
+
+/* A line cleared to its end is erased, not written out in spaces. */
+void test_cleared_tail_is_erased(void) {
+	parse(&a, "0123456789abcdefghij");
+	parse(&b, "01");
+	struct abuf out = ABUF_INIT;
+	screenDiff(&out, &a, &b);
+	static const char want[] = "\x1b[1;3H\x1b[0m\x1b[K";
+	TEST_ASSERT_EQUAL_INT((int)sizeof(want) - 1, out.len);
+	TEST_ASSERT_EQUAL_INT(0, memcmp(out.b, want, out.len));
+	abFree(&out);
+	assertDiffReaches(&a, &b);
+}
+
+/* Lines first on of a text whose line n is 15 of letter n, then a
+ * status line, on a screen of SCROLL_ROWS. */
+#define SCROLL_ROWS 10
+static void numbered(struct screen *s, int first) {
+	struct abuf f = ABUF_INIT;
+	char line[32];
+	for (int i = 0; i < SCROLL_ROWS - 1; i++) {
+		memset(line, 'a' + first + i, 15);
+		memcpy(line + 15, "\x1b[K\r\n", 5);
+		abAppend(&f, line, 20);
+	}
+	static const char status[] = "\x1b[7mstatus\x1b[0m";
+	abAppend(&f, status, (int)sizeof(status) - 1);
+	screenParse(s, SCROLL_ROWS, COLS, f.b, f.len);
+	abFree(&f);
+}
+
+static int containsBytes(const struct abuf *ab, const char *needle) {
+	int n = (int)strlen(needle);
+	for (int i = 0; i + n <= ab->len; i++)
+		if (memcmp(ab->b + i, needle, n) == 0)
+			return 1;
+	return 0;
+}
+
+/* A window scrolled by a few lines is shifted on the terminal, and
+ * only the lines it exposed are written. */
+void test_scrolled_window_is_shifted_not_rewritten(void) {
+	numbered(&a, 0);
+	numbered(&b, 3);
+	int plain = diffBytes(&a, &b);
+
+	struct abuf out = ABUF_INIT;
+	screenScroll(&out, &a, &b, 0, SCROLL_ROWS - 1);
+	TEST_ASSERT_TRUE(containsBytes(&out, "\x1b[1;9r"));
+	TEST_ASSERT_TRUE(containsBytes(&out, "\x1b[3M"));
+	screenDiff(&out, &a, &b);
+	TEST_ASSERT_TRUE(out.len < plain / 2);
+	TEST_ASSERT_TRUE(containsBytes(&out, "lllllllllllllll"));
+	TEST_ASSERT_FALSE(containsBytes(&out, "fffffffffffffff"));
+	abFree(&out);
+
+	numbered(&a, 0);
+	assertScrollReaches(&a, &b, 0, SCROLL_ROWS - 1);
+}
+
+void test_window_scrolled_back_inserts_lines(void) {
+	numbered(&a, 5);
+	numbered(&b, 1);
+	struct abuf out = ABUF_INIT;
+	screenScroll(&out, &a, &b, 0, SCROLL_ROWS - 1);
+	TEST_ASSERT_TRUE(containsBytes(&out, "\x1b[4L"));
+	abFree(&out);
+
+	numbered(&a, 5);
+	assertScrollReaches(&a, &b, 0, SCROLL_ROWS - 1);
+}
+
+/* Unrelated contents, or an unchanged window, send no scroll. */
+void test_no_scroll_without_a_shift(void) {
+	numbered(&a, 0);
+	numbered(&b, 0);
+	struct abuf out = ABUF_INIT;
+	screenScroll(&out, &a, &b, 0, SCROLL_ROWS - 1);
+	TEST_ASSERT_EQUAL_INT(0, out.len);
+
+	screenParse(&b, SCROLL_ROWS, COLS, "other\r\ntext", 11);
+	screenScroll(&out, &a, &b, 0, SCROLL_ROWS - 1);
+	TEST_ASSERT_EQUAL_INT(0, out.len);
+	abFree(&out);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+	screenFree(&a);
+	screenFree(&b);
+}
+
+int main(void) {
+	setlocale(LC_CTYPE, "C.UTF-8");
+
+	TEST_BEGIN();
+
+	RUN_TEST(test_parse_places_text_moves_and_erases);
+	RUN_TEST(test_parse_drops_text_past_the_edge);
+	RUN_TEST(test_parse_wide_characters_take_two_cells);
+	RUN_TEST(test_parse_joins_combining_mark_to_its_base);
+	RUN_TEST(test_equal_screens_diff_to_nothing);
+	RUN_TEST(test_one_changed_character_is_one_short_span);
+	RUN_TEST(test_invalid_or_resized_screen_repaints_everything);
+	RUN_TEST(test_diffs_reach_the_new_screen);
+	RUN_TEST(test_cleared_tail_is_erased);
+	RUN_TEST(test_scrolled_window_is_shifted_not_rewritten);
+	RUN_TEST(test_window_scrolled_back_inserts_lines);
+	RUN_TEST(test_no_scroll_without_a_shift);
+
+	return TEST_END();
+}
@@ -241,7 +241,7 @@ static struct buffer *eofTestBuffer(void) {
 static void gotoVirtualEOF(struct buffer *buf) {
 	processKeypress(CMD_END_OF_FILE);
 	TEST_ASSERT_EQUAL(buf->numrows - 1, buf->cy);
-	TEST_ASSERT_EQUAL(buf->row[buf->cy].size, buf->cx);
+	TEST_ASSERT_EQUAL(bufRow(buf, buf->cy)->size, buf->cx);
 }
 
 static void setKillText(const char *s) {
@@ -533,7 +533,7 @@ void test_mark_unmoved_by_newline_at_virtual_eof(void) {
 	 * numrows - 1, which since #105 names the trailing empty row and
 	 * would put the mark somewhere else entirely. */
 	buf->cy = 1;
-	buf->cx = buf->row[1].size;
+	buf->cx = bufRow(buf, 1)->size;
 	processKeypress(CMD_SET_MARK);
 	int markx = buf->markx, marky = buf->marky;
 	TEST_ASSERT_EQUAL(4, markx);
@@ -559,14 +559,14 @@ void test_mark_unmoved_by_yank_at_virtual_eof(void) {
 	 * numrows - 1, which since #105 names the trailing empty row and
 	 * would put the mark somewhere else entirely. */
 	buf->cy = 1;
-	buf->cx = buf->row[1].size;
+	buf->cx = bufRow(buf, 1)->size;
 	processKeypress(CMD_SET_MARK);
 	int markx = buf->markx, marky = buf->marky;
 
 	/* End of buffer.  cy == numrows is unreachable under #105, so
 	 * this is the last real row -- the same place in the text. */
 	buf->cy = buf->numrows - 1;
-	buf->cx = buf->row[buf->cy].size;
+	buf->cx = bufRow(buf, buf->cy)->size;
 	setKillText("\n");
 	processKeypress(CMD_YANK);
 
@@ -748,7 +748,7 @@ void test_minibuffer_reset_drops_stale_undo_records(void) {
 	 * rather than a negative-length memmove. */
 	doUndo(E.minibuf, 1);
 	TEST_ASSERT_EQUAL_INT(1, E.minibuf->numrows);
-	TEST_ASSERT(E.minibuf->row[0].size >= 0);
+	TEST_ASSERT(bufRow(E.minibuf, 0)->size >= 0);
 
 	freeMinibuffer();
 }
@@ -763,8 +763,8 @@ void test_bulk_delete_clamps_out_of_range_end(void) {
 	 * would give. */
 	bulkDelete(buf, 0, 0, 99, 0);
 
-	TEST_ASSERT_EQUAL_INT(0, buf->row[0].size);
-	TEST_ASSERT_EQUAL_STRING("", (char *)buf->row[0].chars);
+	TEST_ASSERT_EQUAL_INT(0, bufRow(buf, 0)->size);
+	TEST_ASSERT_EQUAL_STRING("", (char *)bufRow(buf, 0)->chars);
 
 }
 
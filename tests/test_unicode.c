@@ -112,6 +112,30 @@ void test_snap_boundary_end_of_line(void) {
 	TEST_ASSERT_EQUAL_INT(0, utf8_snapToBoundary(r, 0, 0, +1));
 }
 
+/* Every stop byte must be found at every position in and around a
+ * 16-byte stride, and nothing printable may stop the skip. */
+void test_skip_printable_finds_each_stop(void) {
+	const uint8_t stops[] = { '\n', '\0', '\t', 0x1b, 0x7f, 0x80, 0xc3,
+				  0xff };
+	uint8_t line[40];
+	for (size_t s = 0; s < sizeof(stops); s++) {
+		for (int at = 0; at < (int)sizeof(line); at++) {
+			memset(line, 'x', sizeof(line));
+			line[at] = stops[s];
+			const uint8_t *got =
+				utf8_skipPrintable(line, line + sizeof(line));
+			TEST_ASSERT_EQUAL_INT(at, (int)(got - line));
+		}
+	}
+	for (int c = 0x20; c < 0x7f; c++) {
+		memset(line, c, sizeof(line));
+		TEST_ASSERT_EQUAL_INT(
+			(int)sizeof(line),
+			(int)(utf8_skipPrintable(line, line + sizeof(line)) -
+			      line));
+	}
+}
+
 int main(void) {
 	TEST_BEGIN();
 	RUN_TEST(test_utf8_continuation);
@@ -122,5 +146,6 @@ int main(void) {
 	RUN_TEST(test_snap_boundary_forward);
 	RUN_TEST(test_snap_boundary_backward);
 	RUN_TEST(test_snap_boundary_end_of_line);
+	RUN_TEST(test_skip_printable_finds_each_stop);
 	return TEST_END();
 }
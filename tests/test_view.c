@@ -0,0 +1,277 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* test_view.c: read-only views of files too large to load. */
+
+#include "test.h"
+#include "test_harness.h"
+#include "buffer.h"
+#include "fileio.h"
+#include "find.h"
+#include "region.h"
+#include "util.h"
+#include "view.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* More lines than several windows hold.  viewOpen() takes any size of
+ * file; only editorOpen() reserves it for large ones. */
+#define VIEW_TEST_LINES 50000
+
+static char path[64];
+
+/* "line 0\n" ... "line 49999\n", so the file's last line, after the
+ * final newline, is the empty line VIEW_TEST_LINES. */
+static void writeNumbered(void) {
+	emil_strlcpy(path, "/tmp/emil_view_XXXXXX", sizeof(path));
+	int fd = mkstemp(path);
+	FILE *fp = fdopen(fd, "w");
+	for (int i = 0; i < VIEW_TEST_LINES; i++)
+		fprintf(fp, "line %d\n", i);
+	fclose(fp);
+}
+
+static void writeBytes(const char *p, size_t len) {
+	emil_strlcpy(path, "/tmp/emil_view_XXXXXX", sizeof(path));
+	int fd = mkstemp(path);
+	TEST_ASSERT_TRUE(write(fd, p, len) == (ssize_t)len);
+	close(fd);
+}
+
+static struct buffer *openView(void) {
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, viewOpen(buf, path));
+	return buf;
+}
+
+void test_view_opens_read_only_on_first_window(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	TEST_ASSERT_TRUE(buf->read_only);
+	TEST_ASSERT_TRUE(buf->numrows > 1);
+	TEST_ASSERT_TRUE(buf->numrows < VIEW_TEST_LINES);
+	TEST_ASSERT_EQUAL_STRING("line 0", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_INT(0, buf->cy);
+}
+
+void test_view_show_far_line(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	int row = viewShow(buf, 37000);
+	TEST_ASSERT_EQUAL_STRING("line 37000", row_str(buf, row));
+	TEST_ASSERT_EQUAL_INT(37000, (int)viewLine(buf, row));
+
+	/* And back again, to a line the scan has already passed. */
+	row = viewShow(buf, 12);
+	TEST_ASSERT_EQUAL_STRING("line 12", row_str(buf, row));
+}
+
+void test_view_show_last_line(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	int row = viewShow(buf, VIEW_LAST_LINE);
+	TEST_ASSERT_EQUAL_INT(buf->numrows - 1, row);
+	TEST_ASSERT_EQUAL_INT(VIEW_TEST_LINES, (int)viewLine(buf, row));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, row));
+	TEST_ASSERT_EQUAL_STRING("line 49999", row_str(buf, row - 1));
+}
+
+/* Moving the window must carry the cursor with it: the row index
+ * changes, the line under the cursor does not. */
+void test_view_settle_keeps_cursor_line(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	buf->cy = buf->numrows - 2;
+	buf->cx = 3;
+	long long line = viewLine(buf, buf->cy);
+	viewSettle(buf);
+
+	TEST_ASSERT_EQUAL_INT((int)line, (int)viewLine(buf, buf->cy));
+	TEST_ASSERT_EQUAL_INT(3, buf->cx);
+	TEST_ASSERT_TRUE(buf->cy < buf->numrows - 2);
+	TEST_ASSERT_TRUE(buf->cy > 0);
+}
+
+void test_view_opens_without_mark(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	TEST_ASSERT_EQUAL_INT(-1, buf->marky);
+	TEST_ASSERT_EQUAL_INT(-1, buf->markx);
+	viewShow(buf, 37000);
+	TEST_ASSERT_EQUAL_INT(-1, buf->marky);
+}
+
+/* A mark the window moves off keeps its file line, and going to it
+ * brings it back rather than landing on an edge of the window. */
+void test_view_mark_keeps_its_line(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+	buf->cy = 5;
+	buf->cx = 2;
+	setMarkSilent();
+	buf->cy = viewShow(buf, 37000);
+	buf->cx = 0;
+
+	TEST_ASSERT_TRUE(buf->marky < 0);
+	TEST_ASSERT_TRUE(markInvalidBuf(buf));
+	setMarkSilent();
+	buf->cy = viewShow(buf, 12000);
+
+	popMark();
+	TEST_ASSERT_EQUAL_INT(37000, (int)viewLine(buf, buf->cy));
+	TEST_ASSERT_EQUAL_INT(0, buf->cx);
+	popMark();
+	TEST_ASSERT_EQUAL_INT(5, (int)viewLine(buf, buf->cy));
+	TEST_ASSERT_EQUAL_INT(2, buf->cx);
+}
+
+void test_view_step_forward_and_back(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	long long next = viewLine(buf, buf->numrows - 1) + 1;
+	int row = viewStep(buf, 1);
+	TEST_ASSERT_TRUE(row >= 0);
+	TEST_ASSERT_EQUAL_INT((int)next, (int)viewLine(buf, row));
+
+	long long prev = viewLine(buf, 0) - 1;
+	row = viewStep(buf, -1);
+	TEST_ASSERT_TRUE(row >= 0);
+	TEST_ASSERT_EQUAL_INT((int)prev, (int)viewLine(buf, row));
+
+	viewShow(buf, 0);
+	TEST_ASSERT_EQUAL_INT(-1, viewStep(buf, -1));
+	viewShow(buf, VIEW_LAST_LINE);
+	TEST_ASSERT_EQUAL_INT(-1, viewStep(buf, 1));
+}
+
+/* Incremental search carries on past the end of the window. */
+void test_view_search_beyond_first_window(void) {
+	writeNumbered();
+	makeMinibuffer();
+	struct buffer *buf = openView();
+
+	int keys[] = { 'l', 'i', 'n', 'e', ' ', '4', '2', '0', '0', '0', '\r' };
+	scriptKeys(keys, 11);
+	muteStdout();
+	editorFind();
+	unmuteStdout();
+	clearKeys();
+
+	TEST_ASSERT_EQUAL_INT(42000, (int)viewLine(buf, buf->cy));
+	TEST_ASSERT_EQUAL_STRING("line 42000", row_str(buf, buf->cy));
+	freeMinibuffer();
+}
+
+/* A search with no match stops at the next window when a key is
+ * waiting, rather than scanning the whole file first. */
+void test_view_search_stops_for_pending_key(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+
+	test_input_pending = 1;
+	findCallback(buf, (uint8_t *)"no such line", 'e');
+	test_input_pending = 0;
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Searching"));
+	TEST_ASSERT_FALSE(buf->match);
+	TEST_ASSERT_EQUAL_INT(0, (int)viewLine(buf, buf->cy));
+
+	findCallback(buf, (uint8_t *)"no such line", 'e');
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Failing"));
+	findCallback(buf, NULL, '\r');
+}
+
+void test_view_shows_nul_and_invalid_bytes_as_question_marks(void) {
+	static const char bytes[] = "a\0b\xff" "c\r\nok\n";
+	writeBytes(bytes, sizeof(bytes) - 1);
+	struct buffer *buf = openView();
+
+	TEST_ASSERT_EQUAL_STRING("a?b?c", row_str(buf, 0));
+	TEST_ASSERT_EQUAL_STRING("ok", row_str(buf, 1));
+}
+
+/* An over-long line shows its head, and the window still reaches the
+ * line after it. */
+void test_view_truncates_long_line(void) {
+	size_t len = 2 * 1024 * 1024;
+	char *p = xmalloc(len + 6);
+	memset(p, 'x', len);
+	memcpy(p + len, "\ntail\n", 6);
+	writeBytes(p, len + 6);
+	free(p);
+	struct buffer *buf = openView();
+
+	TEST_ASSERT_EQUAL_INT(1024 * 1024, bufRow(buf, 0)->size);
+	TEST_ASSERT_EQUAL_STRING("tail", row_str(buf, 1));
+}
+
+void test_view_refuses_save(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+	buf->filename = xstrdup(path);
+	buf->dirty = 1;
+
+	save(0);
+
+	TEST_ASSERT_EQUAL_STRING("Can't save a large-file view", E.statusmsg);
+	FILE *fp = fopen(path, "r");
+	char first[16] = { 0 };
+	TEST_ASSERT_NOT_NULL(fgets(first, sizeof(first), fp));
+	fclose(fp);
+	TEST_ASSERT_EQUAL_STRING("line 0\n", first);
+}
+
+/* A grown file's new lines are reachable, and a window holding the
+ * old end takes them in. */
+void test_view_grow_takes_in_new_lines(void) {
+	writeNumbered();
+	struct buffer *buf = openView();
+	viewShow(buf, VIEW_LAST_LINE);
+
+	FILE *fp = fopen(path, "a");
+	fprintf(fp, "more 1\nmore 2\n");
+	long size = ftell(fp);
+	fclose(fp);
+	viewGrow(buf, size);
+
+	TEST_ASSERT_EQUAL_STRING("more 1", row_str(buf, viewShow(buf, 50000)));
+	int row = viewShow(buf, VIEW_LAST_LINE);
+	TEST_ASSERT_TRUE(viewAtEnd(buf, row));
+	TEST_ASSERT_EQUAL_STRING("more 2", row_str(buf, row - 1));
+}
+
+void setUp(void) {
+	initTestEditor();
+	path[0] = '\0';
+}
+
+void tearDown(void) {
+	if (path[0])
+		unlink(path);
+	cleanupTestEditor();
+}
+
+int main(void) {
+	TEST_BEGIN();
+
+	RUN_TEST(test_view_opens_read_only_on_first_window);
+	RUN_TEST(test_view_show_far_line);
+	RUN_TEST(test_view_show_last_line);
+	RUN_TEST(test_view_settle_keeps_cursor_line);
+	RUN_TEST(test_view_opens_without_mark);
+	RUN_TEST(test_view_mark_keeps_its_line);
+	RUN_TEST(test_view_step_forward_and_back);
+	RUN_TEST(test_view_search_beyond_first_window);
+	RUN_TEST(test_view_search_stops_for_pending_key);
+	RUN_TEST(test_view_shows_nul_and_invalid_bytes_as_question_marks);
+	RUN_TEST(test_view_truncates_long_line);
+	RUN_TEST(test_view_refuses_save);
+	RUN_TEST(test_view_grow_takes_in_new_lines);
+
+	return TEST_END();
+}
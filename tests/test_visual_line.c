@@ -5,6 +5,9 @@
 #include "test_harness.h"
 #include "edit.h"
 #include "display.h"
+#include "mutate.h"
+#include "unicode.h"
+#include "util.h"
 #include "wrap.h"
 #include <stdint.h>
 
@@ -19,6 +22,12 @@ static erow make_row(const char *s) {
 	return r;
 }
 
+/* A row made here is in no buffer, so nothing else frees the cache a
+ * wrapped or long one gets. */
+static void drop_row(erow *r) {
+	invalidateRowCache(r);
+}
+
 /* ---- displayColumnToByteOffset tests ---- */
 
 void test_dcbo_simple_ascii(void) {
@@ -28,6 +37,7 @@ void test_dcbo_simple_ascii(void) {
 	TEST_ASSERT_EQUAL_INT(0, b);
 	b = displayColumnToByteOffset(&row, 20, 0, 5);
 	TEST_ASSERT_EQUAL_INT(5, b);
+	drop_row(&row);
 }
 
 void test_dcbo_second_subline(void) {
@@ -41,6 +51,7 @@ void test_dcbo_second_subline(void) {
 	TEST_ASSERT_EQUAL_INT(20, b);
 	b = displayColumnToByteOffset(&row, 20, 1, 5);
 	TEST_ASSERT_EQUAL_INT(25, b);
+	drop_row(&row);
 }
 
 void test_dcbo_clamp_to_subline_end(void) {
@@ -104,6 +115,7 @@ void test_subline_bounds_wrapped(void) {
 	TEST_ASSERT_TRUE(ok);
 	TEST_ASSERT_EQUAL_INT(20, sb);
 	TEST_ASSERT_EQUAL_INT(40, eb);
+	drop_row(&row);
 }
 
 void test_subline_bounds_nonexistent(void) {
@@ -319,7 +331,7 @@ void test_kill_visual_line_mid_subline(void) {
 	killLine(0);
 	/* Should kill bytes 5..19 (15 chars from sub-line 0)
 	 * Remaining: 5 'a' + 20 'a' from sub-line 1 = 25 'a' */
-	TEST_ASSERT_EQUAL_INT(25, b->row[0].size);
+	TEST_ASSERT_EQUAL_INT(25, bufRow(b, 0)->size);
 	TEST_ASSERT_EQUAL_INT(5, b->cx);
 }
 
@@ -431,43 +443,142 @@ void test_ctdc_empty_row(void) {
 void test_ctdc_width_follows_a_mutation(void) {
 	struct buffer *b = make_test_buffer("abc");
 
-	int w = charsToDisplayColumn(&b->row[0], b->row[0].size);
+	int w = charsToDisplayColumn(bufRow(b, 0), bufRow(b, 0)->size);
 	TEST_ASSERT_EQUAL_INT(3, w);
 	/* The cache is warm from here on, so a stale read is possible
 	 * and the assertions below can distinguish one. */
-	TEST_ASSERT_EQUAL_INT(3, b->row[0].cached_width);
+	TEST_ASSERT_EQUAL_INT(3, bufRow(b, 0)->cached_width);
 
 	b->cx = 3;
 	b->cy = 0;
 	selfInsert(b, '\t', 1); /* "abc\t" -- one tab stop wide */
-	w = charsToDisplayColumn(&b->row[0], b->row[0].size);
+	w = charsToDisplayColumn(bufRow(b, 0), bufRow(b, 0)->size);
 	TEST_ASSERT_EQUAL_INT(EMIL_TAB_STOP, w);
 
 	b->cx = 3;
 	delChar(1); /* back to "abc" */
-	w = charsToDisplayColumn(&b->row[0], b->row[0].size);
+	w = charsToDisplayColumn(bufRow(b, 0), bufRow(b, 0)->size);
 	TEST_ASSERT_EQUAL_INT(3, w);
 }
 
-/* §4.10's other half is gone with the field it protected.
- *
- * cached_sublines was a remembered wrap count, and the test that stood
- * here drove the protocol keeping it honest: mutate, warm the width
- * from a display path, and check the sub-line count had not survived.
- * There is nothing to keep honest now -- the count is computed from the
- * row at the moment it is wanted (#108) -- so what is worth pinning is
- * that it stays derived, with no invalidation call anywhere in sight. */
-void test_sublines_are_derived_not_remembered(void) {
-	struct buffer *b = make_test_buffer("abcde");
+/* §4.10's other half: the wrap breaks are remembered again, keyed by
+ * width, and the same protocol that keeps the width honest must keep
+ * them honest.  Warm them, mutate through the mutation layer, and check
+ * the count follows the text rather than the cache. */
+void test_sublines_follow_a_mutation(void) {
+	struct buffer *b = make_test_buffer("abcdexxxxxxxx");
 	b->word_wrap = 1;
 
-	TEST_ASSERT_EQUAL_INT(1, countScreenLines(&b->row[0], 10));
+	TEST_ASSERT_EQUAL_INT(2, countScreenLines(bufRow(b, 0), 10));
 
 	b->cx = 5;
 	b->cy = 0;
-	selfInsert(b, 'x', 8); /* "abcdexxxxxxxx" -- 13 cols, wraps */
+	delChar(8); /* "abcde" -- fits */
+	TEST_ASSERT_EQUAL_INT(1, countScreenLines(bufRow(b, 0), 10));
+
+	selfInsert(b, 'x', 18); /* 23 cols: three sub-lines */
+	TEST_ASSERT_EQUAL_INT(3, countScreenLines(bufRow(b, 0), 10));
+}
+
+/* The breaks are computed once per width: a second ask is a lookup
+ * into the same array, and another width wraps the row afresh. */
+void test_wrap_breaks_cached_per_width(void) {
+	char text[41];
+	memset(text, 'a', 40);
+	text[40] = '\0';
+	struct buffer *b = make_test_buffer(text);
+	erow *row = bufRow(b, 0);
+
+	const struct wrapPoint *at, *again;
+	TEST_ASSERT_EQUAL_INT(2, rowBreaks(row, 20, &at));
+	TEST_ASSERT_EQUAL_INT(20, at[1].byte);
+	TEST_ASSERT_EQUAL_INT(20, at[1].col);
+	TEST_ASSERT_EQUAL_INT(2, rowBreaks(row, 20, &again));
+	TEST_ASSERT_TRUE(at == again);
+
+	TEST_ASSERT_EQUAL_INT(4, rowBreaks(row, 10, &at));
+	TEST_ASSERT_EQUAL_INT(30, at[3].byte);
+
+	/* A row that fits keeps no cache. */
+	TEST_ASSERT_EQUAL_INT(1, rowBreaks(row, 40, &at));
+	TEST_ASSERT_NULL(row->cache);
+	TEST_ASSERT_EQUAL_INT(0, at[0].byte);
+}
+
+/* A long row, past the size that gets column checkpoints: tabs, a
+ * double-width character and a control character, in runs that do not
+ * divide the checkpoint spacing, so checkpoints land mid-character. */
+static struct buffer *long_row_buffer(void) {
+	const char *unit = "abc\t\xe6\xbc\xa2 de\x01" "fghij "; /* 17 bytes */
+	int n = 100000 / 17;
+	char *text = xmalloc(n * 17 + 1);
+	for (int i = 0; i < n; i++)
+		memcpy(text + i * 17, unit, 17);
+	text[n * 17] = '\0';
+	struct buffer *b = make_test_buffer(text);
+	free(text);
+	return b;
+}
+
+static int walk_from_zero(erow *row, int pos) {
+	int col = 0;
+	for (int i = 0; i < pos; i++)
+		col = nextScreenX(row->chars, &i, col);
+	return col;
+}
+
+/* Every column a long row reports, at any depth and in either order,
+ * is the one a walk from byte 0 finds. */
+void test_long_row_columns_match_a_walk(void) {
+	struct buffer *b = long_row_buffer();
+	erow *row = bufRow(b, 0);
+	int pos[] = { 90000, 4095, 4096, 4097, 8191, 8193, 65536, 17, 0 };
+
+	for (size_t i = 0; i < sizeof(pos) / sizeof(pos[0]); i++)
+		TEST_ASSERT_EQUAL_INT(walk_from_zero(row, pos[i]),
+				      charsToDisplayColumn(row, pos[i]));
+	TEST_ASSERT_EQUAL_INT(walk_from_zero(row, row->size),
+			      calculateLineWidth(row));
+
+	/* The checkpoint for a column starts at or before it, on a
+	 * character boundary a walk agrees with. */
+	struct wrapPoint p = columnCheckpoint(row, 50000);
+	TEST_ASSERT_TRUE(p.col <= 50000);
+	TEST_ASSERT_TRUE(p.col > 50000 - 4096 * 2);
+	TEST_ASSERT_EQUAL_INT(walk_from_zero(row, p.byte), p.col);
+}
+
+/* An edit in the middle keeps what came before it.  Columns and wrap
+ * breaks on both sides must still match a row that never had a cache,
+ * including the tab stops the inserted tab moves. */
+void test_long_row_edit_invalidates_from_the_edit(void) {
+	struct buffer *b = long_row_buffer();
+	b->word_wrap = 1;
+	erow *row = bufRow(b, 0);
+	const struct wrapPoint *at;
+	rowBreaks(row, 70, &at);
+	charsToDisplayColumn(row, row->size - 1);
 
-	TEST_ASSERT_EQUAL_INT(2, countScreenLines(&b->row[0], 10));
+	b->cx = 50003;
+	b->cy = 0;
+	mutateInsert(b, b->cx, b->cy, (const uint8_t *)"\tx", 2, &b->cx,
+		     &b->cy);
+	row = bufRow(b, 0);
+
+	erow fresh = make_row((const char *)row->chars);
+	int pos[] = { 40000, 50003, 50005, 60000, row->size - 1 };
+	for (size_t i = 0; i < sizeof(pos) / sizeof(pos[0]); i++)
+		TEST_ASSERT_EQUAL_INT(walk_from_zero(&fresh, pos[i]),
+				      charsToDisplayColumn(row, pos[i]));
+
+	const struct wrapPoint *want;
+	int n = rowBreaks(&fresh, 70, &want);
+	TEST_ASSERT_EQUAL_INT(n, rowBreaks(row, 70, &at));
+	for (int i = 0; i < n; i++) {
+		TEST_ASSERT_EQUAL_INT(want[i].byte, at[i].byte);
+		TEST_ASSERT_EQUAL_INT(want[i].col, at[i].col);
+	}
+	drop_row(&fresh);
 }
 
 int main(void) {
@@ -479,7 +590,10 @@ int main(void) {
 	RUN_TEST(test_ctdc_partial_matches_full);
 	RUN_TEST(test_ctdc_empty_row);
 	RUN_TEST(test_ctdc_width_follows_a_mutation);
-	RUN_TEST(test_sublines_are_derived_not_remembered);
+	RUN_TEST(test_sublines_follow_a_mutation);
+	RUN_TEST(test_wrap_breaks_cached_per_width);
+	RUN_TEST(test_long_row_columns_match_a_walk);
+	RUN_TEST(test_long_row_edit_invalidates_from_the_edit);
 
 	/* displayColumnToByteOffset */
 	RUN_TEST(test_dcbo_simple_ascii);
@@ -49,11 +49,14 @@ static void bump_mtime(const char *path, int delta) {
 	utimensat(AT_FDCWD, path, times, 0);
 }
 
-/* Reset the throttle so the next checkFileModified runs immediately.
- * Without this, the 2-second throttle suppresses back-to-back calls
+/* What the main loop does between frames: drain the file watcher,
+ * then poll.  The throttle is reset so the poll runs immediately;
+ * without that, the 2-second throttle suppresses back-to-back calls
  * within the same test or across consecutive tests. */
-static void resetThrottle(void) {
+static void checkNow(void) {
+	readFileWatch();
 	resetFileCheckThrottle();
+	checkFileModified();
 }
 
 /* ---- external_mod / checkFileModified ---- */
@@ -66,9 +69,8 @@ void test_external_mod_not_set_before_change(void) {
 	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
 	TEST_ASSERT_FALSE(buf->external_mod);
 
-	/* refreshScreen would call checkFileModified; call it directly. */
-	resetThrottle();
-	checkFileModified();
+	/* The main loop would do this; call it directly. */
+	checkNow();
 	TEST_ASSERT_FALSE(buf->external_mod);
 
 	unlink(path);
@@ -84,12 +86,120 @@ void test_external_mod_set_on_mtime_change(void) {
 
 	/* Simulate another process touching the file. */
 	bump_mtime(path, 10);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(buf->external_mod);
 
 	/* One-shot: once set, doesn't unset on its own. */
-	resetThrottle();
+	checkNow();
+	TEST_ASSERT_TRUE(buf->external_mod);
+
+	unlink(path);
+	free(path);
+}
+
+/* The watcher covers buffers that are not on screen, which the
+ * focused-buffer poll never did. */
+void test_watcher_flags_unfocused_buffer(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	if (buf->watch_wd < 0) {
+		TEST_SKIP("no file watcher on this platform");
+		unlink(path);
+		free(path);
+		return;
+	}
+	struct buffer *other = make_test_buffer("focused elsewhere");
+	other->next = buf;
+
+	bump_mtime(path, 10);
+	readFileWatch();
+	TEST_ASSERT_TRUE(buf->external_mod);
+
+	unlink(path);
+	free(path);
+}
+
+/* Our own save raises the same events, and must not look external. */
+void test_watcher_ignores_own_save(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	E.buf = buf;
+	rowInsertChar(buf, bufRow(buf, 0), 0, 'x');
+	save(0);
+	TEST_ASSERT_NOT_NULL(strstr(E.statusmsg, "Wrote"));
+
+	readFileWatch();
+	TEST_ASSERT_FALSE(buf->external_mod);
+
+	unlink(path);
+	free(path);
+}
+
+/* A symlink to a file in another directory is watched through its
+ * target's directory. */
+void test_watcher_follows_symlink(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+	char dir[] = "/tmp/emil_test_dir_XXXXXX";
+	TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+	char link[64];
+	snprintf(link, sizeof(link), "%s/link", dir);
+	TEST_ASSERT_EQUAL_INT(0, symlink(path, link));
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, link));
+	if (buf->watch_wd < 0) {
+		TEST_SKIP("no file watcher on this platform");
+	} else {
+		bump_mtime(path, 10);
+		TEST_ASSERT_EQUAL_INT(1, readFileWatch());
+		TEST_ASSERT_TRUE(buf->external_mod);
+	}
+
+	unlink(link);
+	rmdir(dir);
+	unlink(path);
+	free(path);
+}
+
+/* Events about files no buffer holds ask for no redraw. */
+void test_watcher_ignores_other_files(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+	char *other = make_temp_file("neighbour\n");
+	TEST_ASSERT_NOT_NULL(other);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	readFileWatch();
+	bump_mtime(other, 10);
+	TEST_ASSERT_EQUAL_INT(0, readFileWatch());
+	TEST_ASSERT_FALSE(buf->external_mod);
+
+	unlink(other);
+	free(other);
+	unlink(path);
+	free(path);
+}
+
+/* A watched buffer is polled too, for the filesystems whose changes
+ * inotify never reports, such as those made from another NFS client. */
+void test_watched_buffer_is_polled(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+
+	/* The change is not read from the watcher. */
+	bump_mtime(path, 10);
+	resetFileCheckThrottle();
 	checkFileModified();
 	TEST_ASSERT_TRUE(buf->external_mod);
 
@@ -97,6 +207,149 @@ void test_external_mod_set_on_mtime_change(void) {
 	free(path);
 }
 
+/* A buffer the watcher does not cover is still polled. */
+void test_unwatched_buffer_is_polled(void) {
+	char *path = make_temp_file("original\n");
+	TEST_ASSERT_NOT_NULL(path);
+
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	unwatchBuffer(buf);
+
+	bump_mtime(path, 10);
+	resetFileCheckThrottle();
+	checkFileModified();
+	TEST_ASSERT_TRUE(buf->external_mod);
+
+	unlink(path);
+	free(path);
+}
+
+/* ---- follow mode ---- */
+
+static void append_to_file(const char *path, const char *s) {
+	int fd = open(path, O_WRONLY | O_APPEND);
+	TEST_ASSERT_TRUE(fd >= 0);
+	TEST_ASSERT_TRUE(write(fd, s, strlen(s)) == (ssize_t)strlen(s));
+	close(fd);
+}
+
+/* Growth is appended, not flagged, and the cursor on the last row
+ * stays with the end. */
+void test_follow_appends_growth(void) {
+	char *path = make_temp_file("a\nb\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	followMode();
+	TEST_ASSERT_TRUE(buf->follow);
+	TEST_ASSERT_EQUAL_INT(2, buf->cy);
+
+	append_to_file(path, "c\nd\n");
+	checkNow();
+
+	TEST_ASSERT_FALSE(buf->external_mod);
+	TEST_ASSERT_FALSE(buf->dirty);
+	TEST_ASSERT_EQUAL_INT(5, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("c", row_str(buf, 2));
+	TEST_ASSERT_EQUAL_STRING("d", row_str(buf, 3));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 4));
+	TEST_ASSERT_EQUAL_INT(4, buf->cy);
+
+	unlink(path);
+	free(path);
+}
+
+/* A line caught half-written is completed by the next read, not split
+ * across two rows. */
+void test_follow_completes_unfinished_line(void) {
+	char *path = make_temp_file("a\npar");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	buf->cy = 0;
+	followMode();
+	buf->cy = 0; /* moved away from the end: not pinned */
+
+	append_to_file(path, "tial\nx");
+	checkNow();
+	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("partial", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("x", row_str(buf, 2));
+
+	append_to_file(path, "y\n");
+	checkNow();
+	TEST_ASSERT_EQUAL_INT(4, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("xy", row_str(buf, 2));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 3));
+	TEST_ASSERT_EQUAL_INT(0, buf->cy);
+	TEST_ASSERT_FALSE(buf->external_mod);
+
+	unlink(path);
+	free(path);
+}
+
+/* A character split across two writes is not taken for invalid
+ * UTF-8: the unfinished line shows up to it until the rest arrives. */
+void test_follow_keeps_split_utf8_whole(void) {
+	char *path = make_temp_file("a\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	followMode();
+
+	append_to_file(path, "caf\xc3");
+	checkNow();
+	TEST_ASSERT_TRUE(buf->follow);
+	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("caf", row_str(buf, 1));
+
+	append_to_file(path, "\xa9\n");
+	checkNow();
+	TEST_ASSERT_TRUE(buf->follow);
+	TEST_ASSERT_FALSE(buf->external_mod);
+	TEST_ASSERT_EQUAL_INT(3, buf->numrows);
+	TEST_ASSERT_EQUAL_STRING("caf\xc3\xa9", row_str(buf, 1));
+	TEST_ASSERT_EQUAL_STRING("", row_str(buf, 2));
+
+	unlink(path);
+	free(path);
+}
+
+/* A file that shrinks, as a rotated log does, ends follow mode. */
+void test_follow_stops_when_truncated(void) {
+	char *path = make_temp_file("one\ntwo\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	followMode();
+
+	TEST_ASSERT_EQUAL_INT(0, truncate(path, 0));
+	append_to_file(path, "x\n");
+	checkNow();
+
+	TEST_ASSERT_FALSE(buf->follow);
+	TEST_ASSERT_TRUE(buf->external_mod);
+	TEST_ASSERT_EQUAL_STRING("one", row_str(buf, 0));
+
+	unlink(path);
+	free(path);
+}
+
+/* Unsaved edits are not mixed with the file's growth. */
+void test_follow_dirty_buffer_is_flagged(void) {
+	char *path = make_temp_file("one\n");
+	struct buffer *buf = make_test_buffer(NULL);
+	TEST_ASSERT_EQUAL_INT(0, editorOpen(buf, path));
+	followMode();
+	rowInsertChar(buf, bufRow(buf, 0), 0, 'x');
+
+	append_to_file(path, "two\n");
+	checkNow();
+
+	TEST_ASSERT_TRUE(buf->external_mod);
+	TEST_ASSERT_EQUAL_INT(2, buf->numrows);
+
+	unlink(path);
+	free(path);
+}
+
 /* ---- the "no lock when external_mod set" rule ---- */
 
 void test_markdirty_skips_lock_when_externally_modified(void) {
@@ -109,8 +362,7 @@ void test_markdirty_skips_lock_when_externally_modified(void) {
 
 	/* External process modifies the file; flag lights up. */
 	bump_mtime(path, 10);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(buf->external_mod);
 
 	/* User now edits.  Without the guard, markBufferDirty would grab
@@ -300,8 +552,7 @@ void test_external_mod_persists_through_undo_to_clean(void) {
 	bump_mtime(path, 2);
 
 	/* Refresh notices the drift. */
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->external_mod);
 
 	/* User undoes all their edits back to clean.  This calls
@@ -358,8 +609,7 @@ void test_checkFileModified_reacquires_stale_lock(void) {
 
 	/* refreshScreen tick: checkFileModified re-probes, acquires
 	 * the now-available lock, and clears the warning. */
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->lock_fd >= 0);
 	TEST_ASSERT_EQUAL_INT(0, b->lock_blocked_pid);
 	TEST_ASSERT_FALSE(b->external_mod); /* no on-disk change */
@@ -395,8 +645,7 @@ void test_checkFileModified_does_not_reacquire_if_file_changed(void) {
 	release_and_reap(child, release_fd, ready_fd);
 	bump_mtime(path, 2);
 
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->external_mod);
 	TEST_ASSERT_EQUAL_INT(-1, b->lock_fd); /* did NOT acquire */
 	TEST_ASSERT_EQUAL_INT((int)child, b->lock_blocked_pid); /* unchanged */
@@ -428,8 +677,7 @@ void test_save_clears_external_mod(void) {
 
 	/* File changes on disk. */
 	bump_mtime(path, 2);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->external_mod);
 
 	/* Simulate save's post-write sequence. */
@@ -444,8 +692,7 @@ void test_save_clears_external_mod(void) {
 
 	/* Subsequent checkFileModified should not re-fire —
 	 * open_mtime now matches the file. */
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_FALSE(b->external_mod);
 
 	unlink(path);
@@ -464,8 +711,7 @@ void test_revert_clears_external_mod(void) {
 	TEST_ASSERT_EQUAL_INT(0, editorOpen(b, path));
 
 	bump_mtime(path, 2);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->external_mod);
 
 	/* Simulate revert: open a fresh buffer on the same file. */
@@ -506,8 +752,7 @@ void test_open_mtime_survives_clean_transition(void) {
 
 	/* ...and detection must still work. */
 	bump_mtime(path, 2);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	TEST_ASSERT_TRUE(b->external_mod);
 
 	unlink(path);
@@ -539,8 +784,7 @@ void test_readonly_lifted_when_lock_released(void) {
 	 * rather than acquiring: the lock is held only while there
 	 * are unsaved changes. */
 	release_and_reap(child, release_fd, ready_fd);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 
 	TEST_ASSERT_EQUAL_INT(0, b->lock_blocked_pid);
 	TEST_ASSERT_FALSE(b->read_only);
@@ -573,8 +817,7 @@ void test_user_readonly_not_lifted_by_lock_release(void) {
 	b->read_only_by_lock = 0;
 
 	release_and_reap(child, release_fd, ready_fd);
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 
 	TEST_ASSERT_EQUAL_INT(0, b->lock_blocked_pid);
 	TEST_ASSERT_TRUE(b->read_only); /* still the user's choice */
@@ -594,8 +837,7 @@ void test_special_buffer_is_not_checked(void) {
 	b->open_mtime = 1;
 	b->lock_blocked_pid = 4242;
 
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 
 	TEST_ASSERT_FALSE(b->external_mod);
 	TEST_ASSERT_EQUAL_INT(4242, b->lock_blocked_pid);
@@ -970,8 +1212,7 @@ void test_lock_poll_probe_keeps_other_buffers_lock(void) {
 	TEST_ASSERT_FALSE(other->dirty); /* so the poll probes, not locks */
 
 	E.buf = other;
-	resetThrottle();
-	checkFileModified();
+	checkNow();
 	E.buf = buf;
 
 	TEST_ASSERT_TRUE(buf->lock_fd >= 0); /* emil's belief... */
@@ -1044,6 +1285,17 @@ int main(void) {
 
 	RUN_TEST(test_external_mod_not_set_before_change);
 	RUN_TEST(test_external_mod_set_on_mtime_change);
+	RUN_TEST(test_watcher_flags_unfocused_buffer);
+	RUN_TEST(test_watcher_ignores_own_save);
+	RUN_TEST(test_watcher_follows_symlink);
+	RUN_TEST(test_watcher_ignores_other_files);
+	RUN_TEST(test_watched_buffer_is_polled);
+	RUN_TEST(test_unwatched_buffer_is_polled);
+	RUN_TEST(test_follow_appends_growth);
+	RUN_TEST(test_follow_completes_unfinished_line);
+	RUN_TEST(test_follow_keeps_split_utf8_whole);
+	RUN_TEST(test_follow_stops_when_truncated);
+	RUN_TEST(test_follow_dirty_buffer_is_flagged);
 
 	RUN_TEST(test_markdirty_skips_lock_when_externally_modified);
 	RUN_TEST(test_markdirty_normal_path_still_locks);
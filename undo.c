@@ -10,6 +10,7 @@
 #include "region.h"
 #include "unicode.h"
 #include "util.h"
+#include "wrap.h"
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -33,7 +34,7 @@ void computeInsertEnd(const uint8_t *text, int len, int startx, int starty,
 /* Perform the row-array mutation for an insert at (startx, starty).
  * Takes an ALREADY-ANCHORED position and payload, and does NOT adjust
  * tracked points — bulkInsert does that on the logical range.  Uses
- * direct memmove/memcpy and insertRow, no character-at-a-time
+ * direct memmove/memcpy and insertRows, no character-at-a-time
  * primitives.  Does NOT record undo. */
 static void bulkInsertRaw(struct buffer *buf, int startx, int starty,
 			  const uint8_t *data, int datalen) {
@@ -51,84 +52,52 @@ static void bulkInsertRaw(struct buffer *buf, int startx, int starty,
 
 	if (first_nl == NULL) {
 		/* Single-line insert: memmove tail right, memcpy data in */
-		struct erow *row = &buf->row[starty];
+		struct erow *row = bufRow(buf, starty);
 		int needed = row->size + datalen + 1;
 		rowEnsureCap(row, needed);
 		memmove(&row->chars[startx + datalen], &row->chars[startx],
 			row->size - startx + 1); /* +1 for NUL */
 		memcpy(&row->chars[startx], data, datalen);
 		row->size += datalen;
-		row->cached_width = -1;
+		bufRowResized(buf, row, datalen);
+		invalidateRowCacheFrom(row, startx);
 		markBufferDirty(buf);
 		return;
 	}
 
 	/* Multi-line insert.  Strategy:
-	 *   1. Save the suffix of the start row (bytes after startx).
-	 *   2. Truncate the start row at startx.
-	 *   3. Append the first line fragment from data to the start row.
-	 *   4. Insert complete interior lines as new rows.
-	 *   5. Insert the last line fragment + saved suffix as a new row. */
-
-	struct erow *row = &buf->row[starty];
-
-	/* Save suffix */
+	 *   1. Insert every line after the first as new rows below the
+	 *      start row, in one insertRows() call.
+	 *   2. Move the suffix of the start row (bytes after startx) onto
+	 *      the end of the last new row.
+	 *   3. Truncate the start row at startx and append the first
+	 *      line fragment from data.
+	 * One gap move for the whole paste, so its cost is the rows moved
+	 * plus the bytes, not a memmove of the row array per line. */
+	const uint8_t *rest = first_nl + 1;
+	int nrows = insertRows(buf, starty + 1, rest, data + datalen - rest);
+
+	struct erow *row = bufRow(buf, starty);
+	struct erow *last = bufRow(buf, starty + nrows);
 	int suffix_len = row->size - startx;
-	uint8_t *suffix = NULL;
 	if (suffix_len > 0) {
-		suffix = xmalloc(suffix_len);
-		memcpy(suffix, &row->chars[startx], suffix_len);
+		rowEnsureCap(last, last->size + suffix_len + 1);
+		memcpy(&last->chars[last->size], &row->chars[startx],
+		       suffix_len);
+		last->size += suffix_len;
+		last->chars[last->size] = '\0';
+		bufRowResized(buf, last, suffix_len);
 	}
 
-	/* Truncate start row at startx, then append first fragment */
 	int first_frag_len = (int)(first_nl - data);
 	int new_size = startx + first_frag_len;
-	row->chars = xrealloc(row->chars, new_size + 1);
-	row->charcap = new_size + 1;
+	rowEnsureCap(row, new_size + 1);
 	if (first_frag_len > 0)
 		memcpy(&row->chars[startx], data, first_frag_len);
+	bufRowResized(buf, row, new_size - row->size);
 	row->size = new_size;
 	row->chars[row->size] = '\0';
-	row->cached_width = -1;
-
-	/* Walk remaining data, inserting interior and final lines */
-	int insert_at = starty + 1;
-	const uint8_t *p = first_nl + 1; /* skip past first '\n' */
-	const uint8_t *end = data + datalen;
-
-	while (p < end) {
-		const uint8_t *nl = memchr(p, '\n', end - p);
-		if (nl == NULL) {
-			/* Last fragment — combine with saved suffix */
-			int last_frag_len = (int)(end - p);
-			int combined_len = last_frag_len + suffix_len;
-			uint8_t *combined = xmalloc(combined_len + 1);
-			memcpy(combined, p, last_frag_len);
-			if (suffix_len > 0)
-				memcpy(&combined[last_frag_len], suffix,
-				       suffix_len);
-			combined[combined_len] = '\0';
-			insertRow(buf, insert_at, combined, combined_len);
-			free(combined);
-			free(suffix);
-			markBufferDirty(buf);
-			return;
-		}
-		/* Interior complete line */
-		int line_len = (int)(nl - p);
-		insertRow(buf, insert_at, p, line_len);
-		insert_at++;
-		p = nl + 1;
-	}
-
-	/* If data ended with '\n', we still need to insert the suffix
-	 * as a new row */
-	if (suffix_len > 0) {
-		insertRow(buf, insert_at, suffix, suffix_len);
-	} else {
-		insertRow(buf, insert_at, (const uint8_t *)"", 0);
-	}
-	free(suffix);
+	invalidateRowCacheFrom(row, startx);
 	markBufferDirty(buf);
 }
 
@@ -162,7 +131,7 @@ void bulkInsert(struct buffer *buf, int startx, int starty, const uint8_t *data,
 }
 
 /* Bulk-delete text from (startx, starty) to (endx, endy).
- * Uses direct memmove/memcpy and delRow — no character-at-a-time
+ * Uses direct memmove/memcpy and delRows — no character-at-a-time
  * primitives.  Does NOT record undo.  Calls adjustAllPoints. */
 void bulkDelete(struct buffer *buf, int startx, int starty, int endx,
 		int endy) {
@@ -175,10 +144,10 @@ void bulkDelete(struct buffer *buf, int startx, int starty, int endx,
 	 * row->size - endx negative and hand memmove a huge size_t. */
 	if (endy >= buf->numrows)
 		endy = buf->numrows - 1;
-	if (startx > buf->row[starty].size)
-		startx = buf->row[starty].size;
-	if (endx > buf->row[endy].size)
-		endx = buf->row[endy].size;
+	if (startx > bufRow(buf, starty)->size)
+		startx = bufRow(buf, starty)->size;
+	if (endx > bufRow(buf, endy)->size)
+		endx = bufRow(buf, endy)->size;
 	if (starty == endy && endx < startx)
 		endx = startx;
 
@@ -187,36 +156,28 @@ void bulkDelete(struct buffer *buf, int startx, int starty, int endx,
 
 	if (starty == endy) {
 		/* Single-row deletion */
-		struct erow *row = &buf->row[starty];
+		struct erow *row = bufRow(buf, starty);
 		memmove(&row->chars[startx], &row->chars[endx],
 			row->size - endx + 1); /* +1 for NUL */
 		row->size -= endx - startx;
-		row->cached_width = -1;
+		bufRowResized(buf, row, startx - endx);
+		invalidateRowCacheFrom(row, startx);
 		markBufferDirty(buf);
 	} else {
-		/* Multi-row deletion:
-		 *   1. Delete interior rows (between starty and endy).
-		 *   2. Merge start row prefix with end row suffix. */
-		int rows_to_del = endy - starty - 1;
-		for (int i = 0; i < rows_to_del; i++)
-			delRow(buf, starty + 1);
-
-		/* After deleting interior rows, the end row is now at
-		 * starty + 1 */
-		if (starty + 1 >= buf->numrows)
-			return;
-
-		struct erow *first = &buf->row[starty];
-		struct erow *last = &buf->row[starty + 1];
+		/* Multi-row deletion: join the start row's prefix to the
+		 * end row's suffix, then drop rows starty+1..endy in one
+		 * delRows() call. */
+		struct erow *first = bufRow(buf, starty);
+		struct erow *last = bufRow(buf, endy);
 		int new_size = startx + (last->size - endx);
-		first->chars = xrealloc(first->chars, new_size + 1);
-		first->charcap = new_size + 1;
+		rowEnsureCap(first, new_size + 1);
 		memcpy(&first->chars[startx], &last->chars[endx],
 		       last->size - endx);
+		bufRowResized(buf, first, new_size - first->size);
 		first->size = new_size;
 		first->chars[first->size] = '\0';
-		first->cached_width = -1;
-		delRow(buf, starty + 1);
+		invalidateRowCacheFrom(first, startx);
+		delRows(buf, starty + 1, endy - starty);
 		markBufferDirty(buf);
 	}
 }
@@ -241,7 +202,9 @@ static void undoStep(struct buffer *buf, int redo) {
 		buf->cy = node->endy;
 	}
 
-	updateBuffer(buf);
+	/* No updateBuffer() here: bulkInsert and bulkDelete invalidate
+	 * the width of every row they touch, and a whole-buffer reset
+	 * would make each undo step cost every row in the file. */
 
 	/* Move node from src-list head to dst-list head */
 	struct undo *prev_dst = *dst;
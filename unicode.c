@@ -11,6 +11,14 @@
 #include "unicode.h"
 #include "emil.h"
 
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define EMIL_SCAN_SSE2
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EMIL_SCAN_NEON
+#endif
+
 /* Decode the UTF-8 character at str[idx] and return its Unicode codepoint. */
 uint32_t utf8Decode(const uint8_t *str, int idx) {
 	/* Each continuation byte is verified before the byte after it
@@ -248,6 +256,45 @@ int utf8_validate(const uint8_t *buf, int len) {
 	return 1;
 }
 
+/* The first byte in [p, end) that is not printable ASCII (0x20-0x7e),
+ * or end.  Bytes in that range each take one column and need no
+ * validation, which makes them the bulk of any source file or log,
+ * so the load scanner skips them here 16 at a time and handles only
+ * the stops -- newline, NUL, tab, controls and UTF-8 lead bytes --
+ * one by one.  SSE2 and AArch64 NEON are baseline on their targets;
+ * other builds take the scalar loop, which is also the tail. */
+const uint8_t *utf8_skipPrintable(const uint8_t *p, const uint8_t *end) {
+#if defined(EMIL_SCAN_SSE2)
+	const __m128i space = _mm_set1_epi8(0x20);
+	const __m128i del = _mm_set1_epi8(0x7f);
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const void *)p);
+		/* The compare is signed, so bytes >= 0x80 count as below
+		 * space along with the controls. */
+		__m128i stop = _mm_or_si128(_mm_cmplt_epi8(v, space),
+					    _mm_cmpeq_epi8(v, del));
+		int mask = _mm_movemask_epi8(stop);
+		if (mask)
+			return p + __builtin_ctz((unsigned)mask);
+		p += 16;
+	}
+#elif defined(EMIL_SCAN_NEON)
+	const uint8x16_t space = vdupq_n_u8(0x20);
+	const uint8x16_t del = vdupq_n_u8(0x7f);
+	while (end - p >= 16) {
+		uint8x16_t v = vld1q_u8(p);
+		uint8x16_t stop = vorrq_u8(vcltq_u8(v, space),
+					   vcgeq_u8(v, del));
+		if (vmaxvq_u8(stop))
+			break; /* the scalar loop finds which byte */
+		p += 16;
+	}
+#endif
+	while (p < end && *p >= 0x20 && *p < 0x7f)
+		p++;
+	return p;
+}
+
 int nextScreenX(uint8_t *str, int *idx, int screen_x) {
 	uint8_t ch = str[*idx];
 
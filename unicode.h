@@ -29,6 +29,8 @@ int isIndicSentenceTerminator(uint32_t cp);
 
 int utf8_validate(const uint8_t *buf, int len);
 
+const uint8_t *utf8_skipPrintable(const uint8_t *p, const uint8_t *end);
+
 int nextScreenX(uint8_t *str, int *idx, int screen_x);
 
 int utf8_snapToBoundary(const uint8_t *chars, int size, int cx, int dir);
@@ -167,9 +167,9 @@ size_t emil_strlcat(char *dst, const char *src, size_t dsize) {
  *
  * A blocking tty write is not all-or-nothing.  Once the terminal's
  * buffer is full the write sleeps, and a signal delivered while it
- * sleeps makes it return the count transferred so far -- emil installs
- * no handler with SA_RESTART, so SIGWINCH, SIGCONT and the file-check
- * SIGALRM all do this.  Measured on Linux/glibc, x86-64: a write of
+ * sleeps makes it return the count transferred so far -- only emil's
+ * SIGCHLD handler has SA_RESTART, so SIGWINCH, SIGCONT and the
+ * file-check SIGALRM all do this.  Measured on Linux/glibc, x86-64: a write of
  * more than a pty's 10240-byte buffer with the reader stalled returns
  * exactly 10240 when a SIGWINCH lands, and blocks indefinitely rather
  * than returning short when no signal does -- so the signal is the
@@ -0,0 +1,471 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+/* view.c: read-only views of files too large to load.
+ *
+ * A view buffer is an ordinary buffer whose rows hold a window of the
+ * file's lines -- at most VIEW_WINDOW_LINES of them and about
+ * VIEW_WINDOW_BYTES of text -- starting at file line view->first.
+ * Everything that draws or moves through rows works unchanged on the
+ * window; what is view-specific is moving the window:
+ *
+ *   - viewSettle() re-centres it before each frame once the cursor
+ *     nears an edge, so scrolling never reaches the end of the rows
+ *     before the end of the file.
+ *   - viewShow() brings an arbitrary file line into it, for goto-line,
+ *     M-< and M->.
+ *   - viewStep() moves it to the adjoining window, so a search can
+ *     carry on through the file.
+ *
+ * Finding a line is the sparse index's job: marks[k] is the byte
+ * offset of line k * VIEW_MARK_LINES, filled in by scanning forward
+ * only as far as a request has needed.  A line is then at most
+ * VIEW_MARK_LINES newlines past a mark.  The index costs 8 bytes per
+ * VIEW_MARK_LINES lines; everything else is bounded by the window.
+ *
+ * Rows must be NUL-free UTF-8 (see buffer.h), and a log need not be:
+ * NULs and invalid bytes show as '?'.  A line longer than
+ * VIEW_LINE_MAX shows only its head.  Neither matters to a read-only
+ * buffer, which can never write the substitution back.
+ */
+
+#include "view.h"
+#include "buffer.h"
+#include "display.h"
+#include "emil.h"
+#include "unicode.h"
+#include "util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define VIEW_WINDOW_LINES 10000
+#define VIEW_WINDOW_BYTES (8 * 1024 * 1024)
+#define VIEW_LINE_MAX (1024 * 1024)
+#define VIEW_MARK_LINES 1024
+#define VIEW_SCAN_CHUNK (1024 * 1024)
+#define VIEW_PARKED (MARK_RING_SIZE + 1) /* the mark and its ring */
+
+struct fileView {
+	int fd;
+	off_t size;
+	long long first;  /* file line shown in row 0 */
+	off_t first_off;  /* its byte offset */
+	int at_eof;	  /* the window holds the file's last line */
+	long long lines;  /* lines in the file, or -1 until the scan
+			   * reaches the end */
+	off_t *marks;	  /* marks[k]: offset of line k * VIEW_MARK_LINES */
+	long long nmarks;
+	long long markcap;
+	long long scan_line; /* the index scan has reached line */
+	off_t scan_off;	     /* scan_line, at this offset */
+	uint8_t *chunk;	     /* VIEW_SCAN_CHUNK bytes of scratch */
+	long long parked[VIEW_PARKED]; /* file lines of parked marks */
+};
+
+/* pread() until len bytes or end of file.  Returns the count, or -1. */
+static ssize_t preadFull(int fd, uint8_t *p, size_t len, off_t off) {
+	size_t got = 0;
+	while (got < len) {
+		ssize_t n = pread(fd, p + got, len - got, off + (off_t)got);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			return -1;
+		if (n == 0)
+			break;
+		got += (size_t)n;
+	}
+	return (ssize_t)got;
+}
+
+static void addMark(struct fileView *v, off_t off) {
+	if (v->nmarks == v->markcap) {
+		v->markcap = v->markcap ? v->markcap * 2 : 64;
+		v->marks = xrealloc(v->marks,
+				    (size_t)v->markcap * sizeof(*v->marks));
+	}
+	v->marks[v->nmarks++] = off;
+}
+
+/* Carry the index scan on until it has reached line 'want', or to the
+ * end of the file, at which point the line count becomes known. */
+static void extendIndex(struct fileView *v, long long want) {
+	while (v->lines < 0 && v->scan_line < want) {
+		ssize_t n = preadFull(v->fd, v->chunk, VIEW_SCAN_CHUNK,
+				      v->scan_off);
+		if (n <= 0) {
+			/* The tail after the last newline is a line,
+			 * even when empty. */
+			v->lines = v->scan_line + 1;
+			return;
+		}
+		uint8_t *p = v->chunk;
+		uint8_t *end = v->chunk + n;
+		uint8_t *nl;
+		while ((nl = memchr(p, '\n', end - p)) != NULL) {
+			p = nl + 1;
+			off_t start = v->scan_off + (off_t)(p - v->chunk);
+			if (++v->scan_line % VIEW_MARK_LINES == 0)
+				addMark(v, start);
+			if (v->scan_line == want) {
+				v->scan_off = start;
+				return;
+			}
+		}
+		v->scan_off += n;
+	}
+}
+
+/* Byte offset of file line *line, which is first clamped to the
+ * file. */
+static off_t seekLine(struct fileView *v, long long *line) {
+	if (*line < 0)
+		*line = 0;
+	extendIndex(v, *line);
+	if (v->lines >= 0 && *line >= v->lines)
+		*line = v->lines - 1;
+
+	long long k = *line / VIEW_MARK_LINES;
+	long long at = k * VIEW_MARK_LINES;
+	off_t off = v->marks[k];
+	while (at < *line) {
+		ssize_t n = preadFull(v->fd, v->chunk, VIEW_SCAN_CHUNK, off);
+		if (n <= 0)
+			break;
+		uint8_t *p = v->chunk;
+		uint8_t *end = v->chunk + n;
+		uint8_t *nl;
+		while (at < *line && (nl = memchr(p, '\n', end - p)) != NULL) {
+			at++;
+			p = nl + 1;
+		}
+		off += (at == *line) ? (off_t)(p - v->chunk) : n;
+	}
+	return off;
+}
+
+/* Offset just past the newline ending the line that runs through
+ * 'off', or -1 if that line is the file's last. */
+static off_t lineEnd(struct fileView *v, off_t off) {
+	for (;;) {
+		ssize_t n = preadFull(v->fd, v->chunk, VIEW_SCAN_CHUNK, off);
+		if (n <= 0)
+			return -1;
+		uint8_t *nl = memchr(v->chunk, '\n', n);
+		if (nl)
+			return off + (off_t)(nl - v->chunk) + 1;
+		off += n;
+	}
+}
+
+/* NULs and bytes that do not form valid UTF-8 become '?'. */
+static void sanitize(uint8_t *p, size_t len) {
+	size_t i = 0;
+	while (i < len) {
+		if (p[i] < 0x80) {
+			if (p[i] == '\0')
+				p[i] = '?';
+			i++;
+			continue;
+		}
+		size_t n = (size_t)utf8_nBytes(p[i]);
+		if (n > 1 && i + n <= len && utf8_validate(p + i, (int)n)) {
+			i += n;
+		} else {
+			p[i] = '?';
+			i++;
+		}
+	}
+}
+
+static void appendViewRow(struct buffer *buf, uint8_t *p, size_t len) {
+	if (len > 0 && p[len - 1] == '\r')
+		len--;
+	if (len > VIEW_LINE_MAX)
+		len = VIEW_LINE_MAX;
+	sanitize(p, len);
+	appendRowRaw(buf, p, len);
+}
+
+static int clampRow(const struct buffer *buf, long long row) {
+	if (row < 0)
+		return 0;
+	if (row > buf->numrows - 1)
+		return buf->numrows - 1;
+	return (int)row;
+}
+
+/* A mark on a line the window has moved off is parked: its row
+ * becomes -2 - k, and parked[k] holds the line.  Every use of a mark
+ * takes a negative row for no mark, so a parked one lies idle until
+ * the window holds its line again.  Returns the row to store. */
+static int parkMark(struct buffer *buf, long long line) {
+	for (int k = 0; k < VIEW_PARKED; k++) {
+		int used = buf->marky == -2 - k;
+		for (int i = 0; i < buf->mark_ring_len; i++)
+			used |= buf->mark_ring[i].cy == -2 - k;
+		if (!used) {
+			buf->view->parked[k] = line;
+			return -2 - k;
+		}
+	}
+	return -1; /* not reached: a slot for each mark */
+}
+
+/* Carry the mark at (*cx, *cy) from a window that started at file
+ * line 'old_first' to the current one.  No mark (-1) stays none. */
+static void shiftMark(struct buffer *buf, long long old_first, int *cx,
+		      int *cy) {
+	struct fileView *v = buf->view;
+	if (*cy == -1)
+		return;
+	long long line = *cy >= 0 ? old_first + *cy : v->parked[-2 - *cy];
+	if (line >= v->first && line < v->first + buf->numrows) {
+		*cy = (int)(line - v->first);
+		if (*cx > bufRow(buf, *cy)->size)
+			*cx = bufRow(buf, *cy)->size;
+	} else if (*cy >= 0) {
+		*cy = parkMark(buf, line);
+	}
+}
+
+/* The rows used to start at file line 'old_first': move every row
+ * index held on the buffer's behalf to match. */
+static void shiftRows(struct buffer *buf, long long old_first) {
+	long long delta = buf->view->first - old_first;
+	buf->cy = clampRow(buf, buf->cy - delta);
+	if (buf->cx > bufRow(buf, buf->cy)->size)
+		buf->cx = bufRow(buf, buf->cy)->size;
+	shiftMark(buf, old_first, &buf->markx, &buf->marky);
+	for (int i = 0; i < buf->mark_ring_len; i++)
+		shiftMark(buf, old_first, &buf->mark_ring[i].cx,
+			  &buf->mark_ring[i].cy);
+	for (int i = 0; i < E.nwindows; i++) {
+		struct window *w = E.windows[i];
+		if (w->buf != buf)
+			continue;
+		w->rowoff = clampRow(buf, w->rowoff - delta);
+		w->skip_sublines = 0;
+		w->cy = clampRow(buf, w->cy - delta);
+		if (w->cx > bufRow(buf, w->cy)->size)
+			w->cx = bufRow(buf, w->cy)->size;
+	}
+}
+
+/* Replace the rows with the window starting at file line 'start'. */
+static void loadWindow(struct buffer *buf, long long start) {
+	struct fileView *v = buf->view;
+	long long old_first = v->first;
+	off_t off = seekLine(v, &start);
+	uint8_t *data = xmalloc(VIEW_WINDOW_BYTES);
+	size_t kept = 0;
+
+	bufferResetRows(buf);
+	v->first = start;
+	v->first_off = off;
+	v->at_eof = 0;
+
+	while (buf->numrows < VIEW_WINDOW_LINES && kept < VIEW_WINDOW_BYTES) {
+		size_t want = VIEW_WINDOW_BYTES - kept;
+		ssize_t n = preadFull(v->fd, data, want, off);
+		if (n < 0)
+			break;
+		int eof = (size_t)n < want;
+		uint8_t *p = data;
+		uint8_t *end = data + n;
+		uint8_t *nl;
+		while (buf->numrows < VIEW_WINDOW_LINES &&
+		       (nl = memchr(p, '\n', end - p)) != NULL) {
+			appendViewRow(buf, p, (size_t)(nl - p));
+			p = nl + 1;
+		}
+		if (buf->numrows == VIEW_WINDOW_LINES)
+			break;
+		if (eof) {
+			appendViewRow(buf, p, (size_t)(end - p));
+			v->at_eof = 1;
+			break;
+		}
+		if (p > data || buf->numrows >= 2)
+			break; /* the rest is a line for the next window */
+
+		/* One line fills what is left: show its head and carry on
+		 * after it, so the window always holds a next line to
+		 * move to. */
+		appendViewRow(buf, p, (size_t)(end - p));
+		kept += VIEW_LINE_MAX;
+		off = lineEnd(v, off + n);
+		if (off < 0) {
+			v->at_eof = 1;
+			break;
+		}
+	}
+	free(data);
+	if (buf->numrows == 0)
+		appendRowRaw(buf, (const uint8_t *)"", 0);
+	if (v->at_eof && v->lines < 0)
+		v->lines = v->first + buf->numrows;
+
+	shiftRows(buf, old_first);
+}
+
+/* Load a window holding file line 'line' with up to 'before' lines
+ * above it and at least one below, unless it is the last.  Long lines
+ * can stop a window short of that; then the window starts nearer to
+ * 'line' until it fits. */
+static void loadAround(struct buffer *buf, long long line, long long before) {
+	struct fileView *v = buf->view;
+	for (;;) {
+		if (v->lines >= 0 && line >= v->lines)
+			line = v->lines - 1;
+		loadWindow(buf, line - before < 0 ? 0 : line - before);
+		if (v->lines >= 0 && line >= v->lines)
+			continue; /* past the end, which is now known */
+		if (line < v->first + buf->numrows - 1 || v->at_eof ||
+		    before == 0)
+			return;
+		before /= 2;
+	}
+}
+
+int viewOpen(struct buffer *buf, const char *iopath) {
+	int fd = open(iopath, O_RDONLY);
+	struct stat st;
+	if (fd == -1 || fstat(fd, &st) == -1) {
+		setStatusMessage("Can't open file: %s", strerror(errno));
+		if (fd != -1)
+			close(fd);
+		return -1;
+	}
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	struct fileView *v = xmalloc(sizeof(*v));
+	memset(v, 0, sizeof(*v));
+	v->fd = fd;
+	v->size = st.st_size;
+	v->lines = -1;
+	v->chunk = xmalloc(VIEW_SCAN_CHUNK);
+	addMark(v, 0);
+
+	viewClose(buf);
+	buf->view = v;
+	buf->read_only = 1;
+	buf->open_mtime = st.st_mtime;
+	buf->open_size = st.st_size;
+	loadWindow(buf, 0);
+	buf->cx = 0;
+	buf->cy = 0;
+
+	setStatusMessage("%lld MB: too large to load; viewing read-only",
+			 (long long)(st.st_size / (1024 * 1024)));
+	return 0;
+}
+
+void viewClose(struct buffer *buf) {
+	struct fileView *v = buf->view;
+	if (v == NULL)
+		return;
+	close(v->fd);
+	free(v->marks);
+	free(v->chunk);
+	free(v);
+	buf->view = NULL;
+}
+
+void viewSettle(struct buffer *buf) {
+	struct fileView *v = buf->view;
+	if (v == NULL)
+		return;
+	int margin = buf->numrows / 4;
+	if ((v->first > 0 && buf->cy < margin) ||
+	    (!v->at_eof && buf->cy >= buf->numrows - 1 - margin))
+		loadAround(buf, v->first + buf->cy, VIEW_WINDOW_LINES / 2);
+}
+
+/* The index scan carries on from where it stopped, so the new lines
+ * cost what they add; a reload is one window's read. */
+void viewGrow(struct buffer *buf, off_t size) {
+	struct fileView *v = buf->view;
+	if (v == NULL || size <= v->size)
+		return;
+	v->size = size;
+	v->lines = -1;
+	if (v->at_eof)
+		loadWindow(buf, v->first);
+}
+
+int viewAtEnd(const struct buffer *buf, int row) {
+	if (buf->view && !buf->view->at_eof)
+		return 0;
+	return row == buf->numrows - 1;
+}
+
+long long viewLine(const struct buffer *buf, int row) {
+	return buf->view ? buf->view->first + row : row;
+}
+
+int viewShow(struct buffer *buf, long long line) {
+	struct fileView *v = buf->view;
+	if (v == NULL)
+		return clampRow(buf, line);
+	if (line < 0)
+		line = 0;
+	if (line < v->first || line >= v->first + buf->numrows)
+		loadAround(buf, line, VIEW_WINDOW_LINES / 2);
+	return clampRow(buf, line - v->first);
+}
+
+long long viewFetchMark(struct buffer *buf) {
+	long long line = viewLine(buf, buf->cy);
+	if (buf->view && buf->marky < -1)
+		viewShow(buf, buf->view->parked[-2 - buf->marky]);
+	return line;
+}
+
+void viewSetMark(struct buffer *buf, int cx, long long line) {
+	struct fileView *v = buf->view;
+	buf->markx = cx;
+	buf->marky = -1;
+	if (v == NULL)
+		buf->marky = (int)line;
+	else if (line >= v->first && line < v->first + buf->numrows)
+		buf->marky = (int)(line - v->first);
+	else
+		buf->marky = parkMark(buf, line);
+}
+
+int viewStep(struct buffer *buf, int direction) {
+	struct fileView *v = buf->view;
+	if (v == NULL)
+		return -1;
+	if (direction > 0) {
+		if (v->at_eof)
+			return -1;
+		long long next = v->first + buf->numrows;
+		loadAround(buf, next, 0);
+		return clampRow(buf, next - v->first);
+	}
+	if (v->first == 0)
+		return -1;
+	long long prev = v->first - 1;
+	loadAround(buf, prev, VIEW_WINDOW_LINES - 2);
+	return clampRow(buf, prev - v->first);
+}
+
+void viewPosition(struct buffer *buf, int rowoff, char *out,
+		  size_t cap) {
+	const struct fileView *v = buf->view;
+	if (v->first == 0 && rowoff == 0) {
+		snprintf(out, cap, "Top");
+	} else if (v->at_eof && buf->end) {
+		snprintf(out, cap, "Bot");
+	} else {
+		off_t at = v->first_off + (off_t)bufOffset(buf, 0, rowoff);
+		snprintf(out, cap, "%2d%%",
+			 v->size > 0 ? (int)((at * 100LL) / v->size) : 0);
+	}
+}
@@ -0,0 +1,58 @@
+/* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
+#ifndef EMIL_VIEW_H
+#define EMIL_VIEW_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+struct buffer;
+
+/* A file line past any real one: viewShow() clamps it to the last. */
+#define VIEW_LAST_LINE LLONG_MAX
+
+/* Open iopath into buf as a read-only view: the rows hold a window of
+ * the file's lines, paged as the cursor moves.  For files too large
+ * to load.  Returns 0, or -1 with the status message set. */
+int viewOpen(struct buffer *buf, const char *iopath);
+void viewClose(struct buffer *buf);
+
+/* Re-centre the window once the cursor comes near an edge of it that
+ * is not an edge of the file.  Called before each frame. */
+void viewSettle(struct buffer *buf);
+
+/* The file has grown to 'size' bytes.  A window holding the old last
+ * line is reloaded to take in the new ones. */
+void viewGrow(struct buffer *buf, off_t size);
+
+/* Whether 'row' shows the file's last line. */
+int viewAtEnd(const struct buffer *buf, int row);
+
+/* File line (0-based) shown in row 'row'.  Plain buffers: row. */
+long long viewLine(const struct buffer *buf, int row);
+
+/* Row showing file line 'line', clamped to the file, moving a view's
+ * window to it when it is not loaded.  Plain buffers: the clamped
+ * row. */
+int viewShow(struct buffer *buf, long long line);
+
+/* Bring a mark the window has moved off back into it, for a command
+ * that goes to the mark.  Returns the file line point was on before,
+ * which the window may no longer hold. */
+long long viewFetchMark(struct buffer *buf);
+
+/* Set the mark to column 'cx' of file line 'line', which need not be
+ * in the window.  Plain buffers: line is the row. */
+void viewSetMark(struct buffer *buf, int cx, long long line);
+
+/* Load the window adjoining the current one in 'direction' (1 or -1).
+ * Returns the row of the first line not in the old window, or -1 at
+ * the end of the file. */
+int viewStep(struct buffer *buf, int direction);
+
+/* "Top", "Bot" or "NN%" for a window whose top row is 'rowoff',
+ * measured against the whole file. */
+void viewPosition(struct buffer *buf, int rowoff, char *out,
+		  size_t cap);
+
+#endif
@@ -1,6 +1,7 @@
 /* Copyright (c) 2021 chameleon, 2026 Nicholas Carroll.
  * SPDX-License-Identifier: MIT */
 #include "window.h"
+#include "buffer.h"
 #include "display.h"
 #include "emil.h"
 
@@ -30,8 +31,8 @@ void synchronizeBufferCursor(struct buffer *buf, struct window *win) {
 	if (win->cy >= buf->numrows) {
 		win->cy = buf->numrows - 1;
 	}
-	if (win->cy < buf->numrows && win->cx > buf->row[win->cy].size) {
-		win->cx = buf->row[win->cy].size;
+	if (win->cy < buf->numrows && win->cx > bufRow(buf, win->cy)->size) {
+		win->cx = bufRow(buf, win->cy)->size;
 	}
 
 	// Update the buffer's cursor position
@@ -1,25 +1,182 @@
 /* Copyright (c) 2026 Nicholas Carroll. SPDX-License-Identifier: MIT */
 #include "wrap.h"
+#include "buffer.h"
 #include "unicode.h"
 #include "util.h"
 #include <limits.h>
 #include <stdint.h>
+#include <stdlib.h>
 #ifdef EMIL_DEBUG_ROW_CACHE
 #include <stdio.h>
-#include <stdlib.h>
 #endif
 
-/* The whole-row walk, factored out so the cache-miss path and the
- * debug check below cannot drift apart. */
-static int walkLineWidth(erow *row) {
-	int screen_x = 0;
-	for (int i = 0; i < row->size;) {
+/* ---- Row caches ----
+ *
+ * Two things about a row are asked for again and again and are costly
+ * to work out from its text: where it breaks under word wrap, and the
+ * display column of a byte deep inside it.  Both live in one struct
+ * behind row->cache, allocated only for rows that need one.
+ *
+ * Wrap breaks.  Where each sub-line starts, for the width it was
+ * wrapped at.  A frame, a vertical motion and linesBack() ask the same
+ * rows for the same breaks; with them cached, each is a lookup rather
+ * than wordWrapBreak() calls from the row's first byte.  A different
+ * width is a miss and wraps the row again, so a resize invalidates
+ * lazily, a row at a time as rows are asked for.  A row that fits on
+ * one line gets no breaks at all: its width, itself cached, already
+ * says so.
+ *
+ * Column checkpoints.  In a row of COL_INDEX_MIN bytes or more --
+ * minified JSON, a single-line log -- every COL_CHECK_BYTES bytes
+ * records the column there, so a byte's column is a walk from the
+ * checkpoint before it, not from byte 0.  They are filled lazily, as
+ * far into the row as anyone has asked.  The sub-line at a checkpoint
+ * is not stored: it depends on the width, and a binary search of the
+ * wrap breaks (cursorScreenLine()) already finds it.
+ *
+ * An edit at byte `at` keeps whatever was worked out from the bytes
+ * before it: checkpoints at or before `at`, and breaks whose wrap read
+ * nothing from `at` on.  The rest of the row is redone on the next
+ * ask, from the last survivor. */
+
+#define COL_INDEX_MIN (64 * 1024)
+#define COL_CHECK_BYTES 4096
+
+struct rowCache {
+	/* Sub-line starts for wrap_cols, wrap_n of them; the wrap that
+	 * found wrap[i] read no byte at or past wrap_ext[i].  wrap_done
+	 * once the last sub-line is known. */
+	int wrap_cols;
+	int wrap_n, wrap_cap, wrap_done;
+	struct wrapPoint *wrap;
+	int *wrap_ext;
+	/* check[k] is the first character boundary at or after byte
+	 * k * COL_CHECK_BYTES, and its column. */
+	int ncheck, check_cap;
+	struct wrapPoint *check;
+};
+
+static const struct wrapPoint row_start = { 0, 0 };
+
+static struct rowCache *rowCache(erow *row) {
+	if (!row->cache)
+		row->cache = xcalloc(1, sizeof(struct rowCache));
+	return row->cache;
+}
+
+static void freeRowCache(erow *row) {
+	struct rowCache *c = row->cache;
+	if (!c)
+		return;
+	free(c->wrap);
+	free(c->wrap_ext);
+	free(c->check);
+	free(c);
+	row->cache = NULL;
+}
+
+void invalidateRowCache(erow *row) {
+	row->cached_width = -1;
+	freeRowCache(row);
+}
+
+void invalidateRowCacheFrom(erow *row, int at) {
+	struct rowCache *c = row->cache;
+	row->cached_width = -1;
+	if (!c)
+		return;
+	while (c->wrap_n > 1 && c->wrap_ext[c->wrap_n - 1] > at)
+		c->wrap_n--;
+	c->wrap_done = 0;
+	while (c->ncheck > 1 && c->check[c->ncheck - 1].byte > at)
+		c->ncheck--;
+}
+
+/* Walk from a known column to byte `to`. */
+static int walkColumns(erow *row, struct wrapPoint from, int to) {
+	int screen_x = from.col;
+	for (int i = from.byte; i < to && i < row->size; i++)
 		screen_x = nextScreenX(row->chars, &i, screen_x);
-		i++;
-	}
 	return screen_x;
 }
 
+/* Add the next checkpoint.  Returns 0 if the row ends first. */
+static int addCheckpoint(erow *row, struct rowCache *c) {
+	struct wrapPoint p = row_start;
+	if (c->ncheck > 0) {
+		p = c->check[c->ncheck - 1];
+		int target = c->ncheck * COL_CHECK_BYTES;
+		while (p.byte < target && p.byte < row->size) {
+			p.col = nextScreenX(row->chars, &p.byte, p.col);
+			p.byte++;
+		}
+		if (p.byte < target)
+			return 0;
+	}
+	if (c->ncheck == c->check_cap) {
+		c->check_cap = c->check_cap ? c->check_cap * 2 : 16;
+		c->check = xrealloc(c->check,
+				    c->check_cap * sizeof(struct wrapPoint));
+	}
+	c->check[c->ncheck++] = p;
+	return 1;
+}
+
+/* EMIL_DEBUG_ROW_CACHE walks from byte 0 on every lookup and aborts
+ * on a mismatch, as calculateLineWidth() does for the width. */
+static struct wrapPoint checkCheckpoint(erow *row, struct wrapPoint p) {
+#ifdef EMIL_DEBUG_ROW_CACHE
+	int fresh = walkColumns(row, row_start, p.byte);
+	if (fresh != p.col) {
+		fprintf(stderr,
+			"emil: stale column checkpoint at byte %d of a %d-byte "
+			"row: cached %d, actual %d\n",
+			p.byte, row->size, p.col, fresh);
+		abort();
+	}
+#else
+	(void)row;
+#endif
+	return p;
+}
+
+/* The last checkpoint at or before byte pos; row_start for a short
+ * row. */
+static struct wrapPoint checkpointAtByte(erow *row, int pos) {
+	if (row->size < COL_INDEX_MIN)
+		return row_start;
+	struct rowCache *c = rowCache(row);
+	int k = pos / COL_CHECK_BYTES;
+	while (c->ncheck <= k && addCheckpoint(row, c))
+		;
+	if (k >= c->ncheck)
+		k = c->ncheck - 1;
+	/* A character straddling k * COL_CHECK_BYTES pushes check[k]
+	 * past it, possibly past pos; check[k - 1] cannot be. */
+	if (c->check[k].byte > pos)
+		k--;
+	return checkCheckpoint(row, c->check[k]);
+}
+
+struct wrapPoint columnCheckpoint(erow *row, int col) {
+	if (row->size < COL_INDEX_MIN)
+		return row_start;
+	struct rowCache *c = rowCache(row);
+	if (c->ncheck == 0)
+		addCheckpoint(row, c);
+	while (c->check[c->ncheck - 1].col <= col && addCheckpoint(row, c))
+		;
+	int lo = 0, hi = c->ncheck - 1;
+	while (lo < hi) {
+		int mid = lo + (hi - lo + 1) / 2;
+		if (c->check[mid].col <= col)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return checkCheckpoint(row, c->check[lo]);
+}
+
 /* Total display width of a row, cached in row->cached_width.
  *
  * EMIL_DEBUG_ROW_CACHE recomputes on every cache hit and aborts on a
@@ -27,7 +184,7 @@ static int walkLineWidth(erow *row) {
 int calculateLineWidth(erow *row) {
 	if (row->cached_width >= 0) {
 #ifdef EMIL_DEBUG_ROW_CACHE
-		int fresh = walkLineWidth(row);
+		int fresh = walkColumns(row, row_start, row->size);
 		if (fresh != row->cached_width) {
 			fprintf(stderr,
 				"emil: stale cached_width on a %d-byte row: "
@@ -39,7 +196,8 @@ int calculateLineWidth(erow *row) {
 		return row->cached_width;
 	}
 
-	row->cached_width = walkLineWidth(row);
+	row->cached_width = walkColumns(
+		row, checkpointAtByte(row, row->size), row->size);
 	return row->cached_width;
 }
 
@@ -51,7 +209,9 @@ int calculateLineWidth(erow *row) {
  * O(row->size) walk while the cached answer sits unused.  The
  * frame computes this column once and passes it to the status bar
  * and the cursor placement, so the cache serves repeat frames on an
- * unedited row rather than repeat callers within one frame.*/
+ * unedited row rather than repeat callers within one frame.  Inside a
+ * long row the walk starts at the column checkpoint before char_pos,
+ * so it is at most COL_CHECK_BYTES however deep the cursor is.*/
 int charsToDisplayColumn(erow *row, int char_pos) {
 	if (!row || char_pos < 0)
 		return 0;
@@ -59,11 +219,7 @@ int charsToDisplayColumn(erow *row, int char_pos) {
 		return calculateLineWidth(row);
 	}
 
-	int col = 0;
-	for (int i = 0; i < char_pos && i < row->size; i++) {
-		col = nextScreenX(row->chars, &i, col);
-	}
-	return col;
+	return walkColumns(row, checkpointAtByte(row, char_pos), char_pos);
 }
 
 /* 行首禁则: a break must not be recorded when the character that
@@ -151,9 +307,14 @@ static int breakForbiddenAfter(erow *row, int bidx) {
  *
  * Returns 1 if more content follows the break (i.e. the row continues
  * onto another screen line), or 0 if the rest of the row fits on this
- * screen line (meaning this is the last sub-line). */
-int wordWrapBreak(erow *row, int screencols, int line_start_col,
-		  int line_start_byte, int *break_col, int *break_byte) {
+ * screen line (meaning this is the last sub-line).
+ *
+ * *scanned is where the scan stopped: no byte from *scanned + 4 on was
+ * read, a character being at most four bytes.  The wrap cache keeps a
+ * break across an edit that far along. */
+static int wrapScan(erow *row, int screencols, int line_start_col,
+		    int line_start_byte, int *break_col, int *break_byte,
+		    int *scanned) {
 	int col = line_start_col;
 	int bidx = line_start_byte;
 	int wb_col = -1;
@@ -209,6 +370,7 @@ int wordWrapBreak(erow *row, int screencols, int line_start_col,
 		col += cwidth;
 		bidx += utf8_nBytes(c);
 	}
+	*scanned = bidx;
 
 	if (bidx >= row->size) {
 		/* Rest of row fits on this screen line. */
@@ -236,28 +398,91 @@ int wordWrapBreak(erow *row, int screencols, int line_start_col,
 	return 1;
 }
 
+int wordWrapBreak(erow *row, int screencols, int line_start_col,
+		  int line_start_byte, int *break_col, int *break_byte) {
+	int scanned;
+	return wrapScan(row, screencols, line_start_col, line_start_byte,
+			break_col, break_byte, &scanned);
+}
+
+static void addBreak(struct rowCache *c, struct wrapPoint p, int ext) {
+	if (c->wrap_n == c->wrap_cap) {
+		c->wrap_cap = c->wrap_cap ? c->wrap_cap * 2 : 8;
+		c->wrap = xrealloc(c->wrap,
+				   c->wrap_cap * sizeof(struct wrapPoint));
+		c->wrap_ext = xrealloc(c->wrap_ext, c->wrap_cap * sizeof(int));
+	}
+	c->wrap[c->wrap_n] = p;
+	c->wrap_ext[c->wrap_n] = ext;
+	c->wrap_n++;
+}
+
+/* Wrap the rest of the row, from the last break known. */
+static void wrapFrom(erow *row, struct rowCache *c) {
+	struct wrapPoint p = c->wrap[c->wrap_n - 1];
+	while (p.byte < row->size) {
+		int bc, bb, scanned;
+		if (!wrapScan(row, c->wrap_cols, p.col, p.byte, &bc, &bb,
+			      &scanned) ||
+		    bb >= row->size)
+			break;
+		p.col = bc;
+		p.byte = bb;
+		addBreak(c, p, scanned + 4);
+	}
+	c->wrap_done = 1;
+}
+
+/* EMIL_DEBUG_ROW_CACHE re-wraps the row on every call and aborts on a
+ * mismatch, as calculateLineWidth() does for the width. */
+int rowBreaks(erow *row, int screencols, const struct wrapPoint **at) {
+	struct rowCache *c = row->cache;
+	if (!c || c->wrap_n == 0 || c->wrap_cols != screencols) {
+		if (c)
+			c->wrap_n = 0;
+		if (calculateLineWidth(row) <= screencols) {
+			if (c && c->ncheck == 0)
+				freeRowCache(row);
+			*at = &row_start;
+			return 1;
+		}
+		c = rowCache(row);
+		c->wrap_cols = screencols;
+		addBreak(c, row_start, 0);
+		c->wrap_done = 0;
+	}
+	if (!c->wrap_done)
+		wrapFrom(row, c);
+
+#ifdef EMIL_DEBUG_ROW_CACHE
+	struct rowCache fresh = { .wrap_cols = screencols };
+	addBreak(&fresh, row_start, 0);
+	wrapFrom(row, &fresh);
+	int same = fresh.wrap_n == c->wrap_n;
+	for (int i = 0; same && i < c->wrap_n; i++)
+		same = fresh.wrap[i].col == c->wrap[i].col &&
+		       fresh.wrap[i].byte == c->wrap[i].byte;
+	if (!same) {
+		fprintf(stderr,
+			"emil: stale wrap breaks on a %d-byte row: "
+			"cached %d sub-lines, actual %d\n",
+			row->size, c->wrap_n, fresh.wrap_n);
+		abort();
+	}
+	free(fresh.wrap);
+	free(fresh.wrap_ext);
+#endif
+	*at = c->wrap;
+	return c->wrap_n;
+}
+
 /* Count how many screen lines a row occupies under word wrap. */
 int countScreenLines(erow *row, int screencols) {
 	if (screencols <= 0 || row->size == 0)
 		return 1;
 
-	int lines = 0;
-	int line_start_col = 0;
-	int line_start_byte = 0;
-
-	do {
-		int break_col, break_byte;
-		int more = wordWrapBreak(row, screencols, line_start_col,
-					 line_start_byte, &break_col,
-					 &break_byte);
-		lines++;
-		if (!more)
-			break;
-		line_start_col = break_col;
-		line_start_byte = break_byte;
-	} while (line_start_byte < row->size);
-
-	return lines;
+	const struct wrapPoint *at;
+	return rowBreaks(row, screencols, &at);
 }
 
 void screenWalkStart(struct screenWalk *w, struct buffer *buf, int screencols,
@@ -274,27 +499,23 @@ void screenWalkStart(struct screenWalk *w, struct buffer *buf, int screencols,
 	if (!buf->word_wrap || subline <= 0)
 		return;
 
-	erow *r = &buf->row[w->row];
-	while (w->subline < subline) {
-		int bc, bb;
-		if (!wordWrapBreak(r, screencols, w->col, w->byte, &bc, &bb))
-			break; /* subline past the last: clamp */
-		w->subline++;
-		w->col = bc;
-		w->byte = bb;
-	}
+	const struct wrapPoint *at;
+	int n = rowBreaks(bufRow(buf, w->row), screencols, &at);
+	w->subline = subline < n ? subline : n - 1;
+	w->col = at[w->subline].col;
+	w->byte = at[w->subline].byte;
 }
 
 int screenWalkNext(struct screenWalk *w) {
 	struct buffer *buf = w->buf;
 
 	if (buf->word_wrap) {
-		int bc, bb;
-		if (wordWrapBreak(&buf->row[w->row], w->screencols, w->col,
-				  w->byte, &bc, &bb)) {
+		const struct wrapPoint *at;
+		int n = rowBreaks(bufRow(buf, w->row), w->screencols, &at);
+		if (w->subline + 1 < n) {
 			w->subline++;
-			w->col = bc;
-			w->byte = bb;
+			w->col = at[w->subline].col;
+			w->byte = at[w->subline].byte;
 			return 1;
 		}
 	}
@@ -322,28 +543,19 @@ void cursorScreenLine(erow *row, int cursor_col, int screencols, int *out_line,
 		return;
 	}
 
-	int line_start_col = 0;
-	int line_start_byte = 0;
-
-	while (line_start_byte < row->size) {
-		int break_col, break_byte;
-		int more = wordWrapBreak(row, screencols, line_start_col,
-					 line_start_byte, &break_col,
-					 &break_byte);
-
-		/* cursor_col falls within this screen line */
-		if (cursor_col < break_col || !more) {
-			*out_col = cursor_col - line_start_col;
-			return;
-		}
-
-		(*out_line)++;
-		line_start_col = break_col;
-		line_start_byte = break_byte;
+	/* The last sub-line starting at or before cursor_col: a cursor
+	 * at a break belongs to the sub-line that starts there. */
+	const struct wrapPoint *at;
+	int lo = 0, hi = rowBreaks(row, screencols, &at) - 1;
+	while (lo < hi) {
+		int mid = lo + (hi - lo + 1) / 2;
+		if (at[mid].col <= cursor_col)
+			lo = mid;
+		else
+			hi = mid - 1;
 	}
-
-	/* Cursor is past the end */
-	*out_col = cursor_col - line_start_col;
+	*out_line = lo;
+	*out_col = cursor_col - at[lo].col;
 }
 
 /* Find the byte-offset boundaries of a given sub-line within a wrapped row.
@@ -352,33 +564,20 @@ void cursorScreenLine(erow *row, int cursor_col, int screencols, int *out_line,
  * Returns 0 if target_subline is beyond the row's sub-lines. */
 int sublineBounds(erow *row, int screencols, int target_subline,
 		  int *start_byte, int *end_byte) {
-	int ls_col = 0, ls_byte = 0;
-
-	for (int sl = 0; sl < target_subline; sl++) {
-		int break_col, break_byte;
-		int more = wordWrapBreak(row, screencols, ls_col, ls_byte,
-					 &break_col, &break_byte);
-		if (!more) {
-			/* target_subline doesn't exist */
-			*start_byte = row->size;
-			*end_byte = row->size;
-			return 0;
-		}
-		ls_col = break_col;
-		ls_byte = break_byte;
-	}
-
-	*start_byte = ls_byte;
-
-	/* Find end of this sub-line */
-	int break_col, break_byte;
-	int more = wordWrapBreak(row, screencols, ls_col, ls_byte, &break_col,
-				 &break_byte);
-	if (!more)
+	const struct wrapPoint *at;
+	int n = rowBreaks(row, screencols, &at);
+	if (target_subline >= n) {
+		/* target_subline doesn't exist */
+		*start_byte = row->size;
 		*end_byte = row->size;
-	else
-		*end_byte = break_byte;
+		return 0;
+	}
+	if (target_subline < 0)
+		target_subline = 0;
 
+	*start_byte = at[target_subline].byte;
+	*end_byte = target_subline + 1 < n ? at[target_subline + 1].byte :
+					     row->size;
 	return 1;
 }
 
@@ -390,26 +589,18 @@ int displayColumnToByteOffset(erow *row, int screencols, int target_subline,
 	if (!row || row->size == 0)
 		return 0;
 
-	/* Phase 1: find the start of the target sub-line */
-	int ls_col = 0, ls_byte = 0;
-
-	for (int sl = 0; sl < target_subline; sl++) {
-		int break_col, break_byte;
-		int more = wordWrapBreak(row, screencols, ls_col, ls_byte,
-					 &break_col, &break_byte);
-		if (!more) {
-			/* target sub-line doesn't exist */
-			return row->size;
-		}
-		ls_col = break_col;
-		ls_byte = break_byte;
-	}
-
-	/* Find end of this sub-line for clamping */
-	int end_col, end_byte;
-	int more = wordWrapBreak(row, screencols, ls_col, ls_byte, &end_col,
-				 &end_byte);
-	int subline_end_byte = more ? end_byte : row->size;
+	/* Phase 1: find the bounds of the target sub-line */
+	const struct wrapPoint *at;
+	int n = rowBreaks(row, screencols, &at);
+	if (target_subline >= n)
+		return row->size; /* target sub-line doesn't exist */
+	if (target_subline < 0)
+		target_subline = 0;
+	int ls_col = at[target_subline].col;
+	int ls_byte = at[target_subline].byte;
+	int subline_end_byte = target_subline + 1 < n ?
+				       at[target_subline + 1].byte :
+				       row->size;
 
 	/* Phase 2: walk the sub-line to find the target column */
 	int col = 0; /* column relative to sub-line start */
@@ -4,9 +4,34 @@
 
 #include "emil.h"
 
-/* Row geometry — pure computation on erow data. */
+/* Row geometry — pure computation on erow data, cached on the row. */
 int calculateLineWidth(erow *row);
+
+/* Mark a row's text changed: drops its cached width, wrap breaks and
+ * column checkpoints. */
+void invalidateRowCache(erow *row);
+
+/* The same, for an edit that left the bytes before `at` alone: what was
+ * worked out from those alone is kept. */
+void invalidateRowCacheFrom(erow *row, int at);
+
+/* A place in a row: its display column and byte offset.  Sub-line
+ * starts and column checkpoints are both these. */
+struct wrapPoint {
+	int col;
+	int byte;
+};
+
+/* The sub-lines of row wrapped at screencols.  Returns how many there
+ * are and points *at to where each starts, at[0] being {0, 0}.  The
+ * array belongs to the row and lasts until its text changes or it is
+ * asked for another width. */
+int rowBreaks(erow *row, int screencols, const struct wrapPoint **at);
 int charsToDisplayColumn(erow *row, int char_pos);
+
+/* A character boundary at or before display column col, to walk a long
+ * row from when looking for col; {0, 0} in a row too short to index. */
+struct wrapPoint columnCheckpoint(erow *row, int col);
 int countScreenLines(erow *row, int screencols);
 
 /* Word-wrap break point for a single screen line.  Returns 1 if more
@@ -28,19 +53,10 @@ int displayColumnToByteOffset(erow *row, int screencols, int target_subline,
 
 /* A cursor over screen lines, walked forward from a starting position.
  *
- * It carries the wrap state within the current row, so advancing costs
- * one wordWrapBreak() rather than a re-walk from the row's start, and a
- * walk bounded to the window's height touches only the bytes the window
- * shows.  Advancing never asks a row for its total sub-line count,
- * which is what makes a partially visible row cost only its visible
- * part.
- *
- * That is a claim about screenWalkNext(), not about viewport arithmetic
- * generally.  Two costs sit outside it and are proportional to content
- * rather than to the window: screenWalkStart() below, and linesBack()
- * in display.c, which needs a row's LAST sub-line index and can only
- * get it by wrapping the whole row.  A frame whose cursor sits deep
- * inside one very long row therefore still scales with that depth. */
+ * Sub-lines come from rowBreaks(), so once a row's breaks are cached,
+ * starting a walk anywhere in it and advancing are lookups.  The first
+ * visit to a row that wraps still costs one pass over the whole row to
+ * fill the cache; so does the first visit after an edit or a resize. */
 struct screenWalk {
 	struct buffer *buf;
 	int screencols;
@@ -50,9 +66,8 @@ struct screenWalk {
 	int byte;    /* byte offset at the start of this sub-line */
 };
 
-/* Position a walk at (row, subline).  Costs the bytes before that
- * sub-line within its row; free when wrap is off.  A subline past the
- * row's last is clamped to it. */
+/* Position a walk at (row, subline).  A subline past the row's last is
+ * clamped to it. */
 void screenWalkStart(struct screenWalk *w, struct buffer *buf, int screencols,
 		     int row, int subline);
 